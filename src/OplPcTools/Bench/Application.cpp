@@ -0,0 +1,108 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QFile>
+#include <OplPcTools/ApplicationInfo.h>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Bench/BenchmarkSuite.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::Bench;
+
+namespace {
+
+const quint64 g_default_image_size_mib = 512;
+const int g_default_repeat = 3;
+const int g_default_ul_config_records = 200;
+
+int writeReport(const QJsonObject & _report, const QString & _output)
+{
+    QByteArray json = QJsonDocument(_report).toJson(QJsonDocument::Indented);
+    if(_output.isEmpty() || _output == "-")
+    {
+        QTextStream(stdout) << json;
+        return 0;
+    }
+    QFile file(_output);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size())
+    {
+        QTextStream(stderr) << QString("Unable to write the report into \"%1\"").arg(_output) << endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int _argc, char * _argv[])
+{
+    QCoreApplication application(_argc, _argv);
+    application.setApplicationName(APPLICATION_NAME "_bench");
+    application.setApplicationVersion(APPLICATION_VERSION);
+    application.setOrganizationName("brainstream");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("I/O benchmark suite of the OPL PC Tools core");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    QCommandLineOption work_dir_option("work-dir",
+        "Directory to generate images and libraries in. A temporary directory is used by default.", "path");
+    QCommandLineOption size_option("size",
+        QString("Size of the generated images in MiB (default: %1).").arg(g_default_image_size_mib), "MiB",
+        QString::number(g_default_image_size_mib));
+    QCommandLineOption repeat_option("repeat",
+        QString("Number of samples per benchmark (default: %1).").arg(g_default_repeat), "count",
+        QString::number(g_default_repeat));
+    QCommandLineOption records_option("ul-records",
+        QString("Number of ul.cfg records to manage (default: %1).").arg(g_default_ul_config_records), "count",
+        QString::number(g_default_ul_config_records));
+    QCommandLineOption evict_option("evict-cache",
+        "Evict the source files from the page cache before each sample (Linux only).");
+    QCommandLineOption output_option({ "o", "output" }, "Write the JSON report to the file instead of stdout.", "path");
+    parser.addOptions({ work_dir_option, size_option, repeat_option, records_option, evict_option, output_option });
+    parser.process(application);
+
+    QTemporaryDir temp_dir;
+    BenchmarkOptions options;
+    options.work_directory = parser.isSet(work_dir_option) ? parser.value(work_dir_option) : temp_dir.path();
+    options.image_size = parser.value(size_option).toULongLong() * 1048576;
+    options.repeat = qMax(1, parser.value(repeat_option).toInt());
+    options.ul_config_records = qMax(1, parser.value(records_option).toInt());
+    options.evict_page_cache = parser.isSet(evict_option);
+    if(options.work_directory.isEmpty() || !QDir().mkpath(options.work_directory))
+    {
+        QTextStream(stderr) << "Unable to create the work directory" << endl;
+        return 1;
+    }
+
+    try
+    {
+        BenchmarkSuite suite(options);
+        return writeReport(suite.run(), parser.value(output_option));
+    }
+    catch(const Exception & exception)
+    {
+        QTextStream(stderr) << exception.message() << endl;
+    }
+    return 1;
+}
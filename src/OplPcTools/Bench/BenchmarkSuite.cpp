@@ -0,0 +1,385 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QTextStream>
+#include <OplPcTools/ApplicationInfo.h>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Device.h>
+#include <OplPcTools/Iso9660DeviceSource.h>
+#include <OplPcTools/BinCueDeviceSource.h>
+#include <OplPcTools/NrgDeviceSource.h>
+#include <OplPcTools/GameCollection.h>
+#include <OplPcTools/GameSearchIndex.h>
+#include <OplPcTools/DirectoryGameInstaller.h>
+#include <OplPcTools/UlConfigGameInstaller.h>
+#include <OplPcTools/IsoRestorer.h>
+#include <OplPcTools/Bench/BenchmarkSuite.h>
+
+#ifdef __linux__
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+using namespace OplPcTools;
+using namespace OplPcTools::Bench;
+
+namespace {
+
+const QString g_game_id("SLPS_250.00");
+const QString g_game_title("OPLPCTOOLS BENCH");
+const ssize_t g_read_size = 4194304;
+const int g_device_init_iterations = 50;
+const int g_search_index_games = 50000;
+const QStringList g_search_queries = { "sl", "bench", "benhc 12", "slus_123", "42" };
+const double g_mebibyte = 1048576.0;
+
+void log(const QString & _message)
+{
+    QTextStream(stderr) << _message << endl;
+}
+
+inline double toSeconds(qint64 _nsecs)
+{
+    return _nsecs / 1000000000.0;
+}
+
+QString ulConfigGameId(int _index)
+{
+    return QString("SLUS_%1.%2").arg(_index / 100, 3, 10, QChar('0')).arg(_index % 100, 2, 10, QChar('0'));
+}
+
+} // namespace
+
+const QStringList BenchmarkSuite::formats = { "iso", "bin", "nrg" };
+
+BenchmarkSuite::BenchmarkSuite(const BenchmarkOptions & _options) :
+    m_options(_options),
+    m_work_dir(_options.work_directory),
+    m_generator(g_game_id, g_game_title, _options.image_size)
+{
+}
+
+QJsonObject BenchmarkSuite::run()
+{
+    m_results = QJsonArray();
+    prepareImages();
+    for(const QString & format : formats)
+        benchmarkSourceRead(format);
+    for(const QString & format : formats)
+        benchmarkDeviceInit(format);
+    benchmarkDirectoryInstaller();
+    benchmarkUlConfigInstaller();
+    benchmarkIsoRestorer();
+    benchmarkUlConfig();
+    benchmarkSearchIndex();
+    QJsonObject system;
+    system["os"] = QSysInfo::prettyProductName();
+    system["kernel"] = QSysInfo::kernelVersion();
+    system["cpu_architecture"] = QSysInfo::currentCpuArchitecture();
+    system["qt"] = QString(qVersion());
+    QJsonObject options;
+    options["work_directory"] = m_work_dir.absolutePath();
+    options["image_size"] = static_cast<double>(m_generator.size());
+    options["repeat"] = m_options.repeat;
+    options["ul_config_records"] = m_options.ul_config_records;
+    options["evict_page_cache"] = m_options.evict_page_cache;
+    QJsonObject report;
+    report["version"] = APPLICATION_VERSION;
+    report["created"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["system"] = system;
+    report["options"] = options;
+    report["results"] = m_results;
+    return report;
+}
+
+void BenchmarkSuite::prepareImages()
+{
+    log(QString("Generating %1 byte images in \"%2\"").arg(m_generator.size()).arg(m_work_dir.absolutePath()));
+    QString iso_path = m_work_dir.absoluteFilePath("bench.iso");
+    QString bin_path = m_work_dir.absoluteFilePath("bench.bin");
+    QString nrg_path = m_work_dir.absoluteFilePath("bench.nrg");
+    m_generator.writeIso(iso_path);
+    m_generator.writeBinCue(bin_path, m_work_dir.absoluteFilePath("bench.cue"));
+    m_generator.writeNrg(nrg_path);
+    m_images["iso"] = iso_path;
+    m_images["bin"] = bin_path;
+    m_images["nrg"] = nrg_path;
+}
+
+QSharedPointer<DeviceSource> BenchmarkSuite::createSource(const QString & _format) const
+{
+    const QString path = m_images.value(_format);
+    if(_format == "bin")
+        return QSharedPointer<DeviceSource>(new BinCueDeviceSource(path));
+    if(_format == "nrg")
+        return QSharedPointer<DeviceSource>(new NrgDeviceSource(path));
+    return QSharedPointer<DeviceSource>(new Iso9660DeviceSource(path));
+}
+
+void BenchmarkSuite::evictFromPageCache(const QString & _filepath) const
+{
+    if(!m_options.evict_page_cache)
+        return;
+#ifdef __linux__
+    int fd = ::open(QFile::encodeName(_filepath).constData(), O_RDONLY);
+    if(fd < 0)
+        return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    Q_UNUSED(_filepath)
+#endif
+}
+
+void BenchmarkSuite::prepareLibrary(QDir & _library_dir, const QString & _name) const
+{
+    QDir dir(m_work_dir.absoluteFilePath(_name));
+    dir.removeRecursively();
+    if(!m_work_dir.mkpath(_name))
+        throw IOException(QObject::tr("Unable to create directory: \"%1\"").arg(dir.absolutePath()));
+    _library_dir = dir;
+}
+
+void BenchmarkSuite::benchmarkSourceRead(const QString & _format)
+{
+    log(QString("Reading the %1 source").arg(_format));
+    QSharedPointer<DeviceSource> source = createSource(_format);
+    QByteArray buffer(g_read_size, Qt::Uninitialized);
+    QVector<double> samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        evictFromPageCache(source->filepath());
+        QElapsedTimer timer;
+        timer.start();
+        if(!source->open() || !source->seek(0))
+            throw IOException(QObject::tr("Unable to open device to read: \"%1\"").arg(source->filepath()));
+        quint64 total_bytes = 0;
+        for(;;)
+        {
+            qint64 read_bytes = source->read(buffer);
+            if(read_bytes < 0)
+                throw IOException(QObject::tr("An error occurred during reading the source medium"));
+            total_bytes += read_bytes;
+            if(read_bytes < g_read_size)
+                break;
+        }
+        source->close();
+        samples.append(total_bytes / g_mebibyte / toSeconds(timer.nsecsElapsed()));
+    }
+    addResult(QString("source.read.%1").arg(_format), "MiB/s", samples);
+}
+
+void BenchmarkSuite::benchmarkDeviceInit(const QString & _format)
+{
+    log(QString("Probing the %1 device").arg(_format));
+    QVector<double> samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        for(int iteration = 0; iteration < g_device_init_iterations; ++iteration)
+        {
+            Device device(createSource(_format));
+            if(!device.init())
+                throw ValidationException(QObject::tr("Unable to initialize device: \"%1\"").arg(device.filepath()));
+        }
+        samples.append(timer.nsecsElapsed() / 1000.0 / g_device_init_iterations);
+    }
+    addResult(QString("device.init.%1").arg(_format), "us", samples);
+}
+
+void BenchmarkSuite::benchmarkDirectoryInstaller()
+{
+    log("Installing with the directory installer");
+    QDir library_dir;
+    prepareLibrary(library_dir, "library-directory");
+    GameCollection collection;
+    collection.load(library_dir);
+    QVector<double> samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        evictFromPageCache(m_images["iso"]);
+        Device device(createSource("iso"));
+        if(!device.init())
+            throw ValidationException(QObject::tr("Unable to initialize device: \"%1\"").arg(device.filepath()));
+        DirectoryGameInstaller installer(device, collection);
+        QElapsedTimer timer;
+        timer.start();
+        if(!installer.install())
+            throw Exception(QObject::tr("Installation was interrupted"));
+        samples.append(device.size() / g_mebibyte / toSeconds(timer.nsecsElapsed()));
+        collection.deleteGame(*collection.findGame(g_game_id));
+    }
+    addResult("install.directory", "MiB/s", samples);
+    library_dir.removeRecursively();
+}
+
+void BenchmarkSuite::benchmarkUlConfigInstaller()
+{
+    log("Installing with the ul.cfg installer");
+    QDir library_dir;
+    prepareLibrary(library_dir, "library-ulconfig");
+    GameCollection collection;
+    collection.load(library_dir);
+    QVector<double> samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        evictFromPageCache(m_images["iso"]);
+        Device device(createSource("iso"));
+        if(!device.init())
+            throw ValidationException(QObject::tr("Unable to initialize device: \"%1\"").arg(device.filepath()));
+        UlConfigGameInstaller installer(device, collection);
+        QElapsedTimer timer;
+        timer.start();
+        if(!installer.install())
+            throw Exception(QObject::tr("Installation was interrupted"));
+        samples.append(device.size() / g_mebibyte / toSeconds(timer.nsecsElapsed()));
+        collection.deleteGame(*collection.findGame(g_game_id));
+    }
+    addResult("install.ulconfig", "MiB/s", samples);
+    library_dir.removeRecursively();
+}
+
+void BenchmarkSuite::benchmarkIsoRestorer()
+{
+    log("Restoring the ISO from the ul.cfg installation");
+    QDir library_dir;
+    prepareLibrary(library_dir, "library-restore");
+    GameCollection collection;
+    collection.load(library_dir);
+    {
+        Device device(createSource("iso"));
+        if(!device.init())
+            throw ValidationException(QObject::tr("Unable to initialize device: \"%1\"").arg(device.filepath()));
+        UlConfigGameInstaller installer(device, collection);
+        installer.install();
+    }
+    const QSharedPointer<const Game> game = collection.findGame(g_game_id);
+    const QString iso_path = m_work_dir.absoluteFilePath("restored.iso");
+    QVector<double> samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        for(quint8 part = 0; part < game->partCount(); ++part)
+            evictFromPageCache(library_dir.absoluteFilePath(
+                UlConfigGameStorage::makePartFilename(game->id(), game->title(), part)));
+        IsoRestorer restorer(*game, library_dir.absolutePath(), iso_path);
+        QElapsedTimer timer;
+        timer.start();
+        if(!restorer.restore())
+            throw Exception(QObject::tr("Restoring was interrupted"));
+        samples.append(QFileInfo(iso_path).size() / g_mebibyte / toSeconds(timer.nsecsElapsed()));
+        QFile::remove(iso_path);
+    }
+    addResult("restore.ulconfig", "MiB/s", samples);
+    library_dir.removeRecursively();
+}
+
+void BenchmarkSuite::benchmarkUlConfig()
+{
+    log(QString("Managing %1 ul.cfg records").arg(m_options.ul_config_records));
+    QVector<double> register_samples, load_samples, rename_samples, delete_samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        QDir library_dir;
+        prepareLibrary(library_dir, "library-ulcfg");
+        GameCollection collection;
+        collection.load(library_dir);
+        QElapsedTimer timer;
+        timer.start();
+        for(int record = 0; record < m_options.ul_config_records; ++record)
+        {
+            Game game(ulConfigGameId(record), GameInstallationType::UlConfig);
+            game.setTitle(QString("BENCH %1").arg(record));
+            game.setMediaType(MediaType::DVD);
+            collection.addGame(game);
+        }
+        register_samples.append(timer.nsecsElapsed() / 1000.0 / m_options.ul_config_records);
+        timer.restart();
+        GameCollection reloaded_collection;
+        reloaded_collection.load(library_dir);
+        load_samples.append(timer.nsecsElapsed() / 1000.0);
+        timer.restart();
+        for(int record = 0; record < m_options.ul_config_records; ++record)
+            collection.renameGame(*collection.findGame(ulConfigGameId(record)), QString("RENAMED %1").arg(record));
+        rename_samples.append(timer.nsecsElapsed() / 1000.0 / m_options.ul_config_records);
+        timer.restart();
+        for(int record = 0; record < m_options.ul_config_records; ++record)
+            collection.deleteGame(*collection.findGame(ulConfigGameId(record)));
+        delete_samples.append(timer.nsecsElapsed() / 1000.0 / m_options.ul_config_records);
+        library_dir.removeRecursively();
+    }
+    addResult("ulcfg.register", "us/op", register_samples);
+    addResult("ulcfg.load", "us", load_samples);
+    addResult("ulcfg.rename", "us/op", rename_samples);
+    addResult("ulcfg.delete", "us/op", delete_samples);
+}
+
+void BenchmarkSuite::benchmarkSearchIndex()
+{
+    log(QString("Searching %1 games").arg(g_search_index_games));
+    QVector<double> build_samples, search_samples;
+    for(int i = 0; i < m_options.repeat; ++i)
+    {
+        GameSearchIndex index;
+        QElapsedTimer timer;
+        timer.start();
+        for(int game = 0; game < g_search_index_games; ++game)
+            index.insert(ulConfigGameId(game), QString("BENCH GAME %1").arg(game));
+        build_samples.append(timer.nsecsElapsed() / 1000000.0);
+        for(const QString & query : g_search_queries)
+        {
+            timer.restart();
+            index.search(query);
+            search_samples.append(timer.nsecsElapsed() / 1000.0);
+        }
+    }
+    addResult("search.build", "ms", build_samples);
+    addResult("search.query", "us", search_samples);
+}
+
+void BenchmarkSuite::addResult(const QString & _name, const QString & _unit, const QVector<double> & _samples)
+{
+    if(_samples.isEmpty())
+        return;
+    QVector<double> sorted = _samples;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0;
+    QJsonArray samples;
+    for(double sample : _samples)
+    {
+        sum += sample;
+        samples.append(sample);
+    }
+    const int middle = sorted.size() / 2;
+    double median = sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+    QJsonObject result;
+    result["name"] = _name;
+    result["unit"] = _unit;
+    result["min"] = sorted.first();
+    result["max"] = sorted.last();
+    result["mean"] = sum / sorted.size();
+    result["median"] = median;
+    result["samples"] = samples;
+    m_results.append(result);
+    log(QString("  %1: %2 %3 (median)").arg(_name).arg(median, 0, 'f', 2).arg(_unit));
+}
@@ -0,0 +1,80 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_BENCH_BENCHMARKSUITE__
+#define __OPLPCTOOLS_BENCH_BENCHMARKSUITE__
+
+#include <QDir>
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <OplPcTools/DeviceSource.h>
+#include <OplPcTools/Bench/ImageGenerator.h>
+
+namespace OplPcTools {
+namespace Bench {
+
+struct BenchmarkOptions
+{
+    QString work_directory;
+    quint64 image_size;
+    int repeat;
+    int ul_config_records;
+    bool evict_page_cache;
+};
+
+class BenchmarkSuite final
+{
+    Q_DISABLE_COPY(BenchmarkSuite)
+
+public:
+    explicit BenchmarkSuite(const BenchmarkOptions & _options);
+    QJsonObject run();
+
+private:
+    void prepareImages();
+    void benchmarkSourceRead(const QString & _format);
+    void benchmarkDeviceInit(const QString & _format);
+    void benchmarkDirectoryInstaller();
+    void benchmarkUlConfigInstaller();
+    void benchmarkIsoRestorer();
+    void benchmarkUlConfig();
+    void benchmarkSearchIndex();
+    QSharedPointer<DeviceSource> createSource(const QString & _format) const;
+    void prepareLibrary(QDir & _library_dir, const QString & _name) const;
+    void evictFromPageCache(const QString & _filepath) const;
+    void addResult(const QString & _name, const QString & _unit, const QVector<double> & _samples);
+
+public:
+    static const QStringList formats;
+
+private:
+    BenchmarkOptions m_options;
+    QDir m_work_dir;
+    ImageGenerator m_generator;
+    QMap<QString, QString> m_images;
+    QJsonArray m_results;
+};
+
+} // namespace Bench
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_BENCH_BENCHMARKSUITE__
@@ -0,0 +1,341 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <cstring>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Bench/ImageGenerator.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::Bench;
+
+namespace {
+
+const quint32 g_pvd_sector = 16;
+const quint32 g_terminator_sector = 17;
+const quint32 g_l_path_table_sector = 18;
+const quint32 g_m_path_table_sector = 19;
+const quint32 g_root_directory_sector = 20;
+const quint32 g_system_config_sector = 21;
+const quint32 g_first_data_sector = 22;
+const quint32 g_max_data_file_sectors = 524288; // 1 GiB per filler file
+const quint32 g_path_table_size = 10;
+const quint32 g_bin_sector_size = 2352;
+const quint32 g_write_batch_size = 4194304;
+
+void putLE16(char * _dest, quint16 _value)
+{
+    _dest[0] = static_cast<char>(_value & 0xFF);
+    _dest[1] = static_cast<char>((_value >> 8) & 0xFF);
+}
+
+void putBE16(char * _dest, quint16 _value)
+{
+    _dest[0] = static_cast<char>((_value >> 8) & 0xFF);
+    _dest[1] = static_cast<char>(_value & 0xFF);
+}
+
+void putLE32(char * _dest, quint32 _value)
+{
+    for(int i = 0; i < 4; ++i)
+        _dest[i] = static_cast<char>((_value >> (i * 8)) & 0xFF);
+}
+
+void putBE32(char * _dest, quint32 _value)
+{
+    for(int i = 0; i < 4; ++i)
+        _dest[3 - i] = static_cast<char>((_value >> (i * 8)) & 0xFF);
+}
+
+void putBE64(char * _dest, quint64 _value)
+{
+    for(int i = 0; i < 8; ++i)
+        _dest[7 - i] = static_cast<char>((_value >> (i * 8)) & 0xFF);
+}
+
+void putBoth16(char * _dest, quint16 _value)
+{
+    putLE16(_dest, _value);
+    putBE16(_dest + 2, _value);
+}
+
+void putBoth32(char * _dest, quint32 _value)
+{
+    putLE32(_dest, _value);
+    putBE32(_dest + 4, _value);
+}
+
+void putPadded(char * _dest, const QByteArray & _value, int _length)
+{
+    std::memset(_dest, ' ', _length);
+    std::memcpy(_dest, _value.constData(), qMin(_value.size(), _length));
+}
+
+QByteArray makeDirectoryRecord(quint32 _extent, quint32 _length, bool _is_directory, const QByteArray & _name)
+{
+    const int length = 33 + _name.size() + (_name.size() % 2 == 0 ? 1 : 0);
+    QByteArray record(length, '\0');
+    char * data = record.data();
+    data[0] = static_cast<char>(length);
+    putBoth32(data + 2, _extent);
+    putBoth32(data + 10, _length);
+    QDate today = QDate::currentDate();
+    data[18] = static_cast<char>(today.year() - 1900);
+    data[19] = static_cast<char>(today.month());
+    data[20] = static_cast<char>(today.day());
+    data[25] = _is_directory ? 0x02 : 0x00;
+    putBoth16(data + 28, 1);
+    data[32] = static_cast<char>(_name.size());
+    std::memcpy(data + 33, _name.constData(), _name.size());
+    return record;
+}
+
+QByteArray makePvdDate()
+{
+    return QDateTime::currentDateTimeUtc().toString("yyyyMMddHHmmss00").toLatin1().append('\0');
+}
+
+inline quint32 dataFileCount(quint32 _data_sectors)
+{
+    return (_data_sectors + g_max_data_file_sectors - 1) / g_max_data_file_sectors;
+}
+
+inline quint8 toBcd(quint32 _value)
+{
+    return static_cast<quint8>(((_value / 10) << 4) | (_value % 10));
+}
+
+class BatchWriter final
+{
+    Q_DISABLE_COPY(BatchWriter)
+
+public:
+    explicit BatchWriter(const QString & _filepath) :
+        m_file(_filepath)
+    {
+        if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            throw IOException(QObject::tr("Unable to open file to write: \"%1\"").arg(_filepath));
+        m_buffer.reserve(g_write_batch_size);
+    }
+
+    void write(const char * _data, int _size)
+    {
+        m_buffer.append(_data, _size);
+        if(static_cast<quint32>(m_buffer.size()) >= g_write_batch_size)
+            flush();
+    }
+
+    void write(const QByteArray & _data)
+    {
+        write(_data.constData(), _data.size());
+    }
+
+    void flush()
+    {
+        if(m_file.write(m_buffer) != m_buffer.size())
+            throw IOException(QObject::tr("Unable to write a data into the file: \"%1\"").arg(m_file.fileName()));
+        m_buffer.clear();
+    }
+
+    quint64 position()
+    {
+        return static_cast<quint64>(m_file.pos()) + m_buffer.size();
+    }
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+};
+
+} // namespace
+
+ImageGenerator::ImageGenerator(const QString & _game_id, const QString & _title, quint64 _size) :
+    m_game_id(_game_id),
+    m_title(_title)
+{
+    quint64 sectors = (_size + sector_size - 1) / sector_size;
+    if(sectors <= g_first_data_sector)
+        sectors = g_first_data_sector + 1;
+    m_sector_count = static_cast<quint32>(sectors);
+    const int max_records = (sector_size - 2 * 34 - 46) / 46;
+    if(dataFileCount(m_sector_count - g_first_data_sector) > static_cast<quint32>(max_records))
+        throw ValidationException(QObject::tr("Image size is too large: %1 bytes").arg(_size));
+}
+
+QByteArray ImageGenerator::makeSystemConfig() const
+{
+    return QString("BOOT2 = cdrom0:\\%1;1\r\nVER = 1.00\r\nVMODE = NTSC\r\n").arg(m_game_id).toLatin1();
+}
+
+QByteArray ImageGenerator::makeRootDirectory() const
+{
+    QByteArray directory;
+    directory.append(makeDirectoryRecord(g_root_directory_sector, sector_size, true, QByteArray(1, '\0')));
+    directory.append(makeDirectoryRecord(g_root_directory_sector, sector_size, true, QByteArray(1, '\1')));
+    directory.append(makeDirectoryRecord(g_system_config_sector, makeSystemConfig().size(), false, "SYSTEM.CNF;1"));
+    const quint32 data_sectors = m_sector_count - g_first_data_sector;
+    for(quint32 file = 0, extent = g_first_data_sector; file < dataFileCount(data_sectors); ++file)
+    {
+        quint32 file_sectors = qMin(g_max_data_file_sectors, m_sector_count - extent);
+        QByteArray name = QString("DATA%1.BIN;1").arg(file, 2, 10, QChar('0')).toLatin1();
+        directory.append(makeDirectoryRecord(extent, file_sectors * sector_size, false, name));
+        extent += file_sectors;
+    }
+    directory.resize(sector_size);
+    return directory;
+}
+
+QByteArray ImageGenerator::makePrimaryVolumeDescriptor() const
+{
+    QByteArray pvd(sector_size, '\0');
+    char * data = pvd.data();
+    data[0] = 1;
+    std::memcpy(data + 1, "CD001", 5);
+    data[6] = 1;
+    putPadded(data + 8, "PLAYSTATION", 32);
+    putPadded(data + 40, m_title.toLatin1(), 32);
+    putBoth32(data + 80, m_sector_count);
+    putBoth16(data + 120, 1);
+    putBoth16(data + 124, 1);
+    putBoth16(data + 128, sector_size);
+    putBoth32(data + 132, g_path_table_size);
+    putLE32(data + 140, g_l_path_table_sector);
+    putBE32(data + 148, g_m_path_table_sector);
+    QByteArray root = makeDirectoryRecord(g_root_directory_sector, sector_size, true, QByteArray(1, '\0'));
+    std::memcpy(data + 156, root.constData(), root.size());
+    putPadded(data + 190, QByteArray(), 128);
+    putPadded(data + 318, QByteArray(), 128);
+    putPadded(data + 446, QByteArray(), 128);
+    putPadded(data + 574, "OPLPCTOOLS_BENCH", 128);
+    putPadded(data + 702, QByteArray(), 111);
+    QByteArray date = makePvdDate();
+    std::memcpy(data + 813, date.constData(), 17);
+    std::memcpy(data + 830, date.constData(), 17);
+    std::memcpy(data + 847, "0000000000000000", 16);
+    std::memcpy(data + 864, "0000000000000000", 16);
+    data[881] = 1;
+    return pvd;
+}
+
+void ImageGenerator::generate(std::function<void(const char *)> _sector_handler) const
+{
+    QByteArray sector(sector_size, '\0');
+    for(quint32 index = 0; index < g_pvd_sector; ++index)
+        _sector_handler(sector.constData());
+    _sector_handler(makePrimaryVolumeDescriptor().constData());
+    sector[0] = static_cast<char>(0xFF);
+    std::memcpy(sector.data() + 1, "CD001", 5);
+    sector[6] = 1;
+    _sector_handler(sector.constData());
+    sector.fill('\0');
+    sector[0] = 1;
+    putLE32(sector.data() + 2, g_root_directory_sector);
+    putLE16(sector.data() + 6, 1);
+    _sector_handler(sector.constData());
+    putBE32(sector.data() + 2, g_root_directory_sector);
+    putBE16(sector.data() + 6, 1);
+    _sector_handler(sector.constData());
+    _sector_handler(makeRootDirectory().constData());
+    sector.fill('\0');
+    QByteArray config = makeSystemConfig();
+    std::memcpy(sector.data(), config.constData(), config.size());
+    _sector_handler(sector.constData());
+    // Pseudo-random filler keeps compressing and deduplicating file systems from distorting the results.
+    quint64 state = 0x9E3779B97F4A7C15ull;
+    quint64 * words = reinterpret_cast<quint64 *>(sector.data());
+    for(quint32 index = g_first_data_sector; index < m_sector_count; ++index)
+    {
+        for(quint32 word = 0; word < sector_size / sizeof(quint64); ++word)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            words[word] = state;
+        }
+        _sector_handler(sector.constData());
+    }
+}
+
+void ImageGenerator::writeIso(const QString & _filepath) const
+{
+    BatchWriter writer(_filepath);
+    generate([&writer](const char * _sector) {
+        writer.write(_sector, sector_size);
+    });
+    writer.flush();
+}
+
+void ImageGenerator::writeBinCue(const QString & _bin_filepath, const QString & _cue_filepath) const
+{
+    BatchWriter writer(_bin_filepath);
+    QByteArray raw_sector(g_bin_sector_size, '\0');
+    char * raw = raw_sector.data();
+    std::memset(raw + 1, 0xFF, 10);
+    raw[15] = 2; // Mode 2
+    raw[18] = raw[22] = 0x08; // Form 1 data sub-header
+    quint32 address = 150; // Two-second pre-gap
+    generate([&](const char * _sector) {
+        raw[12] = static_cast<char>(toBcd(address / 4500));
+        raw[13] = static_cast<char>(toBcd((address / 75) % 60));
+        raw[14] = static_cast<char>(toBcd(address % 75));
+        std::memcpy(raw + 24, _sector, sector_size);
+        writer.write(raw_sector);
+        ++address;
+    });
+    writer.flush();
+    QFile cue(_cue_filepath);
+    if(!cue.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw IOException(QObject::tr("Unable to open file to write: \"%1\"").arg(_cue_filepath));
+    QByteArray sheet = QString("FILE \"%1\" BINARY\r\n  TRACK 01 MODE2/2352\r\n    INDEX 01 00:00:00\r\n")
+        .arg(QFileInfo(_bin_filepath).fileName()).toUtf8();
+    if(cue.write(sheet) != sheet.size())
+        throw IOException(QObject::tr("Unable to write a data into the file: \"%1\"").arg(_cue_filepath));
+}
+
+void ImageGenerator::writeNrg(const QString & _filepath) const
+{
+    BatchWriter writer(_filepath);
+    generate([&writer](const char * _sector) {
+        writer.write(_sector, sector_size);
+    });
+    const quint64 daox_offset = writer.position();
+    const quint32 daox_header_size = 22;
+    const quint32 daox_track_size = 42;
+    QByteArray daox(8 + daox_header_size + daox_track_size, '\0');
+    char * data = daox.data();
+    std::memcpy(data, "DAOX", 4);
+    putBE32(data + 4, daox_header_size + daox_track_size);
+    putBE32(data + 8, daox_header_size + daox_track_size);
+    data[28] = 1; // First track
+    data[29] = 1; // Last track
+    char * track = data + 30;
+    putBE16(track + 12, sector_size);
+    putBE64(track + 26, 0);
+    putBE64(track + 34, size());
+    writer.write(daox);
+    QByteArray end(8, '\0');
+    std::memcpy(end.data(), "END!", 4);
+    writer.write(end);
+    QByteArray footer(12, '\0');
+    std::memcpy(footer.data(), "NER5", 4);
+    putBE64(footer.data() + 4, daox_offset);
+    writer.write(footer);
+    writer.flush();
+}
@@ -0,0 +1,75 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_BENCH_IMAGEGENERATOR__
+#define __OPLPCTOOLS_BENCH_IMAGEGENERATOR__
+
+#include <functional>
+#include <QString>
+#include <QByteArray>
+
+namespace OplPcTools {
+namespace Bench {
+
+// Builds minimal but valid PS2-style ISO 9660 images: a primary volume descriptor with the PLAYSTATION
+// system identifier, path tables and a root directory holding SYSTEM.CNF and a filler file up to the requested size.
+class ImageGenerator final
+{
+public:
+    ImageGenerator(const QString & _game_id, const QString & _title, quint64 _size);
+    inline const QString & gameId() const;
+    inline const QString & title() const;
+    inline quint64 size() const;
+    void writeIso(const QString & _filepath) const;
+    void writeBinCue(const QString & _bin_filepath, const QString & _cue_filepath) const;
+    void writeNrg(const QString & _filepath) const;
+
+public:
+    static const quint32 sector_size = 2048;
+
+private:
+    void generate(std::function<void(const char *)> _sector_handler) const;
+    QByteArray makePrimaryVolumeDescriptor() const;
+    QByteArray makeRootDirectory() const;
+    QByteArray makeSystemConfig() const;
+
+private:
+    QString m_game_id;
+    QString m_title;
+    quint32 m_sector_count;
+};
+
+const QString & ImageGenerator::gameId() const
+{
+    return m_game_id;
+}
+
+const QString & ImageGenerator::title() const
+{
+    return m_title;
+}
+
+quint64 ImageGenerator::size() const
+{
+    return static_cast<quint64>(m_sector_count) * sector_size;
+}
+
+} // namespace Bench
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_BENCH_IMAGEGENERATOR__
@@ -0,0 +1,103 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QMap>
+#include <OplPcTools/ApplicationInfo.h>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Cli/Commands.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::Cli;
+
+namespace {
+
+using Command = int (*)(const QStringList &);
+
+const QMap<QString, Command> & commands()
+{
+    static const QMap<QString, Command> commands {
+        { "list", listGames },
+        { "install", installGames },
+        { "restore", restoreGames },
+        { "rename", renameGame },
+        { "delete", deleteGames },
+        { "verify", verifyGames },
+        { "import-art", importArts },
+        { "optimize-art", optimizeArts },
+        { "duplicates", findDuplicates }
+    };
+    return commands;
+}
+
+int printUsage(const QString & _program)
+{
+    QTextStream(stderr) <<
+        "Usage: " << _program << " <command> --library <path> [options]\n\n"
+        "Commands:\n"
+        "  list                      Print the games of the library\n"
+        "  install <image>...        Install disc images (--jobs, --type, --media, --move, --rename, --trim,\n"
+        "                            --strip-dummies, --progress)\n"
+        "  restore <id>...           Restore ISO images of the ul.cfg games (--output)\n"
+        "  rename <id> <title>       Rename the game\n"
+        "  delete <id>...            Delete the games with their pictures (--keep-art)\n"
+        "  verify [<id>...]          Check the game files and images (--read)\n"
+        "  import-art <path>...      Import pictures from files and directories (--all)\n"
+        "  optimize-art              Scale and recompress the pictures of the library (--dry-run)\n"
+        "  duplicates                Find the games installed more than once\n\n"
+        "Run '" << _program << " <command> --help' for the command options.\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int _argc, char * _argv[])
+{
+    QCoreApplication application(_argc, _argv);
+    // Share the settings with the GUI
+    application.setApplicationName(APPLICATION_NAME);
+    application.setApplicationVersion(APPLICATION_VERSION);
+    application.setOrganizationName("brainstream");
+    QStringList arguments = application.arguments();
+    const QString program = arguments.isEmpty() ? QString(APPLICATION_NAME "-cli") : arguments.takeFirst();
+    if(arguments.isEmpty())
+        return printUsage(program);
+    const QString command_name = arguments.takeFirst();
+    if(command_name == "--version" || command_name == "-v")
+    {
+        QTextStream(stdout) << APPLICATION_VERSION << endl;
+        return 0;
+    }
+    Command command = commands().value(command_name, nullptr);
+    if(!command)
+        return printUsage(program);
+    try
+    {
+        return command(arguments);
+    }
+    catch(const Exception & exception)
+    {
+        QJsonObject error;
+        error["error"] = exception.message();
+        QTextStream(stdout) << QJsonDocument(error).toJson(QJsonDocument::Indented);
+    }
+    return 1;
+}
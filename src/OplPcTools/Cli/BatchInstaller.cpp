@@ -0,0 +1,329 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/DeviceSourceFactory.h>
+#include <OplPcTools/DummyStrippingDeviceSource.h>
+#include <OplPcTools/DirectoryGameInstaller.h>
+#include <OplPcTools/UlConfigGameInstaller.h>
+#include <OplPcTools/Cli/BatchInstaller.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::Cli;
+
+namespace {
+
+const int g_progress_interval = 1000;
+
+QStringList findDummyFiles(DeviceSource & _source)
+{
+    QStringList filepaths;
+    for(const Iso9660File & file : DummyStrippingDeviceSource::listFiles(_source))
+    {
+        if(DummyStrippingDeviceSource::isDummyFile(file))
+            filepaths.append(file.path);
+    }
+    return filepaths;
+}
+
+} // namespace
+
+class BatchInstaller::Task final
+{
+    Q_DISABLE_COPY(Task)
+
+public:
+    explicit Task(const QString & _filepath);
+    ~Task();
+    bool prepare(GameCollection & _collection, const InstallationOptions & _options);
+    void start(const IoPolicy & _io_policy, QSemaphore & _finished_tasks);
+    inline bool isDone() const;
+    inline const InstallationResult & result() const;
+    inline const GameInstaller * installer() const;
+    inline quint64 deviceSize() const;
+    inline const QString & sourceStorageDeviceId() const;
+    inline const QString & destinationStorageDeviceId() const;
+    inline void setDestinationStorageDeviceId(const QString & _id);
+
+private:
+    bool reject(const QString & _error);
+    void install();
+
+private:
+    QSharedPointer<Device> m_device_ptr;
+    GameInstaller * mp_installer;
+    JobPointer m_job_ptr;
+    InstallationResult m_result;
+    quint64 m_source_size;
+    QString m_source_storage_device_id;
+    QString m_destination_storage_device_id;
+    QAtomicInt m_is_done;
+};
+
+BatchInstaller::Task::Task(const QString & _filepath) :
+    mp_installer(nullptr),
+    m_is_done(0)
+{
+    const QFileInfo file_info(_filepath);
+    m_result.source = file_info.absoluteFilePath();
+    m_result.bytes = 0;
+    m_result.elapsed_ms = 0;
+    m_result.is_installed = false;
+    m_source_size = static_cast<quint64>(file_info.size());
+    m_source_storage_device_id = storageDeviceId(m_result.source);
+}
+
+BatchInstaller::Task::~Task()
+{
+    if(m_job_ptr)
+        m_job_ptr->wait();
+    delete mp_installer;
+}
+
+bool BatchInstaller::Task::prepare(GameCollection & _collection, const InstallationOptions & _options)
+{
+    QSharedPointer<DeviceSource> source = createDeviceSource(m_result.source);
+    if(!source)
+        return reject(QObject::tr("Unsupported file type: \"%1\"").arg(m_result.source));
+    m_device_ptr.reset(new Device(source));
+    if(!m_device_ptr->init())
+        return reject(QObject::tr("Invalid file format"));
+    const QStringList dummy_filepaths = _options.strip_dummies ? findDummyFiles(*source) : QStringList();
+    if(!dummy_filepaths.isEmpty())
+    {
+        m_device_ptr.reset(new Device(QSharedPointer<DeviceSource>(new DummyStrippingDeviceSource(source, dummy_filepaths))));
+        if(!m_device_ptr->init())
+            return reject(QObject::tr("Unable to rebuild the image without the dummy files"));
+    }
+    m_device_ptr->setTitle(QFileInfo(m_result.source).completeBaseName());
+    if(_options.media_type != MediaType::Unknown)
+        m_device_ptr->setMediaType(_options.media_type);
+    m_device_ptr->enableTrimming(_options.trim);
+    m_result.game_id = m_device_ptr->gameId();
+    m_result.title = m_device_ptr->title();
+    if(_options.installation_type == GameInstallationType::UlConfig)
+    {
+        mp_installer = new UlConfigGameInstaller(*m_device_ptr, _collection);
+    }
+    else
+    {
+        DirectoryGameInstaller * installer = new DirectoryGameInstaller(*m_device_ptr, _collection);
+        installer->setOptionMoveFile(_options.move_file);
+        installer->setOptionRenameFile(_options.rename_file);
+        mp_installer = installer;
+    }
+    return true;
+}
+
+// The task is done without being started, its image is not kept open
+bool BatchInstaller::Task::reject(const QString & _error)
+{
+    m_result.error = _error;
+    m_device_ptr.reset();
+    m_is_done.storeRelease(1);
+    return false;
+}
+
+void BatchInstaller::Task::start(const IoPolicy & _io_policy, QSemaphore & _finished_tasks)
+{
+    QSemaphore * finished_tasks = &_finished_tasks;
+    m_job_ptr = Job::create(JobKind::Io, [this, finished_tasks]() {
+        install();
+        m_is_done.storeRelease(1);
+        finished_tasks->release();
+    });
+    m_job_ptr->setPriority(JobPriority::High);
+    m_job_ptr->setIoPolicy(_io_policy);
+    JobScheduler::instance().submit(m_job_ptr);
+}
+
+void BatchInstaller::Task::install()
+{
+    QElapsedTimer timer;
+    timer.start();
+    try
+    {
+        m_result.is_installed = mp_installer->install();
+        if(!m_result.is_installed)
+            m_result.error = QObject::tr("Installation was canceled");
+    }
+    catch(const Exception & exception)
+    {
+        m_result.error = exception.message();
+    }
+    catch(...)
+    {
+        m_result.error = QObject::tr("An unknown error has occurred");
+    }
+    m_result.elapsed_ms = timer.elapsed();
+    m_result.bytes = mp_installer->transferProgress().doneBytes();
+    m_device_ptr->close();
+}
+
+bool BatchInstaller::Task::isDone() const
+{
+    return m_is_done.loadAcquire() != 0;
+}
+
+const InstallationResult & BatchInstaller::Task::result() const
+{
+    return m_result;
+}
+
+const GameInstaller * BatchInstaller::Task::installer() const
+{
+    return mp_installer;
+}
+
+// Until the task is prepared the size of the file stands for the size of the image
+quint64 BatchInstaller::Task::deviceSize() const
+{
+    return m_device_ptr && m_device_ptr->isInitialized() ? m_device_ptr->size() : m_source_size;
+}
+
+const QString & BatchInstaller::Task::sourceStorageDeviceId() const
+{
+    return m_source_storage_device_id;
+}
+
+const QString & BatchInstaller::Task::destinationStorageDeviceId() const
+{
+    return m_destination_storage_device_id;
+}
+
+void BatchInstaller::Task::setDestinationStorageDeviceId(const QString & _id)
+{
+    m_destination_storage_device_id = _id;
+}
+
+BatchInstaller::BatchInstaller(GameCollection & _collection, const InstallationOptions & _options) :
+    mr_collection(_collection),
+    m_options(_options),
+    m_is_progress_reporting_enabled(false)
+{
+}
+
+BatchInstaller::~BatchInstaller()
+{
+    qDeleteAll(m_tasks);
+}
+
+void BatchInstaller::addSource(const QString & _filepath)
+{
+    m_tasks.append(new Task(_filepath));
+}
+
+QList<InstallationResult> BatchInstaller::run(int _jobs)
+{
+    const QString destination_id = storageDeviceId(mr_collection.directory());
+    QList<Task *> queue;
+    for(Task * task : m_tasks)
+    {
+        task->setDestinationStorageDeviceId(destination_id);
+        queue.append(task);
+    }
+    QList<Task *> running_tasks;
+    QElapsedTimer clock;
+    clock.start();
+    m_statistics.reset();
+    while(!queue.isEmpty() || !running_tasks.isEmpty())
+    {
+        for(auto it = queue.begin(); it != queue.end() && running_tasks.count() < _jobs;)
+        {
+            if(isConflictingWithRunningTasks(**it, running_tasks))
+            {
+                ++it;
+                continue;
+            }
+            Task * task = *it;
+            it = queue.erase(it);
+            if(!task->prepare(mr_collection, m_options))
+                continue;
+            task->start(m_options.io_policy, m_finished_tasks);
+            running_tasks.append(task);
+        }
+        if(running_tasks.isEmpty())
+            continue; // The rest of the queue has been rejected
+        if(!m_finished_tasks.tryAcquire(1, g_progress_interval))
+        {
+            reportProgress(m_tasks, clock.elapsed());
+            continue;
+        }
+        for(auto it = running_tasks.begin(); it != running_tasks.end();)
+        {
+            if((*it)->isDone())
+            {
+                it = running_tasks.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    reportProgress(m_tasks, clock.elapsed());
+    QList<InstallationResult> results;
+    for(const Task * task : m_tasks)
+        results.append(task->result());
+    return results;
+}
+
+bool BatchInstaller::isConflictingWithRunningTasks(const Task & _task, const QList<Task *> & _running_tasks) const
+{
+    for(const Task * task : _running_tasks)
+    {
+        if(areTransfersConflicting(_task.sourceStorageDeviceId(), _task.destinationStorageDeviceId(),
+            task->sourceStorageDeviceId(), task->destinationStorageDeviceId()))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchInstaller::reportProgress(const QList<Task *> & _tasks, qint64 _timestamp)
+{
+    if(!m_is_progress_reporting_enabled)
+        return;
+    quint64 total_bytes = 0;
+    quint64 done_bytes = 0;
+    int done_tasks = 0;
+    for(const Task * task : _tasks)
+    {
+        if(task->isDone())
+            ++done_tasks;
+        if(!task->installer())
+        {
+            if(!task->isDone())
+                total_bytes += task->deviceSize();
+            continue;
+        }
+        const TransferProgress & progress = task->installer()->transferProgress();
+        total_bytes += progress.totalBytes() == 0 ? task->deviceSize() : progress.totalBytes();
+        done_bytes += progress.doneBytes();
+    }
+    m_statistics.sample(total_bytes, done_bytes, _timestamp);
+    const int percent = total_bytes == 0 ? 0 : static_cast<int>(done_bytes * 100 / total_bytes);
+    QTextStream(stderr) << QString("[%1/%2] %3% (%4)").arg(done_tasks).arg(_tasks.count())
+        .arg(percent).arg(m_statistics.toString()) << endl;
+}
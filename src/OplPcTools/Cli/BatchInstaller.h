@@ -0,0 +1,93 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_CLI_BATCHINSTALLER__
+#define __OPLPCTOOLS_CLI_BATCHINSTALLER__
+
+#include <QList>
+#include <QSemaphore>
+#include <OplPcTools/GameCollection.h>
+#include <OplPcTools/MediaType.h>
+#include <OplPcTools/GameInstallationType.h>
+#include <OplPcTools/TransferStatistics.h>
+#include <OplPcTools/IoThrottle.h>
+
+namespace OplPcTools {
+namespace Cli {
+
+struct InstallationOptions
+{
+    GameInstallationType installation_type;
+    MediaType media_type;
+    bool move_file;
+    bool rename_file;
+    bool trim;
+    bool strip_dummies;
+    IoPolicy io_policy;
+};
+
+struct InstallationResult
+{
+    QString source;
+    QString game_id;
+    QString title;
+    QString error;
+    quint64 bytes;
+    qint64 elapsed_ms;
+    bool is_installed;
+};
+
+// Installs images as jobs of the JobScheduler. Tasks whose sources or destinations share
+// a physical drive are never run simultaneously (see areTransfersConflicting).
+// An image is opened just before its task starts and closed when the task is done,
+// so the number of open files does not depend on the size of the batch.
+class BatchInstaller final
+{
+    Q_DISABLE_COPY(BatchInstaller)
+
+    class Task;
+
+public:
+    BatchInstaller(GameCollection & _collection, const InstallationOptions & _options);
+    ~BatchInstaller();
+    void addSource(const QString & _filepath);
+    inline void setProgressReportingEnabled(bool _enabled);
+    QList<InstallationResult> run(int _jobs);
+
+private:
+    bool isConflictingWithRunningTasks(const Task & _task, const QList<Task *> & _running_tasks) const;
+    void reportProgress(const QList<Task *> & _tasks, qint64 _timestamp);
+
+private:
+    GameCollection & mr_collection;
+    InstallationOptions m_options;
+    QList<Task *> m_tasks;
+    QSemaphore m_finished_tasks;
+    TransferStatistics m_statistics;
+    bool m_is_progress_reporting_enabled;
+};
+
+void BatchInstaller::setProgressReportingEnabled(bool _enabled)
+{
+    m_is_progress_reporting_enabled = _enabled;
+}
+
+} // namespace Cli
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_CLI_BATCHINSTALLER__
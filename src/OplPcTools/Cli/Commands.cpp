@@ -0,0 +1,470 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QThread>
+#include <QStandardPaths>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/GameCollection.h>
+#include <OplPcTools/GameArtManager.h>
+#include <OplPcTools/GameArtImporter.h>
+#include <OplPcTools/GameArtOptimizer.h>
+#include <OplPcTools/DuplicateFinder.h>
+#include <OplPcTools/LibraryVerifier.h>
+#include <OplPcTools/IsoRestorer.h>
+#include <OplPcTools/Cli/BatchInstaller.h>
+#include <OplPcTools/Cli/Commands.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::Cli;
+
+namespace {
+
+QCommandLineOption libraryOption()
+{
+    return QCommandLineOption({ "L", "library" }, "Directory of the OPL game library (holds ul.cfg, CD, DVD and ART).", "path");
+}
+
+void processArguments(QCommandLineParser & _parser, const QString & _command, const QStringList & _arguments)
+{
+    _parser.addHelpOption();
+    _parser.addOption(libraryOption());
+    QStringList arguments = _arguments;
+    arguments.prepend(QString("%1 %2").arg(QCoreApplication::applicationName()).arg(_command));
+    _parser.process(arguments);
+}
+
+void loadCollection(GameCollection & _collection, const QCommandLineParser & _parser)
+{
+    const QString library = _parser.value("library");
+    if(library.isEmpty())
+        throw ValidationException(QObject::tr("The library directory is not specified"));
+    QDir directory(library);
+    if(!directory.exists())
+        throw IOException(QObject::tr("Directory not found: \"%1\"").arg(library));
+    _collection.load(directory);
+}
+
+QSharedPointer<const Game> findGame(const GameCollection & _collection, const QString & _id)
+{
+    QSharedPointer<const Game> game = _collection.findGame(_id);
+    if(!game)
+        throw ValidationException(QObject::tr("Game \"%1\" not found").arg(_id));
+    return game;
+}
+
+QString mediaTypeToString(MediaType _type)
+{
+    switch(_type)
+    {
+    case MediaType::CD:
+        return "CD";
+    case MediaType::DVD:
+        return "DVD";
+    default:
+        return "Unknown";
+    }
+}
+
+QString installationTypeToString(GameInstallationType _type)
+{
+    return _type == GameInstallationType::UlConfig ? "ul.cfg" : "directory";
+}
+
+QJsonObject gameToJson(const Game & _game)
+{
+    QJsonObject json;
+    json["id"] = _game.id();
+    json["title"] = _game.title();
+    json["media"] = mediaTypeToString(_game.mediaType());
+    json["installation"] = installationTypeToString(_game.installationType());
+    json["parts"] = _game.partCount();
+    return json;
+}
+
+QJsonObject errorToJson(const QString & _id, const QString & _error)
+{
+    QJsonObject json;
+    json["id"] = _id;
+    json["status"] = "failed";
+    json["error"] = _error;
+    return json;
+}
+
+void printJson(const QJsonObject & _object)
+{
+    QTextStream(stdout) << QJsonDocument(_object).toJson(QJsonDocument::Indented);
+}
+
+} // namespace
+
+int OplPcTools::Cli::listGames(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints the games of the library.");
+    processArguments(parser, "list", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    QJsonArray games;
+    for(int i = 0; i < collection.count(); ++i)
+        games.append(gameToJson(*collection[i]));
+    QJsonObject output;
+    output["library"] = collection.directory();
+    output["count"] = collection.count();
+    output["games"] = games;
+    printJson(output);
+    return 0;
+}
+
+int OplPcTools::Cli::installGames(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Installs the disc images (*.iso, *.bin, *.nrg) into the library.");
+    QCommandLineOption jobs_option({ "j", "jobs" },
+        "Maximum number of simultaneous installations. Tasks sharing a drive are serialized.", "count",
+        QString::number(QThread::idealThreadCount()));
+    QCommandLineOption type_option({ "t", "type" },
+        "Installation type: \"ulcfg\" or \"directory\". The default one is taken from the settings.", "type");
+    QCommandLineOption media_option({ "m", "media" }, "Override the media type: \"cd\" or \"dvd\".", "type");
+    QCommandLineOption move_option("move", "Move the ISO files instead of copying (directory installation).");
+    QCommandLineOption rename_option("rename", "Prefix the ISO files with the game ID (directory installation).");
+    QCommandLineOption trim_option("trim", "Do not copy the padding after the last file of the disc.");
+    QCommandLineOption strip_dummies_option("strip-dummies", "Remove the padding files named DUMMY from the images.");
+    QCommandLineOption progress_option("progress", "Report the overall progress to stderr.");
+    parser.addOptions({ jobs_option, type_option, media_option, move_option, rename_option, trim_option,
+        strip_dummies_option, progress_option });
+    parser.addPositionalArgument("images", "Disc images to install.", "<image>...");
+    processArguments(parser, "install", _arguments);
+    const QStringList images = parser.positionalArguments();
+    if(images.isEmpty())
+        throw ValidationException(QObject::tr("No images are specified"));
+    const Settings & settings = Settings::instance();
+    InstallationOptions options;
+    options.installation_type = settings.flag(Settings::Flag::SplitUpIso) ?
+        GameInstallationType::UlConfig : GameInstallationType::Directory;
+    if(parser.isSet(type_option))
+    {
+        const QString type = parser.value(type_option);
+        if(type == "ulcfg")
+            options.installation_type = GameInstallationType::UlConfig;
+        else if(type == "directory")
+            options.installation_type = GameInstallationType::Directory;
+        else
+            throw ValidationException(QObject::tr("Unknown installation type: \"%1\"").arg(type));
+    }
+    options.media_type = MediaType::Unknown;
+    if(parser.isSet(media_option))
+    {
+        const QString media = parser.value(media_option).toLower();
+        if(media == "cd")
+            options.media_type = MediaType::CD;
+        else if(media == "dvd")
+            options.media_type = MediaType::DVD;
+        else
+            throw ValidationException(QObject::tr("Unknown media type: \"%1\"").arg(media));
+    }
+    options.move_file = parser.isSet(move_option);
+    options.rename_file = parser.isSet(rename_option);
+    options.trim = parser.isSet(trim_option);
+    options.strip_dummies = parser.isSet(strip_dummies_option);
+    options.io_policy = settings.ioPolicy();
+    GameCollection collection;
+    loadCollection(collection, parser);
+    BatchInstaller installer(collection, options);
+    installer.setProgressReportingEnabled(parser.isSet(progress_option));
+    for(const QString & image : images)
+        installer.addSource(image);
+    QJsonArray results;
+    bool has_failures = false;
+    for(const InstallationResult & result : installer.run(qMax(1, parser.value(jobs_option).toInt())))
+    {
+        QJsonObject json;
+        json["source"] = result.source;
+        json["id"] = result.game_id;
+        json["title"] = result.title;
+        json["status"] = result.is_installed ? "installed" : "failed";
+        if(!result.is_installed)
+        {
+            json["error"] = result.error;
+            has_failures = true;
+        }
+        json["bytes"] = static_cast<double>(result.bytes);
+        json["seconds"] = result.elapsed_ms / 1000.0;
+        results.append(json);
+    }
+    QJsonObject output;
+    output["library"] = collection.directory();
+    output["results"] = results;
+    printJson(output);
+    return has_failures ? 1 : 0;
+}
+
+int OplPcTools::Cli::restoreGames(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Restores the ISO images of the games installed with ul.cfg.");
+    QCommandLineOption output_option({ "o", "output" }, "Directory to save the images in.", "path", ".");
+    parser.addOption(output_option);
+    parser.addPositionalArgument("ids", "IDs of the games to restore.", "<id>...");
+    processArguments(parser, "restore", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    QDir output_dir(parser.value(output_option));
+    if(!output_dir.exists())
+        throw IOException(QObject::tr("Directory not found: \"%1\"").arg(output_dir.path()));
+    QJsonArray results;
+    bool has_failures = false;
+    for(const QString & id : parser.positionalArguments())
+    {
+        try
+        {
+            const QSharedPointer<const Game> game_ptr = findGame(collection, id);
+            const Game & game = *game_ptr;
+            if(game.installationType() != GameInstallationType::UlConfig)
+                throw ValidationException(QObject::tr("Game \"%1\" is not installed with ul.cfg").arg(id));
+            const QString iso_filepath = output_dir.absoluteFilePath(game.title() + ".iso");
+            IsoRestorer restorer(game, collection.directory(), iso_filepath);
+            if(!restorer.restore())
+                throw Exception(QObject::tr("Restoring was canceled"));
+            QJsonObject json;
+            json["id"] = id;
+            json["status"] = "restored";
+            json["iso"] = iso_filepath;
+            results.append(json);
+        }
+        catch(const Exception & exception)
+        {
+            results.append(errorToJson(id, exception.message()));
+            has_failures = true;
+        }
+    }
+    QJsonObject output;
+    output["results"] = results;
+    printJson(output);
+    return has_failures ? 1 : 0;
+}
+
+int OplPcTools::Cli::renameGame(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renames the game.");
+    parser.addPositionalArgument("id", "ID of the game.");
+    parser.addPositionalArgument("title", "New title.");
+    processArguments(parser, "rename", _arguments);
+    const QStringList arguments = parser.positionalArguments();
+    if(arguments.count() != 2)
+        throw ValidationException(QObject::tr("The game ID and the new title are expected"));
+    GameCollection collection;
+    loadCollection(collection, parser);
+    collection.renameGame(*findGame(collection, arguments[0]), arguments[1]);
+    QJsonObject output;
+    output["game"] = gameToJson(*findGame(collection, arguments[0]));
+    printJson(output);
+    return 0;
+}
+
+int OplPcTools::Cli::deleteGames(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Deletes the games and their pictures from the library.");
+    QCommandLineOption keep_art_option("keep-art", "Do not delete the pictures.");
+    parser.addOption(keep_art_option);
+    parser.addPositionalArgument("ids", "IDs of the games to delete.", "<id>...");
+    processArguments(parser, "delete", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    GameArtManager art_manager(collection.directory());
+    QJsonArray results;
+    bool has_failures = false;
+    for(const QString & id : parser.positionalArguments())
+    {
+        try
+        {
+            collection.deleteGame(*findGame(collection, id));
+            if(!parser.isSet(keep_art_option))
+                art_manager.clearArts(id);
+            QJsonObject json;
+            json["id"] = id;
+            json["status"] = "deleted";
+            results.append(json);
+        }
+        catch(const Exception & exception)
+        {
+            results.append(errorToJson(id, exception.message()));
+            has_failures = true;
+        }
+    }
+    QJsonObject output;
+    output["results"] = results;
+    printJson(output);
+    return has_failures ? 1 : 0;
+}
+
+int OplPcTools::Cli::verifyGames(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Checks that the files of the games are present, the images are valid "
+        "and their IDs match the library.");
+    QCommandLineOption read_option("read", "Read the whole data to detect I/O errors and compare the checksums "
+        "with the ones computed by the previous runs.");
+    parser.addOption(read_option);
+    parser.addPositionalArgument("ids", "IDs of the games to verify. All games are verified by default.", "[<id>...]");
+    processArguments(parser, "verify", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    GameList games = *collection.games();
+    if(!parser.positionalArguments().isEmpty())
+    {
+        QSet<QString> ids;
+        for(const QString & id : parser.positionalArguments())
+            ids.insert(findGame(collection, id)->id());
+        games.erase(std::remove_if(games.begin(), games.end(), [&ids](const QSharedPointer<const Game> & _game) {
+            return !ids.contains(_game->id());
+        }), games.end());
+    }
+    const QString cache_filepath = ImageHashCache::filepath(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation), collection.directory());
+    ImageHashCache cache;
+    LibraryVerifier verifier(collection.directory());
+    if(parser.isSet(read_option))
+    {
+        cache.load(cache_filepath);
+        verifier.setFullReadEnabled(true);
+        verifier.setChecksumCache(&cache);
+    }
+    const LibraryVerificationResult result = verifier.verify(games);
+    if(parser.isSet(read_option))
+        cache.save(cache_filepath);
+    QJsonArray results;
+    for(const GameIntegrityReport & report : result.reports)
+    {
+        QJsonObject json = gameToJson(*report.game);
+        json["status"] = report.issues.isEmpty() ? "ok" : "broken";
+        json["issues"] = QJsonArray::fromStringList(report.issues);
+        if(!report.checksum.isEmpty())
+            json["checksum"] = QString::fromLatin1(report.checksum.toHex());
+        results.append(json);
+    }
+    QJsonObject output;
+    output["library"] = collection.directory();
+    output["results"] = results;
+    printJson(output);
+    return result.broken > 0 ? 1 : 0;
+}
+
+int OplPcTools::Cli::importArts(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Imports pictures named <ID>_COV.jpg, <ID>_ICO.png, etc. into the library.");
+    QCommandLineOption all_option("all", "Import pictures of games that are not in the library as well.");
+    parser.addOption(all_option);
+    parser.addPositionalArgument("paths", "Picture files and directories to search for pictures.", "<path>...");
+    processArguments(parser, "import-art", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    GameArtManager art_manager(collection.directory());
+    GameArtImporter importer(art_manager);
+    if(!parser.isSet(all_option))
+    {
+        QSet<QString> game_ids;
+        for(int i = 0; i < collection.count(); ++i)
+            game_ids.insert(collection[i]->id());
+        importer.setGameIds(game_ids);
+    }
+    GameArtImportResult result = importer.import(parser.positionalArguments());
+    QJsonObject output;
+    output["imported"] = result.imported;
+    output["skipped"] = result.skipped;
+    output["failed"] = result.failed;
+    output["errors"] = QJsonArray::fromStringList(result.errors);
+    printJson(output);
+    return result.failed > 0 ? 1 : 0;
+}
+
+int OplPcTools::Cli::optimizeArts(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Scales the pictures of the library to the sizes used by OPL and recompresses them.");
+    QCommandLineOption dry_run_option("dry-run", "Only report the sizes, do not replace the files.");
+    parser.addOption(dry_run_option);
+    processArguments(parser, "optimize-art", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    GameArtManager art_manager(collection.directory());
+    GameArtOptimizer optimizer(art_manager);
+    optimizer.setDryRun(parser.isSet(dry_run_option));
+    GameArtOptimizationResult result = optimizer.optimize();
+    QJsonObject output;
+    output["optimized"] = result.optimized;
+    output["unchanged"] = result.unchanged;
+    output["failed"] = result.failed;
+    output["bytes_before"] = result.bytes_before;
+    output["bytes_after"] = result.bytes_after;
+    output["errors"] = QJsonArray::fromStringList(result.errors);
+    printJson(output);
+    return result.failed > 0 ? 1 : 0;
+}
+
+int OplPcTools::Cli::findDuplicates(const QStringList & _arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Finds the games with the same disc image. "
+        "The images that differ only by the padding at the end are reported as duplicates too.");
+    processArguments(parser, "duplicates", _arguments);
+    GameCollection collection;
+    loadCollection(collection, parser);
+    const QString cache_filepath = ImageHashCache::filepath(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation), collection.directory());
+    ImageHashCache cache;
+    cache.load(cache_filepath);
+    DuplicateFinder finder(collection, cache);
+    DuplicateSearchResult result = finder.find();
+    cache.save(cache_filepath);
+    QJsonArray groups;
+    for(const DuplicateGroup & group : result.groups)
+    {
+        QJsonArray games;
+        for(const DuplicateImage & image : group.images)
+        {
+            QJsonObject game = gameToJson(*image.game);
+            game["files"] = QJsonArray::fromStringList(image.filepaths);
+            game["size"] = static_cast<qint64>(image.size);
+            games.append(game);
+        }
+        QJsonObject json;
+        json["hash"] = QString::fromLatin1(group.content_hash.toHex());
+        json["identical"] = group.isIdentical();
+        json["reclaimable"] = static_cast<qint64>(group.reclaimableSize());
+        json["games"] = games;
+        groups.append(json);
+    }
+    QJsonObject output;
+    output["groups"] = groups;
+    output["hashed"] = result.hashed;
+    output["cached"] = result.cached;
+    output["errors"] = QJsonArray::fromStringList(result.errors);
+    printJson(output);
+    return result.errors.isEmpty() ? 0 : 1;
+}
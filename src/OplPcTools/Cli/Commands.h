@@ -0,0 +1,45 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_CLI_COMMANDS__
+#define __OPLPCTOOLS_CLI_COMMANDS__
+
+#include <QStringList>
+
+namespace OplPcTools {
+namespace Cli {
+
+/*
+ * Each command receives the command line without the command name, prints a JSON document to stdout
+ * and returns the process exit code.
+ */
+
+int listGames(const QStringList & _arguments);
+int installGames(const QStringList & _arguments);
+int restoreGames(const QStringList & _arguments);
+int renameGame(const QStringList & _arguments);
+int deleteGames(const QStringList & _arguments);
+int verifyGames(const QStringList & _arguments);
+int importArts(const QStringList & _arguments);
+int optimizeArts(const QStringList & _arguments);
+int findDuplicates(const QStringList & _arguments);
+
+} // namespace Cli
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_CLI_COMMANDS__
@@ -16,140 +16,22 @@
  *                                                                                             *
  ***********************************************************************************************/
 
+#include <limits>
 #include <QRegExp>
 #include <QFileInfo>
+#include <QSet>
+#include <QQueue>
+#include <QtEndian>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/Iso9660Structures.h>
 #include <OplPcTools/Device.h>
 
-#define ISO9660_OFFSET 0x8000
+#define ISO9660_BLOCK_COUNT_OFFSET (ISO9660_OFFSET + 80)
 
 using namespace OplPcTools;
 
 namespace {
 
-template<typename IntType>
-struct LBInt
-{
-    IntType le;
-    IntType be;
-
-    operator IntType() const
-    {
-#if BYTE_ORDER == LITTLE_ENDIAN
-        return le;
-#else
-        return be;
-#endif
-
-    }
-} __attribute__((packed));
-
-using LBInt16 = LBInt<qint16>;
-using LBInt32 = LBInt<qint32>;
-
-struct DateTimeDR
-{
-    qint8 year;
-    qint8 month;
-    qint8 day;
-    qint8 hour;
-    qint8 minute;
-    qint8 second;
-    qint8 timezone_offset;
-} __attribute__((packed));
-
-struct FileFlags
-{
-    bool hidden: 1;
-    bool directory: 1;
-    bool associated: 1;
-    bool extend_attr_has_info : 1;
-    bool extend_attr_has_perms: 1;
-    bool unused_1: 1;
-    bool unused_2: 1;
-    bool is_not_final_dir: 1;
-};
-
-struct FileRecord
-{
-    qint8 record_length;
-    qint8 extended_attr_record_length;
-    LBInt32 extent_location;
-    LBInt32 data_length;
-    DateTimeDR recording_date;
-    FileFlags file_flags;
-    qint8 file_unit_size;
-    qint8 interleave_gap_size;
-    LBInt16 volume_sequence_number;
-    qint8 filename_length;
-    char filename[1];
-} __attribute__((packed));
-
-struct DateTimePVD
-{
-    char year[4];
-    char month[2];
-    char day[2];
-    char hour[2];
-    char minute[2];
-    char second[2];
-    char second_hundredths[2];
-    qint8 timezone_offset;
-} __attribute__((packed));
-
-enum class VolumeDescriptorType : qint8
-{
-    BootRecord = 0,
-    PrimaryVolumeDescriptor = 1,
-    SupplementaryVolumeDescriptor  = 2,
-    VolumePartitionDescriptor  = 3
-};
-
-struct BasicVolumeDescriptor
-{
-    VolumeDescriptorType type;
-    char id[5];
-    qint8 version;
-} __attribute__((packed));
-
-struct VolumeDescriptor : BasicVolumeDescriptor
-{
-    qint8 data[2041];
-} __attribute__((packed));
-
-struct PrimaryVolumeDescriptor : BasicVolumeDescriptor
-{
-    qint8 unused_1;
-    char system_id[32];
-    char volume_id[32];
-    qint8 unused_2[8];
-    LBInt32 block_count;
-    qint8 unused_3[32];
-    LBInt16 volume_set_size;
-    LBInt16 volume_number;
-    LBInt16 block_size;
-    LBInt32 path_table_size;
-    qint32 path_table_location_le;
-    qint32 optional_path_table_location_le;
-    qint32 path_table_location_be;
-    qint32 optional_path_table_location_be;
-    FileRecord root_directory;
-    char volume_set_id[128];
-    char publisher_id[128];
-    char data_preparer_id[128];
-    char application_id[128];
-    char copyright_file_id[38];
-    char abstract_file_id[36];
-    char bibliographic_file_id[37];
-    DateTimePVD creation_date;
-    DateTimePVD modification_date;
-    DateTimePVD expiration_date;
-    DateTimePVD effective_date;
-    qint8 file_structure_version;
-    qint8 unused_4;
-    qint8 application_data[512];
-    qint8 unused_5[653];
-} __attribute__((packed));
-
 class Iso9660 final
 {
     Q_DISABLE_COPY(Iso9660)
@@ -163,9 +45,11 @@ public:
     inline bool isPlayStationDisc() const;
     inline QString title() const;
     inline const QString & gameId() const;
+    qint64 usedBlockCount(DeviceSource & _source) const;
 
 private:
     bool readPrimaryVolumeDescriptor(DeviceSource & _source);
+    qint32 volumeDescriptorsEnd(DeviceSource & _source) const;
     bool readConfig(DeviceSource & _source);
     bool parseConfig(DeviceSource & _source, const FileRecord * _file_record);
     bool readGameId(const QByteArray & _config);
@@ -259,6 +143,100 @@ bool Iso9660::readGameId(const QByteArray & _config)
     return false;
 }
 
+// Returns the number of blocks up to the end of the last extent referenced by the file system
+// or -1 if the file system cannot be walked completely.
+// The locations and lengths are unsigned 32-bit values, files of 2 GiB and more are common on DVD images.
+qint64 Iso9660::usedBlockCount(DeviceSource & _source) const
+{
+    OPT_TRACE_SCOPE("Iso9660::usedBlockCount");
+    if(!m_is_initialized)
+        return -1;
+    const quint64 block_size = static_cast<quint16>(mp_descriptor->block_size);
+    const quint32 max_directory_size = 16777216;
+    if(block_size == 0)
+        return -1;
+    auto extentEnd = [block_size](quint32 _location, quint32 _length) {
+        return static_cast<quint64>(_location) + (static_cast<quint64>(_length) + block_size - 1) / block_size;
+    };
+    const qint32 descriptors_end = volumeDescriptorsEnd(_source);
+    if(descriptors_end < 0)
+        return -1;
+    quint64 used_block_count = static_cast<quint64>(descriptors_end);
+    const quint32 path_table_size = static_cast<quint32>(static_cast<qint32>(mp_descriptor->path_table_size));
+    used_block_count = qMax(used_block_count,
+        extentEnd(qFromLittleEndian<quint32>(mp_descriptor->path_table_location_le), path_table_size));
+    used_block_count = qMax(used_block_count,
+        extentEnd(qFromBigEndian<quint32>(mp_descriptor->path_table_location_be), path_table_size));
+    const quint32 root_location = static_cast<quint32>(static_cast<qint32>(mp_descriptor->root_directory.extent_location));
+    const quint32 root_length = static_cast<quint32>(static_cast<qint32>(mp_descriptor->root_directory.data_length));
+    QSet<quint32> visited_directories;
+    QQueue<QPair<quint32, quint32>> directories; // Location and length of the directories to walk
+    directories.enqueue(qMakePair(root_location, root_length));
+    visited_directories.insert(root_location);
+    QByteArray buffer;
+    while(!directories.isEmpty())
+    {
+        const QPair<quint32, quint32> directory = directories.dequeue();
+        const quint32 data_length = directory.second;
+        if(data_length == 0 || data_length > max_directory_size)
+            return -1;
+        used_block_count = qMax(used_block_count, extentEnd(directory.first, data_length));
+        if(!_source.seek(static_cast<qint64>(directory.first * block_size)))
+            return -1;
+        buffer.resize(static_cast<int>(data_length));
+        if(_source.read(buffer) != static_cast<qint64>(data_length))
+            return -1;
+        for(quint32 processed = 0; processed < data_length;)
+        {
+            const FileRecord * record = reinterpret_cast<const FileRecord *>(buffer.constData() + processed);
+            const quint8 record_length = static_cast<quint8>(record->record_length);
+            if(record_length == 0)
+            {
+                // Records never cross a block boundary, the rest of the block is padding.
+                processed = static_cast<quint32>((processed / block_size + 1) * block_size);
+                continue;
+            }
+            if(record_length < sizeof(FileRecord) || processed + record_length > data_length)
+                return -1;
+            processed += record_length;
+            if(record->filename_length == 1 && static_cast<quint8>(record->filename[0]) <= 1)
+                continue; // The directory itself and its parent
+            const quint32 location = static_cast<quint32>(static_cast<qint32>(record->extent_location));
+            const quint32 length = static_cast<quint32>(static_cast<qint32>(record->data_length));
+            if(!record->file_flags.directory)
+                used_block_count = qMax(used_block_count, extentEnd(location, length));
+            else if(!visited_directories.contains(location))
+            {
+                visited_directories.insert(location);
+                directories.enqueue(qMakePair(location, length));
+            }
+        }
+    }
+    // The trimmed image declares its block count in a 32-bit field
+    if(used_block_count > std::numeric_limits<quint32>::max())
+        return -1;
+    const quint64 block_count = static_cast<quint32>(blockCount());
+    return static_cast<qint64>(qMin(used_block_count, block_count));
+}
+
+qint32 Iso9660::volumeDescriptorsEnd(DeviceSource & _source) const
+{
+    const qint32 max_descriptor_count = 64;
+    qint32 block = ISO9660_OFFSET / mp_descriptor->block_size;
+    if(!_source.seek(ISO9660_OFFSET))
+        return -1;
+    QByteArray buffer(sizeof(VolumeDescriptor), Qt::Uninitialized);
+    for(qint32 i = 0; i < max_descriptor_count; ++i)
+    {
+        if(_source.read(buffer) != sizeof(VolumeDescriptor))
+            return -1;
+        ++block;
+        if(reinterpret_cast<const VolumeDescriptor *>(buffer.constData())->type == VolumeDescriptorType::VolumeDescriptorSetTerminator)
+            return block;
+    }
+    return -1;
+}
+
 bool Iso9660::isInitialized() const
 {
     return m_is_initialized;
@@ -297,7 +275,13 @@ QString Iso9660::title() const
 Device::Device(QSharedPointer<DeviceSource> _source) :
     m_is_initialized(false),
     m_source_ptr(_source),
-    m_media_type(MediaType::Unknown)
+    m_media_type(MediaType::Unknown),
+    m_size(0),
+    m_used_size(0),
+    m_is_used_size_known(false),
+    m_block_size(0),
+    m_is_trimming_enabled(false),
+    m_position(0)
 {
 }
 
@@ -308,6 +292,7 @@ const QString Device::filepath() const
 
 bool Device::init()
 {
+    OPT_TRACE_SCOPE("Device::init");
     if(m_source_ptr->isOpen())
         m_source_ptr->seek(0);
     else if(!m_source_ptr->open())
@@ -318,10 +303,13 @@ bool Device::init()
         m_title = iso->title();
         m_id = iso->gameId();
         m_size = static_cast<quint64>(iso->blockCount()) * iso->blockSize();
+        m_is_used_size_known = false;
+        m_block_size = iso->blockSize();
         m_is_initialized = true;
     }
     delete iso;
     m_source_ptr->seek(0);
+    m_position = 0;
     return m_is_initialized;
 }
 
@@ -330,9 +318,44 @@ bool Device::isInitialized() const
     return m_is_initialized;
 }
 
+// Walking the file system costs a read of every directory, only trimming needs the result
+quint64 Device::usedSize() const
+{
+    if(!m_is_used_size_known)
+    {
+        m_used_size = measureUsedSize();
+        m_is_used_size_known = true;
+    }
+    return m_used_size;
+}
+
+void Device::enableTrimming(bool _enable)
+{
+    m_is_trimming_enabled = _enable;
+    if(_enable)
+        usedSize();
+}
+
+quint64 Device::measureUsedSize() const
+{
+    if(!m_is_initialized)
+        return m_size;
+    const bool is_open = m_source_ptr->isOpen();
+    if(!is_open && !m_source_ptr->open())
+        return m_size;
+    Iso9660 iso(*m_source_ptr);
+    const qint64 used_block_count = iso.isInitialized() ? iso.usedBlockCount(*m_source_ptr) : -1;
+    if(is_open)
+        m_source_ptr->seek(m_position);
+    else
+        m_source_ptr->close();
+    return used_block_count > 0 ? static_cast<quint64>(used_block_count) * m_block_size : m_size;
+}
+
 bool Device::open()
 {
     close();
+    m_position = 0;
     return m_source_ptr->open();
 }
 
@@ -348,10 +371,43 @@ bool Device::isOpen() const
 
 bool Device::seek(quint64 _offset)
 {
-    return m_source_ptr->seek(_offset);
+    if(!m_source_ptr->seek(_offset))
+        return false;
+    m_position = _offset;
+    return true;
 }
 
 qint64 Device::read(QByteArray & _buffer)
 {
-    return m_source_ptr->read(_buffer);
+    qint64 read_bytes = m_source_ptr->read(_buffer);
+    if(read_bytes <= 0)
+        return read_bytes;
+    const quint64 position = m_position;
+    m_position += read_bytes;
+    if(!isTrimmed())
+        return read_bytes;
+    if(position >= m_used_size)
+        return 0;
+    read_bytes = static_cast<qint64>(qMin<quint64>(read_bytes, m_used_size - position));
+    patchBlockCount(position, _buffer.data(), read_bytes);
+    return read_bytes;
+}
+
+// The trimmed image declares the volume size it actually has, both byte orders of the field are replaced.
+void Device::patchBlockCount(quint64 _position, char * _data, qint64 _size) const
+{
+    const quint64 field_offset = ISO9660_BLOCK_COUNT_OFFSET;
+    const quint64 field_size = 8;
+    if(_position >= field_offset + field_size || _position + _size <= field_offset)
+        return;
+    const quint32 block_count = static_cast<quint32>(m_used_size / m_block_size);
+    uchar field[field_size];
+    qToLittleEndian(block_count, field);
+    qToBigEndian(block_count, field + 4);
+    for(quint64 i = 0; i < field_size; ++i)
+    {
+        const quint64 offset = field_offset + i;
+        if(offset >= _position && offset < _position + _size)
+            _data[offset - _position] = static_cast<char>(field[i]);
+    }
 }
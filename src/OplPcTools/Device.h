@@ -42,11 +42,16 @@ class Device final
 public:
     explicit Device(QSharedPointer<DeviceSource> _source);
     const QString filepath() const;
+    inline const QSharedPointer<DeviceSource> & source() const;
     bool init();
     bool isInitialized() const;
     inline QString title() const;
     inline void setTitle(const QString _title);
     inline quint64 size() const;
+    inline quint64 declaredSize() const;
+    quint64 usedSize() const;
+    inline bool isTrimmingEnabled() const;
+    void enableTrimming(bool _enable);
     inline MediaType mediaType() const;
     inline void setMediaType(MediaType _media_type);
     inline const QString & gameId() const;
@@ -57,6 +62,11 @@ public:
     bool seek(quint64 _offset);
     qint64 read(QByteArray & _buffer);
 
+private:
+    inline bool isTrimmed() const;
+    quint64 measureUsedSize() const;
+    void patchBlockCount(quint64 _position, char * _data, qint64 _size) const;
+
 private:
     bool m_is_initialized;
     QSharedPointer<DeviceSource> m_source_ptr;
@@ -64,8 +74,18 @@ private:
     QString m_id;
     QString m_title;
     quint64 m_size;
+    mutable quint64 m_used_size;
+    mutable bool m_is_used_size_known;
+    quint64 m_block_size;
+    bool m_is_trimming_enabled;
+    quint64 m_position;
 };
 
+const QSharedPointer<DeviceSource> & Device::source() const
+{
+    return m_source_ptr;
+}
+
 QString Device::title() const
 {
     return m_title;
@@ -76,11 +96,27 @@ void Device::setTitle(const QString _title)
     m_title = _title;
 }
 
+// With trimming enabled the image ends with the last extent of its file system
 quint64 Device::size() const
+{
+    return isTrimmed() ? m_used_size : m_size;
+}
+
+quint64 Device::declaredSize() const
 {
     return m_size;
 }
 
+bool Device::isTrimmingEnabled() const
+{
+    return m_is_trimming_enabled;
+}
+
+bool Device::isTrimmed() const
+{
+    return m_is_trimming_enabled && usedSize() < m_size;
+}
+
 const QString & Device::gameId() const
 {
     return m_id;
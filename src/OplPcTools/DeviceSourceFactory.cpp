@@ -0,0 +1,36 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <OplPcTools/Iso9660DeviceSource.h>
+#include <OplPcTools/BinCueDeviceSource.h>
+#include <OplPcTools/NrgDeviceSource.h>
+#include <OplPcTools/DeviceSourceFactory.h>
+
+using namespace OplPcTools;
+
+QSharedPointer<DeviceSource> OplPcTools::createDeviceSource(const QString & _filepath)
+{
+    DeviceSource * source = nullptr;
+    if(_filepath.endsWith(".iso", Qt::CaseInsensitive))
+        source = new Iso9660DeviceSource(_filepath);
+    else if(_filepath.endsWith(".bin", Qt::CaseInsensitive))
+        source = new BinCueDeviceSource(_filepath);
+    else if(_filepath.endsWith(".nrg", Qt::CaseInsensitive))
+        source = new NrgDeviceSource(_filepath);
+    return QSharedPointer<DeviceSource>(source);
+}
@@ -0,0 +1,35 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_DEVICESOURCEFACTORY__
+#define __OPLPCTOOLS_DEVICESOURCEFACTORY__
+
+#include <QSharedPointer>
+#include <OplPcTools/DeviceSource.h>
+
+namespace OplPcTools {
+
+/*
+ * Creates a source for the disc image by its extension (*.iso, *.bin, *.nrg).
+ * Returns a null pointer if the format is not supported.
+ */
+QSharedPointer<DeviceSource> createDeviceSource(const QString & _filepath);
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_DEVICESOURCEFACTORY__
@@ -17,12 +17,24 @@
  ***********************************************************************************************/
 
 #include <QStorageInfo>
-#include <QThread>
+#include <QFileInfo>
+#include <OplPcTools/JobScheduler.h>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/WriteBackFile.h>
+#include <OplPcTools/TransferJournal.h>
 #include <OplPcTools/DirectoryGameInstaller.h>
 
 using namespace OplPcTools;
 
+namespace {
+
+const quint64 g_checkpoint_interval = 268435456;
+
+} // namespace
+
 DirectoryGameInstaller::DirectoryGameInstaller(Device & _device, GameCollection & _collection, QObject * _parent /*= nullptr*/) :
     GameInstaller(_device, _collection, _parent),
     m_move_file(false),
@@ -38,6 +50,7 @@ DirectoryGameInstaller::~DirectoryGameInstaller()
 
 bool DirectoryGameInstaller::install()
 {
+    OPT_TRACE_SCOPE("DirectoryGameInstaller::install");
     if(m_move_file && mr_device.isReadOnly())
     {
         throw IOException(tr("It is impossible to move the file \"%1\". "
@@ -59,8 +72,9 @@ bool DirectoryGameInstaller::install()
     if(m_move_file && QStorageInfo(mr_device.filepath()).device() == QStorageInfo(dest_dir).device())
     {
         quint64 iso_size = mr_device.size();
+        m_progress.reset(iso_size);
         QFile::rename(mr_device.filepath(), dest_filepath);
-        emit progress(iso_size, iso_size);
+        m_progress.setDoneBytes(iso_size);
     }
     else
     {
@@ -94,65 +108,137 @@ bool DirectoryGameInstaller::install()
 
 bool DirectoryGameInstaller::copyDeviceTo(const QString & _dest)
 {
+    OPT_TRACE_SCOPE("DirectoryGameInstaller::copyDeviceTo");
     const ssize_t read_size = 4194304;
     QByteArray bytes(read_size, Qt::Initialization::Uninitialized);
-    QFile dest(_dest);
-    if(dest.exists())
-        throw IOException(tr("File already exists: \"%1\"").arg(dest.fileName()));
-    if(!dest.open(QIODevice::WriteOnly))
-        throw IOException(tr("Unable to open file to write: \"%1\"").arg(dest.fileName()));
+    if(QFile::exists(_dest))
+        throw IOException(tr("File already exists: \"%1\"").arg(_dest));
+    // The image is written under a temporary name, so the library never picks up an incomplete file.
+    const QString part_filepath = partFilepath(_dest);
+    m_journal_filepath = TransferJournal::filepath(_dest);
     const quint64 iso_size = mr_device.size();
-    mr_device.seek(0);
-    for(quint64 total_read_bytes = 0, write_operation = 0; total_read_bytes < iso_size; ++write_operation)
+    TransferJournal journal;
+    journal.source_filepath = mr_device.filepath();
+    journal.game_id = mp_game->id();
+    journal.source_size = iso_size;
+    journal.source_mtime = QFileInfo(mr_device.filepath()).lastModified().toMSecsSinceEpoch();
+    journal.destination_filepaths << part_filepath;
+    quint64 total_read_bytes = 0;
+    if(QFile::exists(part_filepath))
+    {
+        total_read_bytes = journal.resume(m_journal_filepath, [this](quint64 _offset, QByteArray & _buffer) {
+            return mr_device.seek(_offset) && mr_device.read(_buffer) == _buffer.size();
+        });
+    }
+    WriteBackFile dest(part_filepath, Settings::instance().writeBackPolicy(storageDeviceId(mr_collection.directory())));
+    if(!(total_read_bytes > 0 ? dest.openAt(total_read_bytes) : dest.open(QIODevice::WriteOnly | QIODevice::Truncate)))
+        throw IOException(tr("Unable to open file to write: \"%1\"").arg(dest.fileName()));
+    m_progress.reset(iso_size);
+    m_progress.setDoneBytes(total_read_bytes);
+    mr_device.seek(total_read_bytes);
+    quint64 checkpoint_bytes = total_read_bytes;
+    while(total_read_bytes < iso_size)
     {
-        qint64 read_bytes = mr_device.read(bytes);
+        qint64 read_bytes = 0;
+        {
+            OPT_TRACE_SCOPE("read");
+            read_bytes = mr_device.read(bytes);
+        }
         if(read_bytes < 0)
         {
+            dest.sync();
             dest.close();
-            rollback(_dest);
+            suspend(journal, dest.durableBytes());
             throw IOException(tr("An error occurred during reading the source medium"));
         }
         else if(read_bytes > 0)
         {
-            if(dest.write(bytes.constData(), read_bytes) != read_bytes)
+            qint64 written_bytes = 0;
+            {
+                OPT_TRACE_SCOPE("write");
+                written_bytes = dest.write(bytes.constData(), read_bytes);
+            }
+            if(written_bytes != read_bytes)
             {
+                dest.sync();
                 dest.close();
-                rollback(_dest);
+                suspend(journal, dest.durableBytes());
                 throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(dest.fileName()));
             }
-            if(++write_operation % 5 == 0)
-                dest.flush();
             total_read_bytes += read_bytes;
-            emit progress(iso_size, total_read_bytes);
+            m_progress.setDoneBytes(dest.flushedBytes());
+            OPT_TRACE_COUNTER("installed bytes", total_read_bytes);
+            Job::throttleCurrentJob(read_bytes);
         }
         if(read_bytes < read_size)
         {
-            emit progress(iso_size, iso_size);
+            m_progress.setTotalBytes(total_read_bytes);
             break;
         }
-        if(QThread::currentThread()->isInterruptionRequested())
+        if(total_read_bytes - checkpoint_bytes >= g_checkpoint_interval && dest.sync())
+        {
+            checkpoint_bytes = journal.durable_bytes = total_read_bytes;
+            journal.save(m_journal_filepath);
+        }
+        if(Job::isCurrentJobCanceled())
         {
-            rollback(_dest);
+            dest.sync();
+            dest.close();
+            suspend(journal, dest.durableBytes());
             return false;
         }
     }
+    if(!dest.sync())
+    {
+        dest.close();
+        suspend(journal, dest.durableBytes());
+        throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(dest.fileName()));
+    }
+    dest.close();
+    if(!QFile::rename(part_filepath, _dest))
+    {
+        rollback(_dest);
+        throw IOException(tr("Unable to rename the file \"%1\" to \"%2\"").arg(part_filepath).arg(_dest));
+    }
+    QFile::remove(m_journal_filepath);
+    m_progress.setDoneBytes(total_read_bytes);
     return true;
 }
 
+QString DirectoryGameInstaller::partFilepath(const QString & _dest)
+{
+    return _dest + ".part";
+}
+
 void DirectoryGameInstaller::rollback(const QString & _dest)
 {
+    OPT_TRACE_SCOPE("DirectoryGameInstaller::rollback");
     emit rollbackStarted();
     if(m_move_file && !QFile::exists(mr_device.filepath()))
         QFile::rename(_dest, mr_device.filepath());
     else
         QFile::remove(_dest);
+    QFile::remove(partFilepath(_dest));
+    QFile::remove(TransferJournal::filepath(_dest));
     delete mp_game;
     mp_game = nullptr;
     emit rollbackFinished();
 }
 
+// Stops the installation keeping the written data and a checkpoint at the last synced offset
+void DirectoryGameInstaller::suspend(TransferJournal & _journal, quint64 _durable_bytes)
+{
+    OPT_TRACE_SCOPE("DirectoryGameInstaller::suspend");
+    _journal.durable_bytes = _durable_bytes;
+    _journal.save(m_journal_filepath);
+    delete mp_game;
+    mp_game = nullptr;
+    emit suspended(m_journal_filepath);
+}
+
 void DirectoryGameInstaller::registerGame()
 {
+    OPT_TRACE_SCOPE("DirectoryGameInstaller::registerGame");
     emit registrationStarted();
     mr_collection.addGame(*mp_game);
     emit registrationFinished();
@@ -20,6 +20,7 @@
 #define __OPLPCTOOLS_DIRECTORYGAMEINSTALLER__
 
 #include <OplPcTools/GameInstaller.h>
+#include <OplPcTools/TransferJournal.h>
 
 namespace OplPcTools {
 
@@ -40,7 +41,9 @@ public:
 
 private:
     bool copyDeviceTo(const QString & _dest);
+    static QString partFilepath(const QString & _dest);
     void rollback(const QString & _dest);
+    void suspend(TransferJournal & _journal, quint64 _durable_bytes);
     void registerGame();
 
 private:
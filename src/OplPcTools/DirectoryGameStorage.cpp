@@ -17,6 +17,8 @@
  ***********************************************************************************************/
 
 #include <QVector>
+#include <QFileInfo>
+#include <QDateTime>
 #include <OplPcTools/Exception.h>
 #include <OplPcTools/DirectoryGameStorage.h>
 #include <OplPcTools/Device.h>
@@ -40,33 +42,69 @@ GameInstallationType DirectoryGameStorage::installationType() const
 bool DirectoryGameStorage::performLoading(const QDir & _directory)
 {
     m_base_directory = _directory.absolutePath();
-    loadDirectory(MediaType::CD);
-    loadDirectory(MediaType::DVD);
+    // Only the images that are still present are kept
+    QHash<QString, DirectoryGameImage> known_images;
+    known_images.swap(m_known_images);
+    loadDirectory(MediaType::CD, known_images);
+    loadDirectory(MediaType::DVD, known_images);
     return true;
 }
 
-void DirectoryGameStorage::loadDirectory(MediaType _media_type)
+void DirectoryGameStorage::loadDirectory(MediaType _media_type, const QHash<QString, DirectoryGameImage> & _known_images)
 {
     QDir base_directory(m_base_directory);
     if(!base_directory.cd(_media_type == MediaType::CD ? cd_directory : dvd_directory))
         return;
-    for(const QString & iso : base_directory.entryList({ "*.iso" }))
+    for(const QFileInfo & iso_info : base_directory.entryInfoList({ "*.iso" }, QDir::Files))
     {
-        Device image(QSharedPointer<DeviceSource>(new Iso9660DeviceSource(base_directory.absoluteFilePath(iso))));
-        if(!image.init())
-            break;
-        Game * game = createGame(image.gameId());
+        if(isLoadingCanceled())
+            return;
+        const QString filepath = iso_info.absoluteFilePath();
+        const qint64 mtime = iso_info.lastModified().toMSecsSinceEpoch();
+        QString game_id;
+        auto known_image = _known_images.constFind(filepath);
+        if(known_image != _known_images.cend() && known_image->size == iso_info.size() && known_image->mtime == mtime)
+        {
+            // The image has not been changed since it was probed
+            game_id = known_image->game_id;
+        }
+        else
+        {
+            Device image(QSharedPointer<DeviceSource>(new Iso9660DeviceSource(filepath)));
+            if(!image.init())
+                break;
+            game_id = image.gameId();
+        }
+        m_known_images[filepath] = DirectoryGameImage { filepath, game_id, iso_info.size(), mtime };
+        Game * game = createGame(game_id);
         game->setMediaType(_media_type);
         game->setPartCount(1);
-        QString title = QFileInfo(image.filepath()).fileName();
+        QString title = iso_info.fileName();
         title = title.left(title.lastIndexOf('.'));
-        if(title.startsWith(image.gameId()))
-            game->setTitle(title.right(title.size() - image.gameId().size() - 1));
+        if(title.startsWith(game_id))
+            game->setTitle(title.right(title.size() - game_id.size() - 1));
         else
             game->setTitle(title);
     }
 }
 
+void DirectoryGameStorage::performRestoring(const QDir & _directory)
+{
+    m_base_directory = _directory.absolutePath();
+}
+
+void DirectoryGameStorage::setKnownImages(const QList<DirectoryGameImage> & _images)
+{
+    m_known_images.clear();
+    for(const DirectoryGameImage & image : _images)
+        m_known_images.insert(image.filepath, image);
+}
+
+QList<DirectoryGameImage> DirectoryGameStorage::knownImages() const
+{
+    return m_known_images.values();
+}
+
 bool DirectoryGameStorage::performRenaming(const Game & _game, const QString & _title)
 {
     validateTitle(_title);
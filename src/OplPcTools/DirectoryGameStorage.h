@@ -19,7 +19,9 @@
 #ifndef __OPLPCTOOLS_DIRECTORYGAMESTORAGE__
 #define __OPLPCTOOLS_DIRECTORYGAMESTORAGE__
 
+#include <QHash>
 #include <OplPcTools/GameStorage.h>
+#include <OplPcTools/GameCollectionSnapshot.h>
 
 namespace OplPcTools {
 
@@ -30,6 +32,8 @@ class DirectoryGameStorage final : public GameStorage
 public:
     explicit DirectoryGameStorage(QObject * _parent = nullptr);
     GameInstallationType installationType() const override;
+    void setKnownImages(const QList<DirectoryGameImage> & _images);
+    QList<DirectoryGameImage> knownImages() const;
 
     static void validateTitle(const QString & _title);
     static QString makeIsoFilename(const QString & _title, const QString & _id);
@@ -42,15 +46,17 @@ public:
 
 protected:
     bool performLoading(const QDir & _directory) override;
+    void performRestoring(const QDir & _directory) override;
     bool performRenaming(const Game & _game, const QString & _title) override;
     bool performRegistration(const Game & _game) override;
     bool performDeletion(const Game & _game) override;
 
 private:
-    void loadDirectory(MediaType _media_type);
+    void loadDirectory(MediaType _media_type, const QHash<QString, DirectoryGameImage> & _known_images);
 
 private:
     QString m_base_directory;
+    QHash<QString, DirectoryGameImage> m_known_images;
 };
 
 } // namespace OplPcTools
@@ -0,0 +1,480 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <QSet>
+#include <QQueue>
+#include <QFileInfo>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/Iso9660Structures.h>
+#include <OplPcTools/DummyStrippingDeviceSource.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const quint32 g_block_size = 2048;
+const qint32 g_max_directory_size = 16777216;
+const int g_max_descriptor_count = 64;
+
+struct DirectoryEntry
+{
+    int offset; // Offset of the record in the directory data
+    Iso9660File file;
+    bool is_directory;
+    bool is_self_or_parent;
+};
+
+struct Directory
+{
+    QString path;
+    quint32 location;
+    QByteArray data;
+    QList<DirectoryEntry> entries;
+};
+
+inline quint32 blockCount(quint32 _size)
+{
+    return (_size + g_block_size - 1) / g_block_size;
+}
+
+bool readVolumeDescriptors(DeviceSource & _source, PrimaryVolumeDescriptor & _descriptor, bool & _has_supplementary)
+{
+    _has_supplementary = false;
+    bool has_primary = false;
+    if(!_source.seek(ISO9660_OFFSET))
+        return false;
+    QByteArray buffer(sizeof(VolumeDescriptor), Qt::Uninitialized);
+    for(int i = 0; i < g_max_descriptor_count; ++i)
+    {
+        if(_source.read(buffer) != sizeof(VolumeDescriptor))
+            return false;
+        const VolumeDescriptor * descriptor = reinterpret_cast<const VolumeDescriptor *>(buffer.constData());
+        if(strncmp("CD001", descriptor->id, 5))
+            return false;
+        switch(descriptor->type)
+        {
+        case VolumeDescriptorType::PrimaryVolumeDescriptor:
+            if(!has_primary)
+                memcpy(&_descriptor, descriptor, sizeof(VolumeDescriptor));
+            has_primary = true;
+            break;
+        case VolumeDescriptorType::SupplementaryVolumeDescriptor:
+            _has_supplementary = true;
+            break;
+        case VolumeDescriptorType::VolumeDescriptorSetTerminator:
+            return has_primary && _descriptor.block_size == static_cast<qint16>(g_block_size);
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
+QString recordFilename(const FileRecord * _record)
+{
+    QString name = QString::fromLatin1(_record->filename, _record->filename_length);
+    const int version_index = name.lastIndexOf(';');
+    if(version_index >= 0)
+        name.truncate(version_index);
+    if(name.endsWith('.'))
+        name.chop(1);
+    return name;
+}
+
+bool readDirectory(DeviceSource & _source, Directory & _directory, qint32 _size)
+{
+    if(_size <= 0 || _size > g_max_directory_size)
+        return false;
+    if(!_source.seek(static_cast<qint64>(_directory.location) * g_block_size))
+        return false;
+    _directory.data.resize(_size);
+    if(_source.read(_directory.data) != _size)
+        return false;
+    for(int processed = 0; processed < _size;)
+    {
+        const FileRecord * record = reinterpret_cast<const FileRecord *>(_directory.data.constData() + processed);
+        const quint8 record_length = static_cast<quint8>(record->record_length);
+        if(record_length == 0)
+        {
+            // Records never cross a block boundary, the rest of the block is padding.
+            processed = (processed / g_block_size + 1) * g_block_size;
+            continue;
+        }
+        if(record_length < sizeof(FileRecord) || processed + record_length > _size)
+            return false;
+        DirectoryEntry entry;
+        entry.offset = processed;
+        entry.is_directory = record->file_flags.directory;
+        entry.is_self_or_parent = record->filename_length == 1 && static_cast<quint8>(record->filename[0]) <= 1;
+        entry.file.location = static_cast<quint32>(static_cast<qint32>(record->extent_location));
+        entry.file.size = static_cast<quint32>(static_cast<qint32>(record->data_length));
+        if(!entry.is_self_or_parent)
+            entry.file.path = _directory.path + '/' + recordFilename(record);
+        _directory.entries.append(entry);
+        processed += record_length;
+    }
+    return true;
+}
+
+bool readDirectoryTree(DeviceSource & _source, const PrimaryVolumeDescriptor & _descriptor, QList<Directory> & _directories)
+{
+    QSet<quint32> visited_directories;
+    QQueue<QPair<Directory, qint32>> queue;
+    Directory root;
+    root.location = static_cast<quint32>(static_cast<qint32>(_descriptor.root_directory.extent_location));
+    queue.enqueue(qMakePair(root, static_cast<qint32>(_descriptor.root_directory.data_length)));
+    visited_directories.insert(root.location);
+    while(!queue.isEmpty())
+    {
+        QPair<Directory, qint32> item = queue.dequeue();
+        Directory & directory = item.first;
+        if(!readDirectory(_source, directory, item.second))
+            return false;
+        for(const DirectoryEntry & entry : directory.entries)
+        {
+            if(!entry.is_directory || entry.is_self_or_parent || visited_directories.contains(entry.file.location))
+                continue;
+            visited_directories.insert(entry.file.location);
+            Directory subdirectory;
+            subdirectory.path = entry.file.path;
+            subdirectory.location = entry.file.location;
+            queue.enqueue(qMakePair(subdirectory, static_cast<qint32>(entry.file.size)));
+        }
+        _directories.append(directory);
+    }
+    return true;
+}
+
+bool isOverlapping(const QPair<quint32, quint32> & _extent, const QVector<QPair<quint32, quint32>> & _extents)
+{
+    for(const QPair<quint32, quint32> & extent : _extents)
+    {
+        if(_extent.first < extent.second && extent.first < _extent.second)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+DummyStrippingDeviceSource::DummyStrippingDeviceSource(QSharedPointer<DeviceSource> _source, const QStringList & _dummy_filepaths) :
+    m_source_ptr(_source),
+    m_dummy_filepaths(_dummy_filepaths),
+    m_is_layout_built(false),
+    m_position(0)
+{
+}
+
+QList<Iso9660File> DummyStrippingDeviceSource::listFiles(DeviceSource & _source)
+{
+    OPT_TRACE_SCOPE("DummyStrippingDeviceSource::listFiles");
+    QList<Iso9660File> files;
+    PrimaryVolumeDescriptor descriptor;
+    bool has_supplementary = false;
+    QList<Directory> directories;
+    if(!readVolumeDescriptors(_source, descriptor, has_supplementary) ||
+        !readDirectoryTree(_source, descriptor, directories))
+    {
+        return files;
+    }
+    for(const Directory & directory : directories)
+    {
+        for(const DirectoryEntry & entry : directory.entries)
+        {
+            if(!entry.is_directory && !entry.is_self_or_parent)
+                files.append(entry.file);
+        }
+    }
+    return files;
+}
+
+bool DummyStrippingDeviceSource::isDummyFile(const Iso9660File & _file)
+{
+    const QString filename = QFileInfo(_file.path).fileName();
+    return filename.contains("DUMMY", Qt::CaseInsensitive) || filename.startsWith("PADDING", Qt::CaseInsensitive);
+}
+
+QString DummyStrippingDeviceSource::filepath() const
+{
+    return m_source_ptr->filepath();
+}
+
+bool DummyStrippingDeviceSource::isReadOnly() const
+{
+    // The rebuilt image exists only while it is read, there is no file to move
+    return true;
+}
+
+bool DummyStrippingDeviceSource::open()
+{
+    if(!m_source_ptr->isOpen() && !m_source_ptr->open())
+        return false;
+    if(!m_is_layout_built)
+        m_is_layout_built = buildLayout();
+    if(!m_is_layout_built)
+    {
+        m_source_ptr->close();
+        return false;
+    }
+    m_position = 0;
+    return true;
+}
+
+bool DummyStrippingDeviceSource::isOpen() const
+{
+    return m_source_ptr->isOpen();
+}
+
+void DummyStrippingDeviceSource::close()
+{
+    m_source_ptr->close();
+}
+
+bool DummyStrippingDeviceSource::buildLayout()
+{
+    OPT_TRACE_SCOPE("DummyStrippingDeviceSource::buildLayout");
+    PrimaryVolumeDescriptor descriptor;
+    bool has_supplementary = false;
+    QList<Directory> directories;
+    if(!readVolumeDescriptors(*m_source_ptr, descriptor, has_supplementary) || has_supplementary ||
+        !readDirectoryTree(*m_source_ptr, descriptor, directories))
+    {
+        return false;
+    }
+    QSet<QString> dummy_filepaths;
+    for(const QString & path : m_dummy_filepaths)
+        dummy_filepaths.insert(path.toUpper());
+    const quint32 path_table_size = static_cast<quint32>(static_cast<qint32>(descriptor.path_table_size));
+    const quint32 path_table_locations[] =
+    {
+        qFromLittleEndian<quint32>(descriptor.path_table_location_le),
+        qFromLittleEndian<quint32>(descriptor.optional_path_table_location_le),
+        qFromBigEndian<quint32>(descriptor.path_table_location_be),
+        qFromBigEndian<quint32>(descriptor.optional_path_table_location_be)
+    };
+    QVector<QPair<quint32, quint32>> kept_extents;
+    QVector<QPair<quint32, quint32>> dummy_extents;
+    kept_extents.append(qMakePair(0u, ISO9660_OFFSET / g_block_size + 1));
+    for(quint32 location : path_table_locations)
+    {
+        if(location != 0)
+            kept_extents.append(qMakePair(location, location + blockCount(path_table_size)));
+    }
+    for(const Directory & directory : directories)
+    {
+        kept_extents.append(qMakePair(directory.location, directory.location + blockCount(directory.data.size())));
+        for(const DirectoryEntry & entry : directory.entries)
+        {
+            if(entry.is_directory || entry.is_self_or_parent || entry.file.size == 0)
+                continue;
+            const QPair<quint32, quint32> extent(entry.file.location, entry.file.location + blockCount(entry.file.size));
+            if(dummy_filepaths.contains(entry.file.path.toUpper()))
+                dummy_extents.append(extent);
+            else
+                kept_extents.append(extent);
+        }
+    }
+    // An extent shared with anything that stays must stay as well
+    m_dropped_extents.clear();
+    for(const QPair<quint32, quint32> & extent : dummy_extents)
+    {
+        if(!isOverlapping(extent, kept_extents))
+            m_dropped_extents.append(extent);
+    }
+    std::sort(m_dropped_extents.begin(), m_dropped_extents.end());
+    QVector<QPair<quint32, quint32>> merged_extents;
+    for(const QPair<quint32, quint32> & extent : m_dropped_extents)
+    {
+        if(!merged_extents.isEmpty() && extent.first <= merged_extents.last().second)
+            merged_extents.last().second = qMax(merged_extents.last().second, extent.second);
+        else
+            merged_extents.append(extent);
+    }
+    m_dropped_extents = merged_extents;
+    const quint32 source_block_count = static_cast<quint32>(static_cast<qint32>(descriptor.block_count));
+    m_segments.clear();
+    quint32 source_block = 0;
+    quint32 image_block = 0;
+    for(const QPair<quint32, quint32> & extent : m_dropped_extents)
+    {
+        if(extent.first >= source_block_count)
+            break;
+        if(extent.first > source_block)
+        {
+            m_segments.append({ image_block, source_block, extent.first - source_block });
+            image_block += extent.first - source_block;
+        }
+        source_block = qMin(extent.second, source_block_count);
+    }
+    if(source_block < source_block_count)
+    {
+        m_segments.append({ image_block, source_block, source_block_count - source_block });
+        image_block += source_block_count - source_block;
+    }
+    m_patched_blocks.clear();
+    for(Directory & directory : directories)
+    {
+        for(const DirectoryEntry & entry : directory.entries)
+        {
+            FileRecord * record = reinterpret_cast<FileRecord *>(directory.data.data() + entry.offset);
+            record->extent_location.setValue(static_cast<qint32>(mapBlock(entry.file.location)));
+            if(!entry.is_directory && entry.file.size > 0 && isDropped(entry.file.location))
+                record->data_length.setValue(0);
+        }
+        storePatchedBlocks(directory.location, directory.data);
+    }
+    for(int i = 0; i < 4; ++i)
+    {
+        if(path_table_locations[i] != 0 && !patchPathTable(path_table_locations[i], path_table_size, i >= 2))
+            return false;
+    }
+    descriptor.block_count.setValue(static_cast<qint32>(image_block));
+    descriptor.root_directory.extent_location.setValue(
+        static_cast<qint32>(mapBlock(static_cast<quint32>(static_cast<qint32>(descriptor.root_directory.extent_location)))));
+    descriptor.path_table_location_le = qToLittleEndian<qint32>(mapBlock(path_table_locations[0]));
+    descriptor.optional_path_table_location_le = qToLittleEndian<qint32>(mapBlock(path_table_locations[1]));
+    descriptor.path_table_location_be = qToBigEndian<qint32>(mapBlock(path_table_locations[2]));
+    descriptor.optional_path_table_location_be = qToBigEndian<qint32>(mapBlock(path_table_locations[3]));
+    storePatchedBlocks(ISO9660_OFFSET / g_block_size,
+        QByteArray(reinterpret_cast<const char *>(&descriptor), sizeof(PrimaryVolumeDescriptor)));
+    return true;
+}
+
+// Returns the location of the source block in the rebuilt image.
+// A dropped block is mapped to the location where the data after it starts.
+quint32 DummyStrippingDeviceSource::mapBlock(quint32 _source_block) const
+{
+    quint32 dropped_block_count = 0;
+    for(const QPair<quint32, quint32> & extent : m_dropped_extents)
+    {
+        if(extent.first >= _source_block)
+            break;
+        dropped_block_count += qMin(extent.second, _source_block) - extent.first;
+    }
+    return _source_block - dropped_block_count;
+}
+
+bool DummyStrippingDeviceSource::isDropped(quint32 _source_block) const
+{
+    for(const QPair<quint32, quint32> & extent : m_dropped_extents)
+    {
+        if(_source_block >= extent.first && _source_block < extent.second)
+            return true;
+    }
+    return false;
+}
+
+// Path table entry: identifier length (1), extended attribute length (1), location (4), parent number (2), identifier
+bool DummyStrippingDeviceSource::patchPathTable(quint32 _location, quint32 _size, bool _is_big_endian)
+{
+    if(_size == 0 || _size > static_cast<quint32>(g_max_directory_size))
+        return false;
+    QByteArray table(static_cast<int>(_size), Qt::Uninitialized);
+    if(!m_source_ptr->seek(static_cast<qint64>(_location) * g_block_size) || m_source_ptr->read(table) != table.size())
+        return false;
+    uchar * data = reinterpret_cast<uchar *>(table.data());
+    for(quint32 offset = 0; offset + 8 <= _size;)
+    {
+        const quint8 identifier_length = data[offset];
+        if(identifier_length == 0)
+            return false;
+        uchar * location = data + offset + 2;
+        if(_is_big_endian)
+            qToBigEndian(mapBlock(qFromBigEndian<quint32>(location)), location);
+        else
+            qToLittleEndian(mapBlock(qFromLittleEndian<quint32>(location)), location);
+        offset += 8 + identifier_length + (identifier_length & 1);
+    }
+    storePatchedBlocks(_location, table);
+    return true;
+}
+
+void DummyStrippingDeviceSource::storePatchedBlocks(quint32 _location, const QByteArray & _data)
+{
+    // The tail of the last block is kept from the source, a patch may cover only a part of a block
+    for(int offset = 0; offset < _data.size(); offset += g_block_size)
+        m_patched_blocks.insert(_location + offset / g_block_size, _data.mid(offset, g_block_size));
+}
+
+bool DummyStrippingDeviceSource::seek(qint64 _offset)
+{
+    if(_offset < 0 || !m_is_layout_built)
+        return false;
+    m_position = _offset;
+    return true;
+}
+
+qint64 DummyStrippingDeviceSource::read(QByteArray & _buffer)
+{
+    qint64 total_read_bytes = 0;
+    while(total_read_bytes < _buffer.size())
+    {
+        const quint32 image_block = static_cast<quint32>(m_position / g_block_size);
+        auto segment = std::upper_bound(m_segments.cbegin(), m_segments.cend(), image_block,
+            [](quint32 _block, const Segment & _segment) { return _block < _segment.image_block; });
+        if(segment == m_segments.cbegin())
+            break;
+        --segment;
+        const qint64 segment_end = static_cast<qint64>(segment->image_block + segment->block_count) * g_block_size;
+        if(m_position >= segment_end)
+            break;
+        const quint64 source_offset = static_cast<quint64>(segment->source_block) * g_block_size +
+            (m_position - static_cast<qint64>(segment->image_block) * g_block_size);
+        const qint64 size = qMin(segment_end - m_position, _buffer.size() - total_read_bytes);
+        if(!m_source_ptr->seek(source_offset))
+            return total_read_bytes > 0 ? total_read_bytes : -1;
+        qint64 read_bytes = 0;
+        char * data = _buffer.data() + total_read_bytes;
+        if(size == _buffer.size())
+        {
+            // The whole request is inside one segment, no intermediate copy is needed
+            read_bytes = m_source_ptr->read(_buffer);
+        }
+        else
+        {
+            m_buffer.resize(static_cast<int>(size));
+            read_bytes = m_source_ptr->read(m_buffer);
+            if(read_bytes > 0)
+                memcpy(data, m_buffer.constData(), read_bytes);
+        }
+        if(read_bytes < 0)
+            return total_read_bytes > 0 ? total_read_bytes : -1;
+        applyPatches(source_offset, data, read_bytes);
+        total_read_bytes += read_bytes;
+        m_position += read_bytes;
+        if(read_bytes < size)
+            break;
+    }
+    return total_read_bytes;
+}
+
+void DummyStrippingDeviceSource::applyPatches(quint64 _source_offset, char * _data, qint64 _size) const
+{
+    const quint64 end_offset = _source_offset + _size;
+    for(auto it = m_patched_blocks.lowerBound(static_cast<quint32>(_source_offset / g_block_size));
+        it != m_patched_blocks.cend() && static_cast<quint64>(it.key()) * g_block_size < end_offset; ++it)
+    {
+        const quint64 patch_offset = static_cast<quint64>(it.key()) * g_block_size;
+        const quint64 begin = qMax(patch_offset, _source_offset);
+        const quint64 end = qMin(patch_offset + it.value().size(), end_offset);
+        if(begin < end)
+            memcpy(_data + (begin - _source_offset), it.value().constData() + (begin - patch_offset), end - begin);
+    }
+}
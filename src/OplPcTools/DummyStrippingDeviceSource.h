@@ -0,0 +1,102 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_DUMMYSTRIPPINGDEVICESOURCE__
+#define __OPLPCTOOLS_DUMMYSTRIPPINGDEVICESOURCE__
+
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <OplPcTools/DeviceSource.h>
+
+namespace OplPcTools {
+
+struct Iso9660File
+{
+    QString path; // Absolute path without the version suffix, e.g. "/DATA/DUMMY.BIN"
+    quint32 location;
+    quint32 size;
+};
+
+/*
+ * A disc image without the selected padding files.
+ * The files are cut to zero length and every extent after them moves back by the freed blocks.
+ * Directory records, path tables and the primary volume descriptor are rewritten on the fly while reading,
+ * so the rebuilt image is streamed straight into the installation without a temporary copy.
+ * Only the ISO 9660 structures are rewritten: images with Joliet descriptors are rejected,
+ * the UDF structures of bridge discs are left as they are.
+ */
+class DummyStrippingDeviceSource : public DeviceSource
+{
+    Q_DISABLE_COPY(DummyStrippingDeviceSource)
+
+public:
+    DummyStrippingDeviceSource(QSharedPointer<DeviceSource> _source, const QStringList & _dummy_filepaths);
+    static QList<Iso9660File> listFiles(DeviceSource & _source);
+    static bool isDummyFile(const Iso9660File & _file);
+    inline const QSharedPointer<DeviceSource> & originalSource() const;
+    inline const QStringList & dummyFilepaths() const;
+    QString filepath() const override;
+    bool isReadOnly() const override;
+    bool open() override;
+    bool isOpen() const override;
+    void close() override;
+    bool seek(qint64 _offset) override;
+    qint64 read(QByteArray & _buffer) override;
+
+private:
+    struct Segment
+    {
+        quint32 image_block;
+        quint32 source_block;
+        quint32 block_count;
+    };
+
+private:
+    bool buildLayout();
+    quint32 mapBlock(quint32 _source_block) const;
+    bool isDropped(quint32 _source_block) const;
+    bool patchPathTable(quint32 _location, quint32 _size, bool _is_big_endian);
+    void storePatchedBlocks(quint32 _location, const QByteArray & _data);
+    void applyPatches(quint64 _source_offset, char * _data, qint64 _size) const;
+
+private:
+    QSharedPointer<DeviceSource> m_source_ptr;
+    QStringList m_dummy_filepaths;
+    bool m_is_layout_built;
+    QVector<QPair<quint32, quint32>> m_dropped_extents; // Sorted and merged ranges of the source blocks
+    QVector<Segment> m_segments;
+    QMap<quint32, QByteArray> m_patched_blocks; // Rewritten blocks by their source location
+    qint64 m_position;
+    QByteArray m_buffer;
+};
+
+const QSharedPointer<DeviceSource> & DummyStrippingDeviceSource::originalSource() const
+{
+    return m_source_ptr;
+}
+
+const QStringList & DummyStrippingDeviceSource::dummyFilepaths() const
+{
+    return m_dummy_filepaths;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_DUMMYSTRIPPINGDEVICESOURCE__
@@ -0,0 +1,208 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <limits>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/DuplicateFinder.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const int g_max_thread_count = 4;
+
+struct SearchContext
+{
+    DuplicateFinder * finder;
+    ImageHashCache * cache;
+    QAtomicInt * is_canceled;
+    QAtomicInt processed;
+    int total;
+    int last_reported_percent;
+    QMutex mutex;
+    QList<DuplicateImage> images;
+    QHash<QByteArray, int> content_hashes; // Index of the group by the content hash of its images
+    DuplicateSearchResult result;
+};
+
+class HashingTask final
+{
+public:
+    HashingTask(SearchContext & _context, QSharedPointer<const Game> _game, const QStringList & _filepaths);
+    void run();
+
+private:
+    void reportProgress();
+
+private:
+    SearchContext & mr_context;
+    QSharedPointer<const Game> m_game_ptr;
+    QStringList m_filepaths;
+};
+
+} // namespace
+
+HashingTask::HashingTask(SearchContext & _context, QSharedPointer<const Game> _game, const QStringList & _filepaths) :
+    mr_context(_context),
+    m_game_ptr(_game),
+    m_filepaths(_filepaths)
+{
+}
+
+void HashingTask::run()
+{
+    if(mr_context.is_canceled->load() == 0)
+    {
+        ImageHash image_hash;
+        QString error;
+        const bool is_cached = mr_context.cache->find(m_filepaths, image_hash);
+        if(is_cached || ImageHashCache::computeHash(m_filepaths, *mr_context.is_canceled, image_hash, error))
+        {
+            if(!is_cached)
+                mr_context.cache->insert(image_hash);
+            DuplicateImage image;
+            image.game = m_game_ptr;
+            image.filepaths = m_filepaths;
+            image.size = 0;
+            for(qint64 size : image_hash.sizes)
+                image.size += size;
+            image.full_hash = image_hash.full_hash;
+            QMutexLocker locker(&mr_context.mutex);
+            if(is_cached)
+                ++mr_context.result.cached;
+            else
+                ++mr_context.result.hashed;
+            auto it = mr_context.content_hashes.constFind(image_hash.content_hash);
+            if(it == mr_context.content_hashes.cend())
+            {
+                mr_context.content_hashes.insert(image_hash.content_hash, mr_context.result.groups.count());
+                mr_context.result.groups.append(DuplicateGroup { image_hash.content_hash, { image } });
+            }
+            else
+            {
+                mr_context.result.groups[*it].images.append(image);
+            }
+        }
+        else if(!error.isEmpty())
+        {
+            QMutexLocker locker(&mr_context.mutex);
+            mr_context.result.errors.append(error);
+        }
+    }
+    reportProgress();
+}
+
+void HashingTask::reportProgress()
+{
+    int processed = mr_context.processed.fetchAndAddOrdered(1) + 1;
+    int percent = static_cast<int>(static_cast<qint64>(processed) * 100 / mr_context.total);
+    {
+        QMutexLocker locker(&mr_context.mutex);
+        if(percent == mr_context.last_reported_percent && processed != mr_context.total)
+            return;
+        mr_context.last_reported_percent = percent;
+    }
+    emit mr_context.finder->progress(processed, mr_context.total);
+}
+
+bool DuplicateGroup::isIdentical() const
+{
+    for(const DuplicateImage & image : images)
+    {
+        if(image.full_hash != images.first().full_hash)
+            return false;
+    }
+    return true;
+}
+
+// Space freed by keeping only the smallest image of the group
+quint64 DuplicateGroup::reclaimableSize() const
+{
+    quint64 total_size = 0;
+    quint64 min_size = std::numeric_limits<quint64>::max();
+    for(const DuplicateImage & image : images)
+    {
+        total_size += image.size;
+        min_size = qMin(min_size, image.size);
+    }
+    return images.isEmpty() ? 0 : total_size - min_size;
+}
+
+DuplicateFinder::DuplicateFinder(const GameCollection & _collection, ImageHashCache & _cache, QObject * _parent /*= nullptr*/) :
+    QObject(_parent),
+    mr_collection(_collection),
+    mr_cache(_cache),
+    m_is_canceled(0)
+{
+}
+
+void DuplicateFinder::cancel()
+{
+    m_is_canceled.store(1);
+}
+
+DuplicateSearchResult DuplicateFinder::find()
+{
+    OPT_TRACE_SCOPE("DuplicateFinder::find");
+    m_is_canceled.store(0);
+    const GameListPointer games = mr_collection.games();
+    if(games->isEmpty())
+        return DuplicateSearchResult();
+    QList<QStringList> all_filepaths;
+    SearchContext context;
+    context.finder = this;
+    context.cache = &mr_cache;
+    context.is_canceled = &m_is_canceled;
+    context.total = games->count();
+    context.last_reported_percent = -1;
+    // The images are usually on one drive, more readers would only make it seek.
+    // The jobs form this number of chains, each job waits for the one submitted that many jobs before it.
+    const int chain_count = qMin(g_max_thread_count, QThread::idealThreadCount());
+    const IoPolicy io_policy = Settings::instance().ioPolicy();
+    QList<JobPointer> jobs;
+    for(const QSharedPointer<const Game> & game : *games)
+    {
+        const QStringList filepaths = GameCollection::gameFiles(mr_collection.directory(), *game);
+        all_filepaths.append(filepaths);
+        HashingTask task(context, game, filepaths);
+        JobPointer job = Job::create(JobKind::Io, [task]() mutable { task.run(); });
+        job->setIoPolicy(io_policy);
+        if(jobs.count() >= chain_count)
+            job->addDependency(jobs[jobs.count() - chain_count]);
+        jobs.append(job);
+        JobScheduler::instance().submit(job);
+    }
+    for(const JobPointer & job : jobs)
+        job->wait();
+    if(m_is_canceled.load() == 0)
+        mr_cache.retain(all_filepaths);
+    QList<DuplicateGroup> & groups = context.result.groups;
+    groups.erase(std::remove_if(groups.begin(), groups.end(), [](const DuplicateGroup & _group) {
+        return _group.images.count() < 2;
+    }), groups.end());
+    std::sort(groups.begin(), groups.end(), [](const DuplicateGroup & _left, const DuplicateGroup & _right) {
+        return _left.reclaimableSize() > _right.reclaimableSize();
+    });
+    return context.result;
+}
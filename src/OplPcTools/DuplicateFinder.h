@@ -0,0 +1,90 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_DUPLICATEFINDER__
+#define __OPLPCTOOLS_DUPLICATEFINDER__
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <OplPcTools/GameCollection.h>
+#include <OplPcTools/ImageHashCache.h>
+
+namespace OplPcTools {
+
+struct DuplicateImage
+{
+    QSharedPointer<const Game> game;
+    QStringList filepaths;
+    quint64 size;
+    QByteArray full_hash;
+};
+
+// Images with the same content, they may differ only by the padding after the last file
+struct DuplicateGroup
+{
+    QByteArray content_hash;
+    QList<DuplicateImage> images;
+
+    bool isIdentical() const;
+    quint64 reclaimableSize() const;
+};
+
+struct DuplicateSearchResult
+{
+    DuplicateSearchResult() :
+        hashed(0),
+        cached(0)
+    {
+    }
+
+    QList<DuplicateGroup> groups;
+    int hashed;
+    int cached;
+    QStringList errors;
+};
+
+/*
+ * Finds the games installed more than once in both storages regardless of their IDs and titles.
+ * The parts of a UL game are read as one image. The content hash covers the image up to the end of its last
+ * file system extent with the declared volume size masked, so a trimmed copy matches the original one.
+ * find() blocks until all the images are hashed by the I/O jobs of the JobScheduler, which carry the I/O policy
+ * of the settings. The progress signal is emitted from the worker threads. Only the images missing in the cache
+ * are read. find() must not be called from an I/O job.
+ */
+class DuplicateFinder final : public QObject
+{
+    Q_OBJECT
+
+public:
+    DuplicateFinder(const GameCollection & _collection, ImageHashCache & _cache, QObject * _parent = nullptr);
+    DuplicateSearchResult find();
+    void cancel();
+
+signals:
+    void progress(int _processed, int _total);
+
+private:
+    const GameCollection & mr_collection;
+    ImageHashCache & mr_cache;
+    QAtomicInt m_is_canceled;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_DUPLICATEFINDER__
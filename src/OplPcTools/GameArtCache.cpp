@@ -0,0 +1,246 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <OplPcTools/GameArtCache.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+// Enough for ~2000 icons and ~150 front covers
+const qint64 g_default_icon_budget = 32 * 1024 * 1024;
+const qint64 g_default_front_budget = 16 * 1024 * 1024;
+const qint64 g_default_budget = 8 * 1024 * 1024;
+
+// Accounts for the key and the bookkeeping of entries that hold no pixels
+const qint64 g_entry_overhead = 128;
+
+qint64 defaultBudget(GameArtType _type)
+{
+    switch(_type)
+    {
+    case GameArtType::Icon:
+        return g_default_icon_budget;
+    case GameArtType::Front:
+        return g_default_front_budget;
+    default:
+        return g_default_budget;
+    }
+}
+
+} // namespace
+
+struct GameArtCache::Entry
+{
+    Key key;
+    QPixmap pixmap;
+    qint64 cost;
+    Entry * prev;
+    Entry * next;
+};
+
+struct GameArtCache::Bucket
+{
+    Entry * head;
+    Entry * tail;
+    qint64 budget;
+    qint64 used;
+    int count;
+    quint64 hits;
+    quint64 misses;
+    quint64 evictions;
+};
+
+GameArtCache::GameArtCache()
+{
+}
+
+GameArtCache::~GameArtCache()
+{
+    clear();
+    for(Bucket * bucket : m_buckets)
+        delete bucket;
+}
+
+GameArtCache::Bucket & GameArtCache::bucket(GameArtType _type)
+{
+    Bucket *& bucket = m_buckets[_type];
+    if(bucket == nullptr)
+        bucket = new Bucket { nullptr, nullptr, defaultBudget(_type), 0, 0, 0, 0, 0 };
+    return *bucket;
+}
+
+void GameArtCache::setBudget(GameArtType _type, qint64 _bytes)
+{
+    Bucket & type_bucket = bucket(_type);
+    type_bucket.budget = qMax<qint64>(0, _bytes);
+    evict(type_bucket);
+}
+
+qint64 GameArtCache::budget(GameArtType _type) const
+{
+    const Bucket * type_bucket = m_buckets.value(_type);
+    return type_bucket ? type_bucket->budget : defaultBudget(_type);
+}
+
+qint64 GameArtCache::cost(const QPixmap & _pixmap)
+{
+    if(_pixmap.isNull())
+        return g_entry_overhead;
+    return static_cast<qint64>(_pixmap.width()) * _pixmap.height() * _pixmap.depth() / 8 + g_entry_overhead;
+}
+
+const QPixmap * GameArtCache::find(const QString & _game_id, GameArtType _type)
+{
+    Bucket & type_bucket = bucket(_type);
+    Entry * entry = m_entries.value(Key { _game_id, _type });
+    if(entry == nullptr)
+    {
+        ++type_bucket.misses;
+        return nullptr;
+    }
+    ++type_bucket.hits;
+    if(type_bucket.head != entry)
+    {
+        unlink(type_bucket, entry);
+        pushFront(type_bucket, entry);
+    }
+    return &entry->pixmap;
+}
+
+void GameArtCache::insert(const QString & _game_id, GameArtType _type, const QPixmap & _pixmap)
+{
+    Bucket & type_bucket = bucket(_type);
+    Key key { _game_id, _type };
+    Entry * entry = m_entries.value(key);
+    if(entry)
+        erase(type_bucket, entry);
+    qint64 entry_cost = cost(_pixmap);
+    if(entry_cost > type_bucket.budget)
+        return;
+    entry = new Entry { key, _pixmap, entry_cost, nullptr, nullptr };
+    m_entries.insert(key, entry);
+    pushFront(type_bucket, entry);
+    type_bucket.used += entry_cost;
+    ++type_bucket.count;
+    evict(type_bucket);
+}
+
+void GameArtCache::remove(const QString & _game_id, GameArtType _type)
+{
+    Entry * entry = m_entries.value(Key { _game_id, _type });
+    if(entry)
+        erase(bucket(_type), entry);
+}
+
+void GameArtCache::remove(const QString & _game_id)
+{
+    for(auto it = m_buckets.cbegin(); it != m_buckets.cend(); ++it)
+    {
+        Entry * entry = m_entries.value(Key { _game_id, it.key() });
+        if(entry)
+            erase(*it.value(), entry);
+    }
+}
+
+void GameArtCache::clear(GameArtType _type)
+{
+    Bucket & type_bucket = bucket(_type);
+    while(type_bucket.tail)
+        erase(type_bucket, type_bucket.tail);
+}
+
+void GameArtCache::clear()
+{
+    for(GameArtType type : m_buckets.keys())
+        clear(type);
+}
+
+void GameArtCache::unlink(Bucket & _bucket, Entry * _entry)
+{
+    if(_entry->prev)
+        _entry->prev->next = _entry->next;
+    else
+        _bucket.head = _entry->next;
+    if(_entry->next)
+        _entry->next->prev = _entry->prev;
+    else
+        _bucket.tail = _entry->prev;
+    _entry->prev = nullptr;
+    _entry->next = nullptr;
+}
+
+void GameArtCache::pushFront(Bucket & _bucket, Entry * _entry)
+{
+    _entry->prev = nullptr;
+    _entry->next = _bucket.head;
+    if(_bucket.head)
+        _bucket.head->prev = _entry;
+    _bucket.head = _entry;
+    if(_bucket.tail == nullptr)
+        _bucket.tail = _entry;
+}
+
+void GameArtCache::erase(Bucket & _bucket, Entry * _entry)
+{
+    unlink(_bucket, _entry);
+    m_entries.remove(_entry->key);
+    _bucket.used -= _entry->cost;
+    --_bucket.count;
+    delete _entry;
+}
+
+void GameArtCache::evict(Bucket & _bucket)
+{
+    while(_bucket.used > _bucket.budget && _bucket.tail)
+    {
+        erase(_bucket, _bucket.tail);
+        ++_bucket.evictions;
+    }
+}
+
+GameArtCache::Statistics GameArtCache::statistics(GameArtType _type) const
+{
+    const Bucket * type_bucket = m_buckets.value(_type);
+    if(type_bucket == nullptr)
+        return Statistics { 0, 0, 0, 0, defaultBudget(_type), 0 };
+    return Statistics
+    {
+        type_bucket->hits,
+        type_bucket->misses,
+        type_bucket->evictions,
+        type_bucket->used,
+        type_bucket->budget,
+        type_bucket->count
+    };
+}
+
+GameArtCache::Statistics GameArtCache::statistics() const
+{
+    Statistics total { 0, 0, 0, 0, 0, 0 };
+    for(const Bucket * type_bucket : m_buckets)
+    {
+        total.hits += type_bucket->hits;
+        total.misses += type_bucket->misses;
+        total.evictions += type_bucket->evictions;
+        total.used_bytes += type_bucket->used;
+        total.budget_bytes += type_bucket->budget;
+        total.count += type_bucket->count;
+    }
+    return total;
+}
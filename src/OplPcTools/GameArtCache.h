@@ -0,0 +1,96 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTCACHE__
+#define __OPLPCTOOLS_GAMEARTCACHE__
+
+#include <QHash>
+#include <QMap>
+#include <QPixmap>
+#include <QString>
+#include <OplPcTools/GameArtType.h>
+
+namespace OplPcTools {
+
+// LRU cache of decoded arts. Every art type has its own memory budget and LRU list,
+// so a few large backgrounds cannot push out thousands of icons.
+// A null pixmap can be cached as well: it means that the game has no art of that type.
+class GameArtCache final
+{
+    Q_DISABLE_COPY(GameArtCache)
+
+    struct Key
+    {
+        QString game_id;
+        GameArtType type;
+
+        inline bool operator == (const Key & _key) const
+        {
+            return type == _key.type && game_id == _key.game_id;
+        }
+
+        friend inline uint qHash(const Key & _key, uint _seed = 0)
+        {
+            return ::qHash(_key.game_id, _seed) ^ static_cast<uint>(_key.type);
+        }
+    };
+
+    struct Entry;
+    struct Bucket;
+
+public:
+    struct Statistics
+    {
+        quint64 hits;
+        quint64 misses;
+        quint64 evictions;
+        qint64 used_bytes;
+        qint64 budget_bytes;
+        int count;
+    };
+
+public:
+    GameArtCache();
+    ~GameArtCache();
+    void setBudget(GameArtType _type, qint64 _bytes);
+    qint64 budget(GameArtType _type) const;
+    const QPixmap * find(const QString & _game_id, GameArtType _type);
+    void insert(const QString & _game_id, GameArtType _type, const QPixmap & _pixmap);
+    void remove(const QString & _game_id, GameArtType _type);
+    void remove(const QString & _game_id);
+    void clear(GameArtType _type);
+    void clear();
+    Statistics statistics(GameArtType _type) const;
+    Statistics statistics() const;
+
+private:
+    Bucket & bucket(GameArtType _type);
+    void unlink(Bucket & _bucket, Entry * _entry);
+    void pushFront(Bucket & _bucket, Entry * _entry);
+    void erase(Bucket & _bucket, Entry * _entry);
+    void evict(Bucket & _bucket);
+    static qint64 cost(const QPixmap & _pixmap);
+
+private:
+    QHash<Key, Entry *> m_entries;
+    QMap<GameArtType, Bucket *> m_buckets;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTCACHE__
@@ -0,0 +1,103 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QBuffer>
+#include <QImageWriter>
+#include <QSet>
+#include <QVector>
+#include <OplPcTools/GameArtEncoder.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const int g_jpeg_quality = 88;
+const int g_max_palette_size = 256;
+
+bool isOpaque(const QImage & _image)
+{
+    if(!_image.hasAlphaChannel())
+        return true;
+    const QImage image = _image.convertToFormat(QImage::Format_ARGB32);
+    for(int y = 0; y < image.height(); ++y)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for(int x = 0; x < image.width(); ++x)
+        {
+            if(qAlpha(line[x]) != 255)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Returns the exact palette of the image or an empty vector if the image has too many colors
+QVector<QRgb> findPalette(const QImage & _image)
+{
+    QSet<QRgb> colors;
+    for(int y = 0; y < _image.height(); ++y)
+    {
+        const QRgb * line = reinterpret_cast<const QRgb *>(_image.constScanLine(y));
+        for(int x = 0; x < _image.width(); ++x)
+        {
+            colors.insert(line[x]);
+            if(colors.size() > g_max_palette_size)
+                return QVector<QRgb>();
+        }
+    }
+    return colors.toList().toVector();
+}
+
+QByteArray write(const QImage & _image, const char * _format, int _quality)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, _format);
+    // For PNG the quality is the inverse of the zlib compression level: 0 is the best compression
+    writer.setQuality(_quality);
+    if(!writer.write(_image))
+        return QByteArray();
+    return data;
+}
+
+QByteArray writePng(const QImage & _image)
+{
+    QVector<QRgb> palette = findPalette(_image);
+    if(palette.isEmpty())
+        return write(_image, "png", 0);
+    return write(_image.convertToFormat(QImage::Format_Indexed8, palette, Qt::ThresholdDither), "png", 0);
+}
+
+} // namespace
+
+EncodedGameArt OplPcTools::encodeGameArt(const QImage & _image, GameArtType _type)
+{
+    const bool opaque = isOpaque(_image);
+    const QImage converted = _image.convertToFormat(opaque ? QImage::Format_RGB32 : QImage::Format_ARGB32);
+    // An image without text keys, so no metadata goes to the output
+    const QImage image = QImage(converted.constBits(), converted.width(), converted.height(),
+        converted.bytesPerLine(), converted.format()).copy();
+    EncodedGameArt png { writePng(image), ".png" };
+    if(!opaque || _type == GameArtType::Icon)
+        return png;
+    EncodedGameArt jpeg { write(image, "jpg", g_jpeg_quality), ".jpg" };
+    if(jpeg.data.isEmpty() || (!png.data.isEmpty() && png.data.size() <= jpeg.data.size()))
+        return png;
+    return jpeg;
+}
@@ -0,0 +1,42 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTENCODER__
+#define __OPLPCTOOLS_GAMEARTENCODER__
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <OplPcTools/GameArtType.h>
+
+namespace OplPcTools {
+
+struct EncodedGameArt
+{
+    QByteArray data;
+    QString extension; // With the leading dot
+};
+
+// Encodes the art in the format that is the cheapest for OPL to read: PNG for icons and pictures with
+// transparency (palette-based when there are no more than 256 colors), otherwise the smaller of JPEG and PNG.
+// Metadata of the source image is not written.
+EncodedGameArt encodeGameArt(const QImage & _image, GameArtType _type);
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTENCODER__
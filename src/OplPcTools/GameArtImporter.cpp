@@ -0,0 +1,230 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameArtEncoder.h>
+#include <OplPcTools/GameArtImporter.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const QStringList g_image_extensions { "png", "jpg", "jpeg", "bmp" };
+
+struct ImportItem
+{
+    QString source_path;
+    QString game_id;
+    GameArtType type;
+};
+
+struct ImportContext
+{
+    GameArtImporter * importer;
+    const GameArtManager * manager;
+    QAtomicInt * is_canceled;
+    QAtomicInt processed;
+    int total;
+    int last_reported_percent;
+    QMutex mutex;
+    GameArtImportResult result;
+};
+
+class ImportTask final : public QRunnable
+{
+public:
+    ImportTask(ImportContext & _context, const ImportItem & _item);
+    void run() override;
+
+private:
+    void import();
+    void reportProgress();
+
+private:
+    ImportContext & mr_context;
+    ImportItem m_item;
+};
+
+} // namespace
+
+ImportTask::ImportTask(ImportContext & _context, const ImportItem & _item) :
+    mr_context(_context),
+    m_item(_item)
+{
+}
+
+void ImportTask::run()
+{
+    if(mr_context.is_canceled->load() == 0)
+        import();
+    reportProgress();
+}
+
+void ImportTask::import()
+{
+    OPT_TRACE_SCOPE("GameArtImporter::importFile");
+    const QSize size = mr_context.manager->artSize(m_item.type);
+    QImageReader reader(m_item.source_path);
+    QSize source_size = reader.size();
+    if(source_size.isValid() && source_size != size)
+        reader.setScaledSize(size);
+    QImage image = reader.read();
+    QString error;
+    if(image.isNull())
+    {
+        error = QObject::tr("Unable to read file \"%1\": %2").arg(m_item.source_path).arg(reader.errorString());
+    }
+    else
+    {
+        if(image.size() != size)
+            image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        try
+        {
+            mr_context.manager->writeArt(m_item.game_id, m_item.type, encodeGameArt(image, m_item.type));
+        }
+        catch(const Exception & exception)
+        {
+            error = exception.message();
+        }
+    }
+    QMutexLocker locker(&mr_context.mutex);
+    if(error.isEmpty())
+    {
+        ++mr_context.result.imported;
+        mr_context.result.arts[m_item.game_id] |= m_item.type;
+    }
+    else
+    {
+        ++mr_context.result.failed;
+        mr_context.result.errors.append(error);
+    }
+}
+
+void ImportTask::reportProgress()
+{
+    int processed = mr_context.processed.fetchAndAddOrdered(1) + 1;
+    int percent = static_cast<int>(static_cast<qint64>(processed) * 100 / mr_context.total);
+    {
+        // Thousands of queued signals would flood the receiver's event loop
+        QMutexLocker locker(&mr_context.mutex);
+        if(percent == mr_context.last_reported_percent && processed != mr_context.total)
+            return;
+        mr_context.last_reported_percent = percent;
+    }
+    emit mr_context.importer->progress(processed, mr_context.total);
+}
+
+GameArtImporter::GameArtImporter(const GameArtManager & _manager, QObject * _parent /*= nullptr*/) :
+    QObject(_parent),
+    mr_manager(_manager),
+    m_is_canceled(0)
+{
+}
+
+void GameArtImporter::setGameIds(const QSet<QString> & _game_ids)
+{
+    m_game_ids = _game_ids;
+}
+
+void GameArtImporter::cancel()
+{
+    m_is_canceled.store(1);
+}
+
+GameArtImportResult GameArtImporter::import(const QStringList & _paths)
+{
+    OPT_TRACE_SCOPE("GameArtImporter::import");
+    m_is_canceled.store(0);
+    QList<QPair<QString, GameArtType>> suffixes;
+    for(GameArtType type : mr_manager.artTypes())
+        suffixes.append(qMakePair(mr_manager.artSuffix(type), type));
+    // _COV2 must be tested before _COV
+    std::sort(suffixes.begin(), suffixes.end(), [](const QPair<QString, GameArtType> & _left, const QPair<QString, GameArtType> & _right) {
+        return _left.first.size() > _right.first.size();
+    });
+    GameArtImportResult result;
+    QMap<QPair<QString, int>, ImportItem> items;
+    auto matchFile = [&](const QFileInfo & _file_info) {
+        if(!g_image_extensions.contains(_file_info.suffix().toLower()))
+            return;
+        const QString basename = _file_info.completeBaseName();
+        for(const auto & suffix : suffixes)
+        {
+            if(!basename.endsWith(suffix.first, Qt::CaseInsensitive))
+                continue;
+            QString id = basename.left(basename.size() - suffix.first.size());
+            if(id.isEmpty() || (!m_game_ids.isEmpty() && !m_game_ids.contains(id)))
+                break;
+            auto key = qMakePair(id, static_cast<int>(suffix.second));
+            if(items.contains(key))
+                break;
+            items.insert(key, ImportItem { _file_info.absoluteFilePath(), id, suffix.second });
+            return;
+        }
+        ++result.skipped;
+    };
+    for(const QString & path : _paths)
+    {
+        QFileInfo path_info(path);
+        if(path_info.isDir())
+        {
+            QDirIterator it(path, QDir::Files, QDirIterator::Subdirectories | QDirIterator::FollowSymlinks);
+            while(it.hasNext())
+            {
+                it.next();
+                matchFile(it.fileInfo());
+            }
+        }
+        else if(path_info.isFile())
+        {
+            matchFile(path_info);
+        }
+        else
+        {
+            result.errors.append(QObject::tr("File not found: \"%1\"").arg(path));
+            ++result.failed;
+        }
+    }
+    if(items.isEmpty())
+        return result;
+    QDir().mkpath(mr_manager.artDirectory());
+    ImportContext context;
+    context.importer = this;
+    context.manager = &mr_manager;
+    context.is_canceled = &m_is_canceled;
+    context.total = items.count();
+    context.last_reported_percent = -1;
+    context.result = result;
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    for(const ImportItem & item : items)
+        pool.start(new ImportTask(context, item));
+    pool.waitForDone();
+    return context.result;
+}
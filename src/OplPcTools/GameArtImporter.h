@@ -0,0 +1,74 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTIMPORTER__
+#define __OPLPCTOOLS_GAMEARTIMPORTER__
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+#include <OplPcTools/GameArtManager.h>
+
+namespace OplPcTools {
+
+struct GameArtImportResult
+{
+    GameArtImportResult() :
+        imported(0),
+        skipped(0),
+        failed(0)
+    {
+    }
+
+    int imported;
+    int skipped; // Files that do not match any game or art type, and duplicates
+    int failed;
+    QMap<QString, QFlags<GameArtType>> arts;
+    QStringList errors;
+};
+
+/*
+ * Imports art packs: every picture named <ID><art suffix>.<png|jpg|jpeg|bmp> (e.g. SLUS_200.02_COV.jpg)
+ * found in the given files and directories is decoded, scaled, encoded and saved to the ART directory
+ * by a pool of worker threads. import() blocks until all the files are processed, the progress signal is
+ * emitted from the worker threads. The caller is responsible for GameArtManager::reloadArts afterwards.
+ */
+class GameArtImporter final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameArtImporter(const GameArtManager & _manager, QObject * _parent = nullptr);
+    void setGameIds(const QSet<QString> & _game_ids);
+    GameArtImportResult import(const QStringList & _paths);
+    void cancel();
+
+signals:
+    void progress(int _processed, int _total);
+
+private:
+    const GameArtManager & mr_manager;
+    QSet<QString> m_game_ids;
+    QAtomicInt m_is_canceled;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTIMPORTER__
@@ -0,0 +1,189 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameArtIndex.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+int extensionPriority(const QString & _filename)
+{
+    int dot_index = _filename.lastIndexOf('.');
+    if(dot_index < 0)
+        return -1;
+    return GameArtIndex::extensions().indexOf(_filename.mid(dot_index).toLower());
+}
+
+} // namespace
+
+GameArtIndex::GameArtIndex(const QString & _directory_path, const QList<QPair<QString, GameArtType>> & _suffixes) :
+    m_directory_path(_directory_path),
+    m_suffixes(_suffixes)
+{
+    // _COV2 must be tested before _COV
+    std::sort(m_suffixes.begin(), m_suffixes.end(), [](const QPair<QString, GameArtType> & _left, const QPair<QString, GameArtType> & _right) {
+        return _left.first.size() > _right.first.size();
+    });
+}
+
+const QStringList & GameArtIndex::extensions()
+{
+    static const QStringList extensions { ".png", ".jpeg", ".jpg", ".bmp" };
+    return extensions;
+}
+
+bool GameArtIndex::parseFileName(const QString & _filename, QString * _game_id, GameArtType * _type) const
+{
+    if(extensionPriority(_filename) < 0)
+        return false;
+    const QString basename = _filename.left(_filename.lastIndexOf('.'));
+    for(const auto & suffix : m_suffixes)
+    {
+        if(!basename.endsWith(suffix.first))
+            continue;
+        if(basename.size() == suffix.first.size())
+            return false;
+        *_game_id = basename.left(basename.size() - suffix.first.size());
+        *_type = suffix.second;
+        return true;
+    }
+    return false;
+}
+
+void GameArtIndex::insertFile(QStringList & _files, const QString & _filename)
+{
+    if(_files.contains(_filename))
+        return;
+    int priority = extensionPriority(_filename);
+    auto it = std::find_if(_files.begin(), _files.end(), [priority](const QString & _file) {
+        return extensionPriority(_file) > priority;
+    });
+    _files.insert(it, _filename);
+}
+
+// Lists the directory and replaces the index.
+// Returns the arts whose effective file has changed; the path is empty for the deleted ones.
+QList<GameArtFile> GameArtIndex::rescan()
+{
+    OPT_TRACE_SCOPE("GameArtIndex::rescan");
+    QHash<QString, TypeFiles> files;
+    QString game_id;
+    GameArtType type;
+    for(const QString & filename : QDir(m_directory_path).entryList(QDir::Files))
+    {
+        if(parseFileName(filename, &game_id, &type))
+            insertFile(files[game_id][type], filename);
+    }
+    QMutexLocker locker(&m_mutex);
+    QList<GameArtFile> changes;
+    for(auto game_it = files.cbegin(); game_it != files.cend(); ++game_it)
+    {
+        const TypeFiles old_files = m_files.value(game_it.key());
+        for(auto type_it = game_it->cbegin(); type_it != game_it->cend(); ++type_it)
+        {
+            const QStringList old_type_files = old_files.value(type_it.key());
+            if(old_type_files.isEmpty() || old_type_files.first() != type_it->first())
+                changes.append(GameArtFile { game_it.key(), type_it.key(), QDir(m_directory_path).absoluteFilePath(type_it->first()) });
+        }
+    }
+    for(auto game_it = m_files.cbegin(); game_it != m_files.cend(); ++game_it)
+    {
+        const TypeFiles new_files = files.value(game_it.key());
+        for(auto type_it = game_it->cbegin(); type_it != game_it->cend(); ++type_it)
+        {
+            if(!new_files.contains(type_it.key()))
+                changes.append(GameArtFile { game_it.key(), type_it.key(), QString() });
+        }
+    }
+    m_files.swap(files);
+    return changes;
+}
+
+QString GameArtIndex::find(const QString & _game_id, GameArtType _type) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto game_it = m_files.find(_game_id);
+    if(game_it == m_files.end())
+        return QString();
+    auto type_it = game_it->find(_type);
+    if(type_it == game_it->end() || type_it->isEmpty())
+        return QString();
+    return m_directory_path + QLatin1Char('/') + type_it->first();
+}
+
+QStringList GameArtIndex::files(const QString & _game_id, GameArtType _type) const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList result;
+    for(const QString & filename : m_files.value(_game_id).value(_type))
+        result.append(m_directory_path + QLatin1Char('/') + filename);
+    return result;
+}
+
+QList<GameArtFile> GameArtIndex::files() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<GameArtFile> result;
+    for(auto game_it = m_files.cbegin(); game_it != m_files.cend(); ++game_it)
+    {
+        for(auto type_it = game_it->cbegin(); type_it != game_it->cend(); ++type_it)
+        {
+            if(!type_it->isEmpty())
+                result.append(GameArtFile { game_it.key(), type_it.key(), m_directory_path + QLatin1Char('/') + type_it->first() });
+        }
+    }
+    return result;
+}
+
+void GameArtIndex::insert(const QString & _game_id, GameArtType _type, const QString & _filename)
+{
+    QMutexLocker locker(&m_mutex);
+    insertFile(m_files[_game_id][_type], QFileInfo(_filename).fileName());
+}
+
+QStringList GameArtIndex::take(const QString & _game_id, GameArtType _type)
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList result;
+    auto game_it = m_files.find(_game_id);
+    if(game_it == m_files.end())
+        return result;
+    for(const QString & filename : game_it->take(_type))
+        result.append(m_directory_path + QLatin1Char('/') + filename);
+    if(game_it->isEmpty())
+        m_files.erase(game_it);
+    return result;
+}
+
+QStringList GameArtIndex::take(const QString & _game_id)
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList result;
+    for(const QStringList & type_files : m_files.take(_game_id))
+    {
+        for(const QString & filename : type_files)
+            result.append(m_directory_path + QLatin1Char('/') + filename);
+    }
+    return result;
+}
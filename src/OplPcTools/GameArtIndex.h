@@ -0,0 +1,75 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTINDEX__
+#define __OPLPCTOOLS_GAMEARTINDEX__
+
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QStringList>
+#include <OplPcTools/GameArtType.h>
+
+namespace OplPcTools {
+
+struct GameArtFile
+{
+    QString game_id;
+    GameArtType type;
+    QString filepath;
+};
+
+/*
+ * In-memory index of the ART directory: (game id, art type) -> files of the art.
+ * The directory is listed once by rescan(), afterwards lookups do not touch the file system.
+ * If an art is saved with several extensions, the first one from extensions() is the effective file.
+ * All the methods are thread-safe.
+ */
+class GameArtIndex final
+{
+    Q_DISABLE_COPY(GameArtIndex)
+
+    using TypeFiles = QMap<GameArtType, QStringList>;
+
+public:
+    GameArtIndex(const QString & _directory_path, const QList<QPair<QString, GameArtType>> & _suffixes);
+    static const QStringList & extensions();
+    bool parseFileName(const QString & _filename, QString * _game_id, GameArtType * _type) const;
+    QList<GameArtFile> rescan();
+    QString find(const QString & _game_id, GameArtType _type) const;
+    QStringList files(const QString & _game_id, GameArtType _type) const;
+    QList<GameArtFile> files() const;
+    void insert(const QString & _game_id, GameArtType _type, const QString & _filename);
+    QStringList take(const QString & _game_id, GameArtType _type);
+    QStringList take(const QString & _game_id);
+
+private:
+    static void insertFile(QStringList & _files, const QString & _filename);
+
+private:
+    mutable QMutex m_mutex;
+    QString m_directory_path;
+    QList<QPair<QString, GameArtType>> m_suffixes;
+    QHash<QString, TypeFiles> m_files;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTINDEX__
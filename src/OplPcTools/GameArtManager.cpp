@@ -18,7 +18,18 @@
 
 #include <functional>
 #include <QFile>
+#include <QImageReader>
+#include <QCryptographicHash>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QThread>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameIconAtlas.h>
+#include <OplPcTools/GameArtIndex.h>
+#include <OplPcTools/GameArtEncoder.h>
 #include <OplPcTools/GameArtManager.h>
 
 using namespace OplPcTools;
@@ -29,16 +40,112 @@ struct GameArtManager::GameArtProperties
     QSize size;
 };
 
+namespace {
+
+const int g_rescan_delay = 500;
+
+QString makeRequestKey(const QString & _game_id, GameArtType _type)
+{
+    return QString("%1/%2").arg(_game_id).arg(static_cast<int>(_type));
+}
+
+QImage readArtImage(const QString & _filepath, const QSize & _size)
+{
+    QImageReader reader(_filepath);
+    // Let the decoder produce the target size directly: JPEG can skip most of the IDCT work this way.
+    QSize source_size = reader.size();
+    if(source_size.isValid() && source_size != _size)
+        reader.setScaledSize(_size);
+    QImage image = reader.read();
+    if(!image.isNull() && image.size() != _size)
+        image = image.scaled(_size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return image;
+}
+
+class ArtLoadingTask final : public QRunnable
+{
+public:
+    ArtLoadingTask(QObject * _receiver, const QString & _filepath, const QString & _game_id,
+        GameArtType _type, const QSize & _size, int _request_id, GameIconAtlas * _icon_atlas);
+    void run() override;
+
+private:
+    QObject * mp_receiver;
+    GameIconAtlas * mp_icon_atlas;
+    QString m_filepath;
+    QString m_game_id;
+    GameArtType m_type;
+    QSize m_size;
+    int m_request_id;
+};
+
+} // namespace
+
+ArtLoadingTask::ArtLoadingTask(QObject * _receiver, const QString & _filepath, const QString & _game_id,
+        GameArtType _type, const QSize & _size, int _request_id, GameIconAtlas * _icon_atlas) :
+    mp_receiver(_receiver),
+    mp_icon_atlas(_icon_atlas),
+    m_filepath(_filepath),
+    m_game_id(_game_id),
+    m_type(_type),
+    m_size(_size),
+    m_request_id(_request_id)
+{
+}
+
+void ArtLoadingTask::run()
+{
+    QImage image;
+    {
+        OPT_TRACE_SCOPE("GameArtManager::decode");
+        image = readArtImage(m_filepath, m_size);
+    }
+    if(mp_icon_atlas && !image.isNull())
+    {
+        QFileInfo source(m_filepath);
+        // Does not overwrite: an icon stored by setArt in the meantime is newer than this one
+        mp_icon_atlas->store(m_game_id, image, source.lastModified().toMSecsSinceEpoch(), source.size(), false);
+    }
+    // QPixmap may only be created in the GUI thread, so the conversion is left to the receiver.
+    QMetaObject::invokeMethod(mp_receiver, "takeLoadedArt", Qt::QueuedConnection,
+        Q_ARG(QString, m_game_id), Q_ARG(int, static_cast<int>(m_type)),
+        Q_ARG(int, m_request_id), Q_ARG(QImage, image));
+}
+
 GameArtManager::GameArtManager(const QDir & _base_directory, QObject * _parent /*= nullptr*/) :
     QObject(_parent),
-    m_cached_types(0)
+    m_cached_types(0),
+    m_last_request_id(0),
+    mp_icon_atlas(nullptr),
+    mp_index(nullptr),
+    mp_watcher(nullptr),
+    mp_rescan_timer(nullptr)
 {
+    m_base_directory_path = _base_directory.absolutePath();
     m_directory_path = _base_directory.absoluteFilePath("ART");
+    m_loading_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
     initArtProperties();
+    QList<QPair<QString, GameArtType>> suffixes;
+    for(auto it = m_art_props.cbegin(); it != m_art_props.cend(); ++it)
+        suffixes.append(qMakePair(it.value()->suffix, it.key()));
+    mp_index = new GameArtIndex(m_directory_path, suffixes);
+    mp_index->rescan();
+    mp_watcher = new QFileSystemWatcher(this);
+    mp_rescan_timer = new QTimer(this);
+    mp_rescan_timer->setSingleShot(true);
+    mp_rescan_timer->setInterval(g_rescan_delay);
+    connect(mp_watcher, &QFileSystemWatcher::directoryChanged, mp_rescan_timer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(mp_rescan_timer, &QTimer::timeout, this, &GameArtManager::rescanDirectory);
+    watchDirectory();
 }
 
 GameArtManager::~GameArtManager()
 {
+    // Tasks hold a raw pointer to this object, they must not outlive it.
+    m_loading_pool.clear();
+    m_loading_pool.waitForDone();
+    delete mp_icon_atlas;
+    delete mp_index;
     for(GameArtProperties * props : m_art_props)
         delete props;
 }
@@ -90,77 +197,136 @@ void GameArtManager::removeCacheType(GameArtType _type, bool _clear_cache)
         return;
     m_cached_types ^= _type;
     if(_clear_cache)
-        clearCache(_type);
+        m_cache.clear(_type);
+}
+
+// Icons are kept in an atlas file in the _cache_directory (one per library). Entries whose source file
+// has been changed or deleted since the atlas was written are dropped, so they are decoded again on request.
+bool GameArtManager::enableIconAtlas(const QString & _cache_directory)
+{
+    if(mp_icon_atlas)
+        return true;
+    OPT_TRACE_SCOPE("GameArtManager::enableIconAtlas");
+    QString atlas_name = QString::fromLatin1(
+        QCryptographicHash::hash(m_directory_path.toUtf8(), QCryptographicHash::Sha1).toHex());
+    GameIconAtlas * atlas = new GameIconAtlas(QDir(_cache_directory).absoluteFilePath(atlas_name + ".icons"));
+    if(!atlas->open())
+    {
+        delete atlas;
+        return false;
+    }
+    for(const QString & id : atlas->gameIds())
+    {
+        QString filepath = mp_index->find(id, GameArtType::Icon);
+        QFileInfo source(filepath);
+        if(filepath.isEmpty() || !atlas->isUpToDate(id, source.lastModified().toMSecsSinceEpoch(), source.size()))
+            atlas->remove(id);
+    }
+    mp_icon_atlas = atlas;
+    return true;
 }
 
-void GameArtManager::clearCache(GameArtType _type)
+// Returns the icon pre-scaled to the _size from the atlas or falls back to requestArt
+QPixmap GameArtManager::requestIcon(const QString & _game_id, int _size)
 {
-    for(auto & game_cache : m_cache)
+    if(mp_icon_atlas)
     {
-        auto it = game_cache->find(_type);
-        if(it != game_cache->end())
-            game_cache->erase(it);
+        QImage image = mp_icon_atlas->image(_game_id, _size);
+        if(!image.isNull())
+            return QPixmap::fromImage(image);
     }
+    return requestArt(_game_id, GameArtType::Icon);
+}
+
+void GameArtManager::setCacheBudget(GameArtType _type, qint64 _bytes)
+{
+    m_cache.setBudget(_type, _bytes);
 }
 
 QPixmap GameArtManager::load(const QString & _game_id, GameArtType _type)
 {
-    Maybe<QPixmap> cached_pixmap = findInCache(_game_id, _type);
-    if(m_cached_types & _type && cached_pixmap.hasValue())
-        return cached_pixmap.value();
-    QDir dir(m_directory_path);
-    if(!dir.exists())
+    OPT_TRACE_SCOPE("GameArtManager::load");
+    if(m_cached_types & _type)
+    {
+        if(const QPixmap * cached_pixmap = m_cache.find(_game_id, _type))
+            return *cached_pixmap;
+    }
+    const QString filepath = mp_index->find(_game_id, _type);
+    if(filepath.isEmpty())
         return QPixmap();
-    static const QStringList exts { ".png", ".jpeg", ".jpg", ".bmp" };
-    const QString sfx = m_art_props[_type]->suffix;
-    for(const QString & ext : exts)
-    {
-        QFile file(dir.absoluteFilePath(_game_id + sfx + ext));
-        if(!file.exists()) continue;
-        QPixmap pixmap(file.fileName());
-        if(pixmap.isNull()) continue;
-        const GameArtProperties * props = m_art_props[_type];
-        if(pixmap.size() != props->size)
-            pixmap = pixmap.scaled(props->size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    QPixmap pixmap = QPixmap::fromImage(readArtImage(filepath, m_art_props[_type]->size));
+    if(!pixmap.isNull() && m_cached_types & _type)
+        cacheArt(_game_id, _type, pixmap);
+    return pixmap;
+}
+
+// Returns the art if it is cached or a null pixmap otherwise.
+// A missing art is decoded by the worker pool and delivered through the artChanged signal
+// (with nullptr if the game has no such art). Results of the cached types are cached, including misses,
+// so the next request for them is answered immediately.
+QPixmap GameArtManager::requestArt(const QString & _game_id, GameArtType _type)
+{
+    if(m_cached_types & _type)
+    {
+        if(const QPixmap * cached_pixmap = m_cache.find(_game_id, _type))
+            return *cached_pixmap;
+    }
+    const QString filepath = mp_index->find(_game_id, _type);
+    if(filepath.isEmpty())
+    {
+        // No need to bother the workers: the index knows that there is no such art
         if(m_cached_types & _type)
-            cacheArt(_game_id, _type, pixmap);
-        return pixmap;
+            cacheArt(_game_id, _type, QPixmap());
+        return QPixmap();
     }
+    QString key = makeRequestKey(_game_id, _type);
+    if(m_pending_requests.contains(key))
+        return QPixmap();
+    int request_id = ++m_last_request_id;
+    m_pending_requests[key] = request_id;
+    // The most recent requests are the most relevant ones: they belong to the rows that are visible now.
+    m_loading_pool.start(
+        new ArtLoadingTask(this, filepath, _game_id, _type, m_art_props[_type]->size, request_id,
+            _type == GameArtType::Icon ? mp_icon_atlas : nullptr),
+        request_id);
     return QPixmap();
 }
 
-Maybe<QPixmap> GameArtManager::findInCache(const QString & _game_id, GameArtType _type) const
+void GameArtManager::takeLoadedArt(const QString & _game_id, int _type, int _request_id, const QImage & _image)
+{
+    QString key = makeRequestKey(_game_id, static_cast<GameArtType>(_type));
+    auto it = m_pending_requests.find(key);
+    if(it == m_pending_requests.end() || it.value() != _request_id)
+        return; // The art has been changed or deleted while it was loading
+    m_pending_requests.erase(it);
+    GameArtType type = static_cast<GameArtType>(_type);
+    QPixmap pixmap = QPixmap::fromImage(_image);
+    if(m_cached_types & type)
+        cacheArt(_game_id, type, pixmap);
+    emit artChanged(_game_id, type, pixmap.isNull() ? nullptr : &pixmap);
+}
+
+void GameArtManager::cancelRequest(const QString & _game_id, GameArtType _type)
 {
-    Maybe<GameCache> game_cache = m_cache[_game_id];
-    if(!game_cache.hasValue())
-        return Maybe<QPixmap>();
-    return (*game_cache)[_type];
+    m_pending_requests.remove(makeRequestKey(_game_id, _type));
 }
 
 void GameArtManager::cacheArt(const QString & _game_id, GameArtType _type, const QPixmap & _pixmap)
 {
-    if(m_cache.contains(_game_id))
-    {
-        (*m_cache[_game_id])[_type] = _pixmap;
-    }
-    else
-    {
-        GameCache game_cache;
-        game_cache[_type] = _pixmap;
-        m_cache[_game_id] = game_cache;
-    }
+    m_cache.insert(_game_id, _type, _pixmap);
+    OPT_TRACE_COUNTER("GameArtManager::cacheBytes", m_cache.statistics().used_bytes);
 }
 
 void GameArtManager::deleteArt(const QString & _game_id, GameArtType _type)
 {
-    Maybe<GameCache> & game_cache = m_cache[_game_id];
-    if(game_cache.hasValue())
-        game_cache->remove(_type);
-    QStringList file_filter { QString("%1%2.*").arg(_game_id).arg(m_art_props[_type]->suffix) };
+    m_cache.remove(_game_id, _type);
+    cancelRequest(_game_id, _type);
+    if(mp_icon_atlas && _type == GameArtType::Icon)
+        mp_icon_atlas->remove(_game_id);
     bool changed = false;
-    for(const QFileInfo & file_info : QDir(m_directory_path).entryInfoList(file_filter, QDir::Files))
+    for(const QString & filepath : mp_index->take(_game_id, _type))
     {
-        if(QFile::remove(file_info.absoluteFilePath()))
+        if(QFile::remove(filepath))
             changed = true;
     }
     if(changed)
@@ -172,9 +338,12 @@ void GameArtManager::deleteArt(const QString & _game_id, GameArtType _type)
 void GameArtManager::clearArts(const QString & _game_id)
 {
     m_cache.remove(_game_id);
-    QStringList file_filter { _game_id + "*.*" };
-    for(const QFileInfo & file_info : QDir(m_directory_path).entryInfoList(file_filter, QDir::Files))
-        QFile::remove(file_info.absoluteFilePath());
+    for(GameArtType type : m_art_props.keys())
+        cancelRequest(_game_id, type);
+    if(mp_icon_atlas)
+        mp_icon_atlas->remove(_game_id);
+    for(const QString & filepath : mp_index->take(_game_id))
+        QFile::remove(filepath);
 }
 
 QPixmap GameArtManager::setArt(const QString & _game_id, GameArtType _type, const QString & _filepath)
@@ -185,14 +354,111 @@ QPixmap GameArtManager::setArt(const QString & _game_id, GameArtType _type, cons
     const GameArtProperties * props = m_art_props[_type];
     if(pixmap.size() != props->size)
         pixmap = pixmap.scaled(props->size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    QDir dir(m_directory_path);
-    if(!dir.exists())
-        dir.mkpath(".");
-    QString filename = dir.absoluteFilePath(_game_id + props->suffix + ".png");
-    if(!pixmap.save(filename))
-        throw IOException(QObject::tr("Unable to save file \"%1\"").arg(filename));
+    QString filename = writeArt(_game_id, _type, encodeGameArt(pixmap.toImage(), _type));
+    cancelRequest(_game_id, _type);
+    if(mp_icon_atlas && _type == GameArtType::Icon)
+    {
+        QFileInfo source(filename);
+        mp_icon_atlas->store(_game_id, pixmap.toImage(), source.lastModified().toMSecsSinceEpoch(), source.size(), true);
+    }
     if(m_cached_types & _type)
         cacheArt(_game_id, _type, pixmap);
     emit artChanged(_game_id, _type, &pixmap);
     return pixmap;
 }
+
+// Replaces the art file atomically and deletes the files of the same art with other extensions,
+// which would shadow or be shadowed by the new one. Safe to call from any thread.
+QString GameArtManager::writeArt(const QString & _game_id, GameArtType _type, const EncodedGameArt & _art) const
+{
+    QDir dir(m_directory_path);
+    if(!dir.exists())
+        dir.mkpath(".");
+    const QString filename = dir.absoluteFilePath(_game_id + m_art_props[_type]->suffix + _art.extension);
+    QSaveFile file(filename);
+    if(_art.data.isEmpty() || !file.open(QIODevice::WriteOnly) ||
+        file.write(_art.data) != _art.data.size() || !file.commit())
+    {
+        throw IOException(QObject::tr("Unable to save file \"%1\"").arg(filename));
+    }
+    for(const QString & filepath : mp_index->take(_game_id, _type))
+    {
+        if(filepath != filename)
+            QFile::remove(filepath);
+    }
+    mp_index->insert(_game_id, _type, filename);
+    return filename;
+}
+
+// Drops everything known about the arts that have been replaced on disk behind the manager's back
+// and notifies the views once for the whole batch
+void GameArtManager::reloadArts(const QMap<QString, QFlags<GameArtType>> & _arts)
+{
+    for(auto it = _arts.cbegin(); it != _arts.cend(); ++it)
+    {
+        for(GameArtType type : m_art_props.keys())
+        {
+            if((it.value() & type) == 0)
+                continue;
+            m_cache.remove(it.key(), type);
+            cancelRequest(it.key(), type);
+            if(mp_icon_atlas && type == GameArtType::Icon)
+                mp_icon_atlas->remove(it.key());
+        }
+    }
+    watchDirectory();
+    if(!_arts.isEmpty())
+        emit artsReloaded(_arts.keys());
+}
+
+QString GameArtManager::findArtFile(const QString & _game_id, GameArtType _type) const
+{
+    return mp_index->find(_game_id, _type);
+}
+
+QList<GameArtFile> GameArtManager::artFiles() const
+{
+    return mp_index->files();
+}
+
+void GameArtManager::watchDirectory()
+{
+    // Until the ART directory is created, the library directory is watched for it to appear
+    if(QDir(m_directory_path).exists())
+    {
+        if(!mp_watcher->directories().contains(m_directory_path))
+        {
+            mp_watcher->removePaths(mp_watcher->directories());
+            mp_watcher->addPath(m_directory_path);
+        }
+    }
+    else if(mp_watcher->directories().isEmpty() && QDir(m_base_directory_path).exists())
+    {
+        mp_watcher->addPath(m_base_directory_path);
+    }
+}
+
+// Picks up the changes made behind the manager's back. Own writes are already in the index.
+void GameArtManager::rescanDirectory()
+{
+    watchDirectory();
+    QMap<QString, QFlags<GameArtType>> changed_arts;
+    for(const GameArtFile & file : mp_index->rescan())
+        changed_arts[file.game_id] |= file.type;
+    reloadArts(changed_arts);
+}
+
+QList<GameArtType> GameArtManager::artTypes() const
+{
+    return m_art_props.keys();
+}
+
+QString GameArtManager::artSuffix(GameArtType _type) const
+{
+    return m_art_props[_type]->suffix;
+}
+
+QSize GameArtManager::artSize(GameArtType _type) const
+{
+    return m_art_props[_type]->size;
+}
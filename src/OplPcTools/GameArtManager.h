@@ -23,29 +23,27 @@
 #include <QPixmap>
 #include <QMap>
 #include <QSize>
+#include <QHash>
+#include <QImage>
 #include <QObject>
-#include <OplPcTools/Maybe.h>
+#include <QThreadPool>
+#include <OplPcTools/GameArtType.h>
+#include <OplPcTools/GameArtCache.h>
+
+class QFileSystemWatcher;
+class QTimer;
 
 namespace OplPcTools {
 
-enum class GameArtType
-{
-    Icon         = 0x1,
-    Front        = 0x2,
-    Back         = 0x4,
-    Spine        = 0x8,
-    Screenshot1  = 0x10,
-    Screenshot2  = 0x20,
-    Background   = 0x40,
-    Logo         = 0x80
-};
+class GameIconAtlas;
+class GameArtIndex;
+struct GameArtFile;
+struct EncodedGameArt;
 
 class GameArtManager final : public QObject
 {
     Q_OBJECT
 
-    using GameCache = QMap<GameArtType, Maybe<QPixmap>>;
-    using CacheMap = QMap<QString, Maybe<GameCache>>;
     struct GameArtProperties;
 
 public:
@@ -53,27 +51,67 @@ public:
     ~GameArtManager();
     void addCacheType(GameArtType _type);
     void removeCacheType(GameArtType _type, bool _clear_cache);
+    void setCacheBudget(GameArtType _type, qint64 _bytes);
+    bool enableIconAtlas(const QString & _cache_directory);
+    inline GameArtCache::Statistics cacheStatistics(GameArtType _type) const;
+    inline GameArtCache::Statistics cacheStatistics() const;
     QPixmap load(const QString & _game_id, GameArtType _type);
+    QPixmap requestArt(const QString & _game_id, GameArtType _type);
+    QPixmap requestIcon(const QString & _game_id, int _size);
     void deleteArt(const QString & _game_id, GameArtType _type);
     void clearArts(const QString & _game_id);
     QPixmap setArt(const QString & _game_id, GameArtType _type, const QString & _filepath);
+    QString writeArt(const QString & _game_id, GameArtType _type, const EncodedGameArt & _art) const;
+    void reloadArts(const QMap<QString, QFlags<GameArtType>> & _arts);
+    inline const QString & artDirectory() const;
+    QList<GameArtType> artTypes() const;
+    QString artSuffix(GameArtType _type) const;
+    QSize artSize(GameArtType _type) const;
+    QString findArtFile(const QString & _game_id, GameArtType _type) const;
+    QList<GameArtFile> artFiles() const;
 
 signals:
     void artChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap);
+    void artsReloaded(const QStringList & _game_ids);
 
 private:
     void initArtProperties();
-    void clearCache(GameArtType _type);
-    Maybe<QPixmap> findInCache(const QString & _game_id, GameArtType _type) const;
     void cacheArt(const QString & _game_id, GameArtType _type, const QPixmap & _pixmap);
+    void cancelRequest(const QString & _game_id, GameArtType _type);
+    void watchDirectory();
+    void rescanDirectory();
+    Q_INVOKABLE void takeLoadedArt(const QString & _game_id, int _type, int _request_id, const QImage & _image);
 
 private:
+    QString m_base_directory_path;
     QString m_directory_path;
-    CacheMap m_cache;
+    GameArtCache m_cache;
     QFlags<GameArtType> m_cached_types;
     QMap<GameArtType, GameArtProperties *> m_art_props;
+    QHash<QString, int> m_pending_requests;
+    int m_last_request_id;
+    GameIconAtlas * mp_icon_atlas;
+    GameArtIndex * mp_index;
+    QFileSystemWatcher * mp_watcher;
+    QTimer * mp_rescan_timer;
+    QThreadPool m_loading_pool;
 };
 
+const QString & GameArtManager::artDirectory() const
+{
+    return m_directory_path;
+}
+
+GameArtCache::Statistics GameArtManager::cacheStatistics(GameArtType _type) const
+{
+    return m_cache.statistics(_type);
+}
+
+GameArtCache::Statistics GameArtManager::cacheStatistics() const
+{
+    return m_cache.statistics();
+}
+
 } // namespace OplPcTools
 
 #endif // __OPLPCTOOLS_GAMEARTMANAGER__
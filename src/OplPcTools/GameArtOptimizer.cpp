@@ -0,0 +1,197 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameArtEncoder.h>
+#include <OplPcTools/GameArtIndex.h>
+#include <OplPcTools/GameArtOptimizer.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+struct OptimizationItem
+{
+    QFileInfo file_info;
+    QString game_id;
+    GameArtType type;
+};
+
+struct OptimizationContext
+{
+    GameArtOptimizer * optimizer;
+    const GameArtManager * manager;
+    QAtomicInt * is_canceled;
+    bool is_dry_run;
+    QAtomicInt processed;
+    int total;
+    int last_reported_percent;
+    QMutex mutex;
+    GameArtOptimizationResult result;
+};
+
+class OptimizationTask final : public QRunnable
+{
+public:
+    OptimizationTask(OptimizationContext & _context, const OptimizationItem & _item);
+    void run() override;
+
+private:
+    void optimize();
+    void reportProgress();
+
+private:
+    OptimizationContext & mr_context;
+    OptimizationItem m_item;
+};
+
+} // namespace
+
+OptimizationTask::OptimizationTask(OptimizationContext & _context, const OptimizationItem & _item) :
+    mr_context(_context),
+    m_item(_item)
+{
+}
+
+void OptimizationTask::run()
+{
+    if(mr_context.is_canceled->load() == 0)
+        optimize();
+    reportProgress();
+}
+
+void OptimizationTask::optimize()
+{
+    OPT_TRACE_SCOPE("GameArtOptimizer::optimizeFile");
+    const QSize size = mr_context.manager->artSize(m_item.type);
+    const qint64 size_before = m_item.file_info.size();
+    qint64 size_after = size_before;
+    bool replaced = false;
+    QString error;
+    QImageReader reader(m_item.file_info.absoluteFilePath());
+    const QSize source_size = reader.size();
+    const bool resize = source_size != size;
+    if(source_size.isValid() && resize)
+        reader.setScaledSize(size);
+    QImage image = reader.read();
+    if(image.isNull())
+    {
+        error = QObject::tr("Unable to read file \"%1\": %2").arg(m_item.file_info.absoluteFilePath()).arg(reader.errorString());
+    }
+    else
+    {
+        if(image.size() != size)
+            image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        EncodedGameArt art = encodeGameArt(image, m_item.type);
+        if(!art.data.isEmpty() && (resize || art.data.size() < size_before))
+        {
+            try
+            {
+                if(!mr_context.is_dry_run)
+                    mr_context.manager->writeArt(m_item.game_id, m_item.type, art);
+                size_after = art.data.size();
+                replaced = true;
+            }
+            catch(const Exception & exception)
+            {
+                error = exception.message();
+            }
+        }
+    }
+    QMutexLocker locker(&mr_context.mutex);
+    mr_context.result.bytes_before += size_before;
+    mr_context.result.bytes_after += size_after;
+    if(!error.isEmpty())
+    {
+        ++mr_context.result.failed;
+        mr_context.result.errors.append(error);
+    }
+    else if(replaced)
+    {
+        ++mr_context.result.optimized;
+        mr_context.result.arts[m_item.game_id] |= m_item.type;
+    }
+    else
+    {
+        ++mr_context.result.unchanged;
+    }
+}
+
+void OptimizationTask::reportProgress()
+{
+    int processed = mr_context.processed.fetchAndAddOrdered(1) + 1;
+    int percent = static_cast<int>(static_cast<qint64>(processed) * 100 / mr_context.total);
+    {
+        QMutexLocker locker(&mr_context.mutex);
+        if(percent == mr_context.last_reported_percent && processed != mr_context.total)
+            return;
+        mr_context.last_reported_percent = percent;
+    }
+    emit mr_context.optimizer->progress(processed, mr_context.total);
+}
+
+GameArtOptimizer::GameArtOptimizer(const GameArtManager & _manager, QObject * _parent /*= nullptr*/) :
+    QObject(_parent),
+    mr_manager(_manager),
+    m_is_dry_run(false),
+    m_is_canceled(0)
+{
+}
+
+void GameArtOptimizer::setDryRun(bool _dry_run)
+{
+    m_is_dry_run = _dry_run;
+}
+
+void GameArtOptimizer::cancel()
+{
+    m_is_canceled.store(1);
+}
+
+GameArtOptimizationResult GameArtOptimizer::optimize()
+{
+    OPT_TRACE_SCOPE("GameArtOptimizer::optimize");
+    m_is_canceled.store(0);
+    // Only the effective file of an art is optimized, writeArt removes the shadowed ones
+    QList<OptimizationItem> items;
+    for(const GameArtFile & file : mr_manager.artFiles())
+        items.append(OptimizationItem { QFileInfo(file.filepath), file.game_id, file.type });
+    if(items.isEmpty())
+        return GameArtOptimizationResult();
+    OptimizationContext context;
+    context.optimizer = this;
+    context.manager = &mr_manager;
+    context.is_canceled = &m_is_canceled;
+    context.is_dry_run = m_is_dry_run;
+    context.total = items.count();
+    context.last_reported_percent = -1;
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    for(const OptimizationItem & item : items)
+        pool.start(new OptimizationTask(context, item));
+    pool.waitForDone();
+    return context.result;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTOPTIMIZER__
+#define __OPLPCTOOLS_GAMEARTOPTIMIZER__
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMap>
+#include <QStringList>
+#include <OplPcTools/GameArtManager.h>
+
+namespace OplPcTools {
+
+struct GameArtOptimizationResult
+{
+    GameArtOptimizationResult() :
+        optimized(0),
+        unchanged(0),
+        failed(0),
+        bytes_before(0),
+        bytes_after(0)
+    {
+    }
+
+    int optimized;
+    int unchanged;
+    int failed;
+    qint64 bytes_before;
+    qint64 bytes_after;
+    QMap<QString, QFlags<GameArtType>> arts;
+    QStringList errors;
+};
+
+/*
+ * Recompresses the ART directory: every art is scaled to the size of its type and re-encoded with encodeGameArt.
+ * A file is replaced only if it had a wrong size or the new encoding is smaller.
+ * optimize() blocks until all the files are processed by a pool of worker threads,
+ * the progress signal is emitted from the worker threads.
+ * The caller is responsible for GameArtManager::reloadArts afterwards.
+ */
+class GameArtOptimizer final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GameArtOptimizer(const GameArtManager & _manager, QObject * _parent = nullptr);
+    void setDryRun(bool _dry_run);
+    GameArtOptimizationResult optimize();
+    void cancel();
+
+signals:
+    void progress(int _processed, int _total);
+
+private:
+    const GameArtManager & mr_manager;
+    bool m_is_dry_run;
+    QAtomicInt m_is_canceled;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTOPTIMIZER__
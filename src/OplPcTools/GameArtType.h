@@ -0,0 +1,38 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEARTTYPE__
+#define __OPLPCTOOLS_GAMEARTTYPE__
+
+namespace OplPcTools {
+
+enum class GameArtType
+{
+    Icon         = 0x1,
+    Front        = 0x2,
+    Back         = 0x4,
+    Spine        = 0x8,
+    Screenshot1  = 0x10,
+    Screenshot2  = 0x20,
+    Background   = 0x40,
+    Logo         = 0x80
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEARTTYPE__
@@ -16,7 +16,12 @@
  *                                                                                             *
  ***********************************************************************************************/
 
+#include <algorithm>
+#include <QHash>
+#include <QSet>
+#include <QFile>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
 #include <OplPcTools/GameCollection.h>
 
 using namespace OplPcTools;
@@ -34,72 +39,523 @@ auto findGameById(TCollection & _collection, const QString & _id) -> typename TC
     return nullptr;
 }
 
+const int g_loading_batch_size = 128;
+
+bool isSameGame(const Game & _game1, const Game & _game2)
+{
+    return _game1.title() == _game2.title() &&
+        _game1.mediaType() == _game2.mediaType() &&
+        _game1.partCount() == _game2.partCount() &&
+        _game1.installationType() == _game2.installationType();
+}
+
 } // namespace
 
+namespace OplPcTools {
+
+struct GameCollectionLoadingState
+{
+    QMutex mutex;
+    QAtomicInt canceled;
+    QList<Game> ul_games;
+    QList<Game> directory_games;
+    QList<DirectoryGameImage> directory_images;
+    QString error_message;
+    bool finished = false;
+};
+
+} // namespace OplPcTools
+
+namespace {
+
+class CollectionLoadingTask final
+{
+    typedef QSharedPointer<GameCollectionLoadingState> StatePointer;
+
+public:
+    CollectionLoadingTask(QObject * _receiver, const QDir & _directory, const GameCollectionSnapshot & _hint, StatePointer _state);
+    void run();
+
+private:
+    void notify();
+
+private:
+    QObject * mp_receiver;
+    QDir m_directory;
+    GameCollectionSnapshot m_hint;
+    StatePointer m_state;
+};
+
+} // namespace
+
+CollectionLoadingTask::CollectionLoadingTask(QObject * _receiver, const QDir & _directory,
+        const GameCollectionSnapshot & _hint, StatePointer _state) :
+    mp_receiver(_receiver),
+    m_directory(_directory),
+    m_hint(_hint),
+    m_state(_state)
+{
+}
+
+void CollectionLoadingTask::run()
+{
+    OPT_TRACE_SCOPE("CollectionLoadingTask::run");
+    UlConfigGameStorage ul_conf_storage;
+    DirectoryGameStorage dir_storage;
+    ul_conf_storage.setDiscoveryBatchSize(g_loading_batch_size);
+    ul_conf_storage.setCancellationFlag(&m_state->canceled);
+    dir_storage.setDiscoveryBatchSize(g_loading_batch_size);
+    dir_storage.setCancellationFlag(&m_state->canceled);
+    dir_storage.setKnownImages(m_hint.directory_images);
+    QObject::connect(&ul_conf_storage, &GameStorage::gamesDiscovered, [this](const QList<Game> & _games) {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->ul_games.append(_games);
+        locker.unlock();
+        notify();
+    });
+    QObject::connect(&dir_storage, &GameStorage::gamesDiscovered, [this](const QList<Game> & _games) {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->directory_games.append(_games);
+        locker.unlock();
+        notify();
+    });
+    QString error_message;
+    try
+    {
+        ul_conf_storage.load(m_directory);
+        dir_storage.load(m_directory);
+    }
+    catch(const Exception & exception)
+    {
+        error_message = exception.message();
+    }
+    catch(...)
+    {
+        error_message = QObject::tr("An unknown error has occurred");
+    }
+    QMutexLocker locker(&m_state->mutex);
+    m_state->directory_images = dir_storage.knownImages();
+    m_state->error_message = error_message;
+    m_state->finished = true;
+    locker.unlock();
+    notify();
+}
+
+void CollectionLoadingTask::notify()
+{
+    if(!m_state->canceled.load())
+        QMetaObject::invokeMethod(mp_receiver, "takeLoadedGames", Qt::QueuedConnection);
+}
+
 GameCollection::GameCollection(QObject * _parent /*= nullptr*/) :
     QObject(_parent),
     mp_ul_conf_storage(new UlConfigGameStorage),
     mp_dir_storage(new DirectoryGameStorage)
 {
-    connect(mp_dir_storage, &DirectoryGameStorage::gameRenamed, this, &GameCollection::gameRenamed);
-    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameRenamed, this, &GameCollection::gameRenamed);
-    connect(mp_dir_storage, &DirectoryGameStorage::gameRegistered, this, &GameCollection::gameAdded);
-    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameRegistered, this, &GameCollection::gameAdded);
-    connect(mp_dir_storage, &DirectoryGameStorage::gameAboutToBeDeleted, this, &GameCollection::gameAboutToBeDeleted);
-    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameAboutToBeDeleted, this, &GameCollection::gameAboutToBeDeleted);
-    connect(mp_dir_storage, &DirectoryGameStorage::gameDeleted, this, &GameCollection::gameDeleted);
-    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameDeleted, this, &GameCollection::gameDeleted);
+    std::atomic_store(&m_games, std::make_shared<const GameList>());
+    // The storages are changed under the mutation mutex by any thread, the list must be published by the same thread.
+    // The changes are collected and reported by emitChanges() when the mutex has been released.
+    connect(mp_dir_storage, &DirectoryGameStorage::gameRenamed, this, &GameCollection::onGameRenamed, Qt::DirectConnection);
+    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameRenamed, this, &GameCollection::onGameRenamed, Qt::DirectConnection);
+    connect(mp_dir_storage, &DirectoryGameStorage::gameRegistered, this, &GameCollection::onGameRegistered, Qt::DirectConnection);
+    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameRegistered, this, &GameCollection::onGameRegistered, Qt::DirectConnection);
+    connect(mp_dir_storage, &DirectoryGameStorage::gameDeleted, this, &GameCollection::onGameDeleted, Qt::DirectConnection);
+    connect(mp_ul_conf_storage, &UlConfigGameStorage::gameDeleted, this, &GameCollection::onGameDeleted, Qt::DirectConnection);
 }
 
 GameCollection::~GameCollection()
 {
+    cancelLoading();
+    for(const JobPointer & job : m_loading_jobs)
+        job->wait();
     delete mp_ul_conf_storage;
     delete mp_dir_storage;
 }
 
 void GameCollection::load(const QDir & _directory)
 {
+    OPT_TRACE_SCOPE("GameCollection::load");
+    cancelLoading();
+    QMutexLocker locker(&m_mutation_mutex);
     mp_ul_conf_storage->load(_directory);
     mp_dir_storage->load(_directory);
     m_directory = _directory.absolutePath();
+    publishAll();
+    locker.unlock();
     emit loaded();
 }
 
+// Loads the _directory, skipping probing of the ISO images which are known to the _hint and have not been changed
+void GameCollection::load(const QDir & _directory, const GameCollectionSnapshot & _hint)
+{
+    {
+        QMutexLocker locker(&m_mutation_mutex);
+        mp_dir_storage->setKnownImages(_hint.directory_images);
+    }
+    load(_directory);
+}
+
+// Starts reading the _directory on a worker thread. The games are added to the collection in batches
+// as they are discovered, each batch is reported with gamesLoaded. At the end loadingFinished is emitted
+// followed by loaded, or loadingFailed is emitted.
+void GameCollection::loadInBackground(const QDir & _directory, const GameCollectionSnapshot & _hint /*= GameCollectionSnapshot()*/)
+{
+    OPT_TRACE_SCOPE("GameCollection::loadInBackground");
+    cancelLoading();
+    QMutexLocker locker(&m_mutation_mutex);
+    mp_ul_conf_storage->restore(_directory, QList<Game>());
+    mp_dir_storage->restore(_directory, QList<Game>());
+    m_directory = _directory.absolutePath();
+    publishAll();
+    locker.unlock();
+    m_loading_state.reset(new GameCollectionLoadingState);
+    CollectionLoadingTask task(this, _directory, _hint, m_loading_state);
+    JobPointer job = Job::create(JobKind::Io, [task]() mutable { task.run(); });
+    // The canceled loadings may still be finishing, they are waited for on destruction
+    m_loading_jobs.erase(std::remove_if(m_loading_jobs.begin(), m_loading_jobs.end(),
+        [](const JobPointer & _job) { return _job->isDone(); }), m_loading_jobs.end());
+    m_loading_jobs.append(job);
+    JobScheduler::instance().submit(job);
+    emit loadingStarted();
+}
+
+bool GameCollection::isLoading() const
+{
+    return !m_loading_state.isNull();
+}
+
+void GameCollection::cancelLoading()
+{
+    if(m_loading_state)
+    {
+        m_loading_state->canceled.store(1);
+        m_loading_state.reset();
+    }
+}
+
+void GameCollection::takeLoadedGames()
+{
+    if(!m_loading_state)
+        return; // The loading has been canceled
+    QMutexLocker locker(&m_loading_state->mutex);
+    QList<Game> ul_games, directory_games;
+    ul_games.swap(m_loading_state->ul_games);
+    directory_games.swap(m_loading_state->directory_games);
+    const bool finished = m_loading_state->finished;
+    const QList<DirectoryGameImage> directory_images = m_loading_state->directory_images;
+    const QString error_message = m_loading_state->error_message;
+    locker.unlock();
+    QMutexLocker mutation_locker(&m_mutation_mutex);
+    mp_ul_conf_storage->append(ul_games);
+    mp_dir_storage->append(directory_games);
+    if(!ul_games.isEmpty() || !directory_games.isEmpty())
+        publishAppended(ul_games.count(), directory_games.count());
+    if(finished)
+        mp_dir_storage->setKnownImages(directory_images);
+    mutation_locker.unlock();
+    // All the UL games are discovered before the first directory game, so the both batches are appended to the end
+    if(!ul_games.isEmpty())
+        emit gamesLoaded(ul_games.count());
+    if(!directory_games.isEmpty())
+        emit gamesLoaded(directory_games.count());
+    if(!finished)
+        return;
+    m_loading_state.reset();
+    if(error_message.isEmpty())
+    {
+        emit loadingFinished();
+        emit loaded();
+    }
+    else
+        emit loadingFailed(error_message);
+}
+
+// Shows the _snapshot without reading the library
+void GameCollection::restore(const GameCollectionSnapshot & _snapshot)
+{
+    OPT_TRACE_SCOPE("GameCollection::restore");
+    cancelLoading();
+    QDir directory(_snapshot.directory);
+    QMutexLocker locker(&m_mutation_mutex);
+    mp_ul_conf_storage->restore(directory, _snapshot.ul_games);
+    mp_dir_storage->restore(directory, _snapshot.directory_games);
+    mp_dir_storage->setKnownImages(_snapshot.directory_images);
+    m_directory = directory.absolutePath();
+    publishAll();
+    locker.unlock();
+    emit loaded();
+}
+
+// Brings the collection to the state of the _snapshot, emitting a signal for each changed game only
+void GameCollection::merge(const GameCollectionSnapshot & _snapshot)
+{
+    OPT_TRACE_SCOPE("GameCollection::merge");
+    QSet<QString> ids;
+    for(const Game & game : _snapshot.ul_games)
+        ids.insert(game.id());
+    for(const Game & game : _snapshot.directory_games)
+        ids.insert(game.id());
+    QMutexLocker locker(&m_mutation_mutex);
+    for(const QSharedPointer<const Game> & game : *games())
+    {
+        if(!ids.contains(game->id()))
+            m_changes.append(qMakePair(GameChange::AboutToBeDeleted, game->id()));
+    }
+    try
+    {
+        mp_ul_conf_storage->merge(_snapshot.ul_games);
+        mp_dir_storage->merge(_snapshot.directory_games);
+    }
+    catch(...)
+    {
+        discardChanges();
+        throw;
+    }
+    mp_dir_storage->setKnownImages(_snapshot.directory_images);
+    emitChanges(locker);
+}
+
+GameCollectionSnapshot GameCollection::snapshot() const
+{
+    QMutexLocker locker(&m_mutation_mutex);
+    GameCollectionSnapshot snapshot;
+    snapshot.directory = m_directory;
+    snapshot.ul_games = mp_ul_conf_storage->games();
+    snapshot.directory_games = mp_dir_storage->games();
+    snapshot.directory_images = mp_dir_storage->knownImages();
+    return snapshot;
+}
+
+// Increases on every change of the collection
+int GameCollection::revision() const
+{
+    return m_revision.load();
+}
+
 bool GameCollection::isLoaded() const
 {
     return !m_directory.isEmpty();
 }
 
+// Returns the parts of a UL game or the ISO image of a directory game, the files may not exist
+QStringList GameCollection::gameFiles(const QString & _directory, const Game & _game)
+{
+    QStringList files;
+    QDir directory(_directory);
+    if(_game.installationType() == GameInstallationType::UlConfig)
+    {
+        for(quint8 part = 0; part < _game.partCount(); ++part)
+            files.append(directory.absoluteFilePath(UlConfigGameStorage::makePartFilename(_game.id(), _game.title(), part)));
+        return files;
+    }
+    directory.cd(_game.mediaType() == MediaType::CD ? DirectoryGameStorage::cd_directory : DirectoryGameStorage::dvd_directory);
+    QString path = directory.absoluteFilePath(DirectoryGameStorage::makeIsoFilename(_game.title()));
+    if(!QFile::exists(path))
+        path = directory.absoluteFilePath(DirectoryGameStorage::makeGameIsoFilename(_game.title(), _game.id()));
+    files.append(path);
+    return files;
+}
+
 const QString & GameCollection::directory() const
 {
     return m_directory;
 }
 
+GameListPointer GameCollection::games() const
+{
+    return std::atomic_load(&m_games);
+}
+
+QSharedPointer<const Game> GameCollection::game(const QString & _id) const
+{
+    const GameListPointer games = this->games();
+    for(const QSharedPointer<const Game> & game : *games)
+    {
+        if(game->id() == _id)
+            return game;
+    }
+    return QSharedPointer<const Game>();
+}
+
 int GameCollection::count() const
 {
-    return mp_ul_conf_storage->count() + mp_dir_storage->count();
+    return games()->count();
+}
+
+QSharedPointer<const Game> GameCollection::operator [](int _index) const
+{
+    return games()->at(_index);
+}
+
+QSharedPointer<const Game> GameCollection::findGame(const QString & _id) const
+{
+    return game(_id);
+}
+
+void GameCollection::publish(GameList && _games)
+{
+    std::atomic_store(&m_games, std::make_shared<const GameList>(std::move(_games)));
+    m_revision.fetchAndAddOrdered(1);
+}
+
+// Rebuilds the list from the storages, the games that have not been changed are taken from the current list
+void GameCollection::publishAll()
+{
+    OPT_TRACE_SCOPE("GameCollection::publishAll");
+    const GameListPointer current_games = games();
+    QHash<QString, QSharedPointer<const Game>> current_games_by_id;
+    current_games_by_id.reserve(current_games->count());
+    for(const QSharedPointer<const Game> & game : *current_games)
+        current_games_by_id.insert(game->id(), game);
+    GameList games;
+    games.reserve(mp_ul_conf_storage->count() + mp_dir_storage->count());
+    auto append = [&](const GameStorage & __storage) {
+        const int count = __storage.count();
+        for(int i = 0; i < count; ++i)
+        {
+            const Game * game = __storage[i];
+            QSharedPointer<const Game> current_game = current_games_by_id.value(game->id());
+            if(current_game && isSameGame(*current_game, *game))
+                games.append(current_game);
+            else
+                games.append(QSharedPointer<const Game>(new Game(*game)));
+        }
+    };
+    append(*mp_ul_conf_storage);
+    append(*mp_dir_storage);
+    publish(std::move(games));
+}
+
+// The last _ul_count UL games and the last _dir_count directory games have been appended to the storages
+void GameCollection::publishAppended(int _ul_count, int _dir_count)
+{
+    GameList games = *this->games();
+    const int ul_count = mp_ul_conf_storage->count();
+    GameList ul_games;
+    ul_games.reserve(_ul_count);
+    for(int i = ul_count - _ul_count; i < ul_count; ++i)
+        ul_games.append(QSharedPointer<const Game>(new Game(*(*mp_ul_conf_storage)[i])));
+    games.insert(ul_count - _ul_count, _ul_count, QSharedPointer<const Game>());
+    std::copy(ul_games.cbegin(), ul_games.cend(), games.begin() + (ul_count - _ul_count));
+    const int dir_count = mp_dir_storage->count();
+    for(int i = dir_count - _dir_count; i < dir_count; ++i)
+        games.append(QSharedPointer<const Game>(new Game(*(*mp_dir_storage)[i])));
+    publish(std::move(games));
+}
+
+// The game has been added, changed or deleted
+void GameCollection::publishChanged(const QString & _id)
+{
+    GameList games = *this->games();
+    int current_index = -1;
+    for(int i = 0; i < games.count(); ++i)
+    {
+        if(games[i]->id() == _id)
+        {
+            current_index = i;
+            break;
+        }
+    }
+    const Game * game = nullptr;
+    int index = -1;
+    for(int i = 0; i < mp_ul_conf_storage->count() && !game; ++i)
+    {
+        if((*mp_ul_conf_storage)[i]->id() == _id)
+        {
+            game = (*mp_ul_conf_storage)[i];
+            index = i;
+        }
+    }
+    for(int i = 0; i < mp_dir_storage->count() && !game; ++i)
+    {
+        if((*mp_dir_storage)[i]->id() == _id)
+        {
+            game = (*mp_dir_storage)[i];
+            index = mp_ul_conf_storage->count() + i;
+        }
+    }
+    if(!game)
+    {
+        if(current_index >= 0)
+            games.remove(current_index);
+    }
+    else if(current_index >= 0)
+    {
+        games[current_index] = QSharedPointer<const Game>(new Game(*game));
+    }
+    else
+    {
+        games.insert(index, QSharedPointer<const Game>(new Game(*game)));
+    }
+    publish(std::move(games));
+}
+
+void GameCollection::onGameRegistered(const QString & _id)
+{
+    publishChanged(_id);
+    m_changes.append(qMakePair(GameChange::Added, _id));
+}
+
+void GameCollection::onGameRenamed(const QString & _id)
+{
+    publishChanged(_id);
+    m_changes.append(qMakePair(GameChange::Renamed, _id));
+}
+
+void GameCollection::onGameDeleted(const QString & _id)
+{
+    publishChanged(_id);
+    m_changes.append(qMakePair(GameChange::Deleted, _id));
 }
 
-const Game * GameCollection::operator [](int _index) const
+// Releases the mutation mutex held by the _locker and reports the collected changes,
+// so the receivers may read and change the collection
+void GameCollection::emitChanges(QMutexLocker & _locker)
 {
-    int dir_index = _index - mp_ul_conf_storage->count();
-    const Game * game = dir_index < 0 ? mp_ul_conf_storage->operator [](_index) :
-        mp_dir_storage->operator [](dir_index);
-    return game;
+    QList<QPair<GameChange, QString>> changes;
+    changes.swap(m_changes);
+    _locker.unlock();
+    for(const QPair<GameChange, QString> & change : changes)
+    {
+        switch(change.first)
+        {
+        case GameChange::Added:
+            emit gameAdded(change.second);
+            break;
+        case GameChange::Renamed:
+            emit gameRenamed(change.second);
+            break;
+        case GameChange::AboutToBeDeleted:
+            emit gameAboutToBeDeleted(change.second);
+            break;
+        case GameChange::Deleted:
+            emit gameDeleted(change.second);
+            break;
+        }
+    }
 }
 
-const Game * GameCollection::findGame(const QString & _id) const
+// A failed change reports nothing, the receivers compare the published lists anyway
+void GameCollection::discardChanges()
 {
-    const Game * game = mp_ul_conf_storage->findGame(_id);
-    if(!game) game = mp_dir_storage->findGame(_id);
-    return game;
+    m_changes.clear();
 }
 
 void GameCollection::addGame(const Game & _game)
 {
-    if(findGame(_game.id()))
+    QMutexLocker locker(&m_mutation_mutex);
+    if(mp_ul_conf_storage->findGame(_game.id()) || mp_dir_storage->findGame(_game.id()))
         throw ValidationException(QObject::tr("Game \"%1\" already registered").arg(_game.id()));
-    storage(_game.installationType()).registerGame(_game);
+    try
+    {
+        storage(_game.installationType()).registerGame(_game);
+    }
+    catch(...)
+    {
+        discardChanges();
+        throw;
+    }
+    emitChanges(locker);
 }
 
 GameStorage & GameCollection::storage(GameInstallationType _installation_type) const
@@ -110,14 +566,53 @@ GameStorage & GameCollection::storage(GameInstallationType _installation_type) c
         return *mp_ul_conf_storage;
 }
 
+// The _game usually belongs to a published list that a receiver may release, so its fields are copied first
 void GameCollection::renameGame(const Game & _game, const QString & _title)
 {
-    if(!storage(_game.installationType()).renameGame(_game.id(), _title))
-        throw Exception(tr("Unable to rename game \"%1\" to \"%2\"").arg(_game.title()).arg(_title));
+    const QString id = _game.id();
+    const QString title = _game.title();
+    const GameInstallationType installation_type = _game.installationType();
+    QMutexLocker locker(&m_mutation_mutex);
+    bool is_renamed = false;
+    try
+    {
+        is_renamed = storage(installation_type).renameGame(id, _title);
+    }
+    catch(...)
+    {
+        discardChanges();
+        throw;
+    }
+    if(!is_renamed)
+    {
+        discardChanges();
+        throw Exception(tr("Unable to rename game \"%1\" to \"%2\"").arg(title).arg(_title));
+    }
+    emitChanges(locker);
 }
 
 void GameCollection::deleteGame(const Game & _game)
 {
-    if(!storage(_game.installationType()).deleteGame(_game.id()))
-        throw Exception(tr("Unable to delete game \"%1\"").arg(_game.title()));
+    const QString id = _game.id();
+    const QString title = _game.title();
+    const GameInstallationType installation_type = _game.installationType();
+    QMutexLocker locker(&m_mutation_mutex);
+    // Reported before gameDeleted, after the mutex is released, on the same thread as the other changes
+    m_changes.append(qMakePair(GameChange::AboutToBeDeleted, id));
+    bool is_deleted = false;
+    try
+    {
+        is_deleted = storage(installation_type).deleteGame(id);
+    }
+    catch(...)
+    {
+        discardChanges();
+        throw;
+    }
+    if(!is_deleted)
+    {
+        discardChanges();
+        throw Exception(tr("Unable to delete game \"%1\"").arg(title));
+    }
+    emitChanges(locker);
 }
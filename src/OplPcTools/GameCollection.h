@@ -19,14 +19,41 @@
 #ifndef __OPLPCTOOLS_GAMECOLLECTION__
 #define __OPLPCTOOLS_GAMECOLLECTION__
 
+#include <memory>
 #include <QObject>
 #include <QDir>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSharedPointer>
 #include <OplPcTools/Game.h>
 #include <OplPcTools/UlConfigGameStorage.h>
 #include <OplPcTools/DirectoryGameStorage.h>
+#include <OplPcTools/GameCollectionSnapshot.h>
+#include <OplPcTools/JobScheduler.h>
 
 namespace OplPcTools {
 
+struct GameCollectionLoadingState;
+
+// Immutable list of the games: the UL games followed by the directory games.
+// The unchanged games are shared between the lists published by the consecutive changes of a collection.
+typedef QVector<QSharedPointer<const Game>> GameList;
+typedef std::shared_ptr<const GameList> GameListPointer;
+
+/*
+ * All the changes of the collection are serialized by one mutex and publish a new GameList.
+ * Readers take the current list with games() without locking and may keep it as long as they need,
+ * e.g. a model on the UI thread while an installer adds a game on a worker thread.
+ * The signals are emitted on the thread that made the change, after the list has been published and the mutex
+ * has been released, so the receivers may read and change the collection. gameAboutToBeDeleted is queued the same way
+ * and precedes gameDeleted, a receiver that needs the deleted game takes it from the list it holds.
+ * A change that fails reports nothing.
+ * count(), operator [] and findGame() read the current list, the returned games stay valid as long as
+ * the caller holds the pointers. An index is only meaningful for the code that does not race with the writers.
+ */
 class GameCollection final : public QObject
 {
     Q_OBJECT
@@ -35,29 +62,69 @@ public:
     explicit GameCollection(QObject * _parent = nullptr);
     ~GameCollection() override;
     void load(const QDir & _directory);
+    void load(const QDir & _directory, const GameCollectionSnapshot & _hint);
+    void loadInBackground(const QDir & _directory, const GameCollectionSnapshot & _hint = GameCollectionSnapshot());
+    bool isLoading() const;
+    void restore(const GameCollectionSnapshot & _snapshot);
+    void merge(const GameCollectionSnapshot & _snapshot);
+    GameCollectionSnapshot snapshot() const;
+    int revision() const;
     bool isLoaded() const;
     const QString & directory() const;
-    const Game * findGame(const QString & _id) const;
+    GameListPointer games() const;
+    QSharedPointer<const Game> game(const QString & _id) const;
+    QSharedPointer<const Game> findGame(const QString & _id) const;
     int count() const;
-    const Game * operator [](int _index) const;
+    QSharedPointer<const Game> operator [](int _index) const;
     void addGame(const Game & _game);
     void renameGame(const Game & _game, const QString & _title);
     void deleteGame(const Game & _game);
+    static QStringList gameFiles(const QString & _directory, const Game & _game);
 
 signals:
+    void loadingStarted();
+    void gamesLoaded(int _count);
+    void loadingFinished();
+    void loadingFailed(const QString & _message);
     void loaded();
     void gameAboutToBeDeleted(const QString _game_id);
     void gameDeleted(const QString & _game_id);
     void gameAdded(const QString & _game_id);
     void gameRenamed(const QString & _game_id);
 
+private:
+    enum class GameChange
+    {
+        Added,
+        Renamed,
+        AboutToBeDeleted,
+        Deleted
+    };
+
 private:
     GameStorage & storage(GameInstallationType _installation_type) const;
+    void cancelLoading();
+    void publish(GameList && _games);
+    void publishAll();
+    void publishAppended(int _ul_count, int _dir_count);
+    void publishChanged(const QString & _id);
+    void onGameRegistered(const QString & _id);
+    void onGameRenamed(const QString & _id);
+    void onGameDeleted(const QString & _id);
+    void emitChanges(QMutexLocker & _locker);
+    void discardChanges();
+    Q_INVOKABLE void takeLoadedGames();
 
 private:
     QString m_directory;
+    mutable QMutex m_mutation_mutex;
+    QAtomicInt m_revision;
     UlConfigGameStorage * mp_ul_conf_storage;
     DirectoryGameStorage * mp_dir_storage;
+    GameListPointer m_games;
+    QList<QPair<GameChange, QString>> m_changes; // Published under the mutation mutex, reported after it is released
+    QList<JobPointer> m_loading_jobs;
+    QSharedPointer<GameCollectionLoadingState> m_loading_state;
 };
 
 } // namespace OplPcTools
@@ -0,0 +1,133 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameCollectionSnapshot.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const quint32 g_magic = 0x4F505453; // OPTS
+const quint32 g_version = 1;
+const QDataStream::Version g_stream_version = QDataStream::Qt_5_6;
+
+void writeGames(QDataStream & _stream, const QList<Game> & _games)
+{
+    _stream << static_cast<quint32>(_games.count());
+    for(const Game & game : _games)
+    {
+        _stream << game.id() << game.title()
+            << static_cast<quint8>(game.mediaType())
+            << static_cast<quint8>(game.partCount());
+    }
+}
+
+bool readGames(QDataStream & _stream, GameInstallationType _installation_type, QList<Game> & _games)
+{
+    quint32 count = 0;
+    _stream >> count;
+    for(quint32 i = 0; i < count && _stream.status() == QDataStream::Ok; ++i)
+    {
+        QString id, title;
+        quint8 media_type = 0, part_count = 0;
+        _stream >> id >> title >> media_type >> part_count;
+        if(media_type > static_cast<quint8>(MediaType::DVD))
+            return false;
+        Game game(id, _installation_type);
+        game.setTitle(title);
+        game.setMediaType(static_cast<MediaType>(media_type));
+        game.setPartCount(part_count);
+        _games.append(game);
+    }
+    return _stream.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+QString GameCollectionSnapshot::filepath(const QString & _cache_directory, const QString & _library_directory)
+{
+    QString name = QString::fromLatin1(QCryptographicHash::hash(
+        QDir(_library_directory).absolutePath().toUtf8(), QCryptographicHash::Sha1).toHex());
+    return QDir(_cache_directory).absoluteFilePath(name + ".collection");
+}
+
+bool GameCollectionSnapshot::load(const QString & _filepath)
+{
+    OPT_TRACE_SCOPE("GameCollectionSnapshot::load");
+    QFile file(_filepath);
+    if(!file.open(QIODevice::ReadOnly) || file.size() == 0)
+        return false;
+    uchar * data = file.map(0, file.size());
+    if(!data)
+        return false;
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(file.size()));
+    QDataStream stream(bytes);
+    stream.setVersion(g_stream_version);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    bool result = false;
+    if(magic == g_magic && version == g_version)
+    {
+        GameCollectionSnapshot snapshot;
+        stream >> snapshot.directory;
+        if(readGames(stream, GameInstallationType::UlConfig, snapshot.ul_games) &&
+            readGames(stream, GameInstallationType::Directory, snapshot.directory_games))
+        {
+            quint32 count = 0;
+            stream >> count;
+            for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+            {
+                DirectoryGameImage image;
+                stream >> image.filepath >> image.game_id >> image.size >> image.mtime;
+                snapshot.directory_images.append(image);
+            }
+            if(stream.status() == QDataStream::Ok)
+            {
+                *this = snapshot;
+                result = true;
+            }
+        }
+    }
+    file.unmap(data);
+    return result;
+}
+
+bool GameCollectionSnapshot::save(const QString & _filepath) const
+{
+    OPT_TRACE_SCOPE("GameCollectionSnapshot::save");
+    QDir().mkpath(QFileInfo(_filepath).absolutePath());
+    QSaveFile file(_filepath);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(g_stream_version);
+    stream << g_magic << g_version << directory;
+    writeGames(stream, ul_games);
+    writeGames(stream, directory_games);
+    stream << static_cast<quint32>(directory_images.count());
+    for(const DirectoryGameImage & image : directory_images)
+        stream << image.filepath << image.game_id << image.size << image.mtime;
+    return stream.status() == QDataStream::Ok && file.commit();
+}
@@ -0,0 +1,55 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMECOLLECTIONSNAPSHOT__
+#define __OPLPCTOOLS_GAMECOLLECTIONSNAPSHOT__
+
+#include <QList>
+#include <QString>
+#include <OplPcTools/Game.h>
+
+namespace OplPcTools {
+
+// Identity of an ISO image of a directory installation: the image is not probed again while it stays the same
+struct DirectoryGameImage
+{
+    QString filepath;
+    QString game_id;
+    qint64 size;
+    qint64 mtime;
+};
+
+/*
+ * Everything needed to show a library without reading it: the games of both storages
+ * and the identities of the ISO images. Saved in a versioned binary file, which is memory-mapped for reading.
+ */
+struct GameCollectionSnapshot
+{
+    QString directory;
+    QList<Game> ul_games;
+    QList<Game> directory_games;
+    QList<DirectoryGameImage> directory_images;
+
+    static QString filepath(const QString & _cache_directory, const QString & _library_directory);
+    bool load(const QString & _filepath);
+    bool save(const QString & _filepath) const;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMECOLLECTIONSNAPSHOT__
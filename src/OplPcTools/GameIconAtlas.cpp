@@ -0,0 +1,292 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <cstddef>
+#include <cstring>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <OplPcTools/GameIconAtlas.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const char g_magic[8] = { 'O', 'P', 'T', 'I', 'C', 'O', 'N', 'S' };
+const quint32 g_version = 1;
+const qint64 g_header_size = 64;
+const int g_id_size = 48;
+const qint64 g_slot_header_size = 64;
+const int g_grow_step = 64;
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 slot_size;
+    quint32 slot_count;
+};
+
+struct SlotHeader
+{
+    char id[g_id_size];
+    qint64 source_mtime;
+    qint64 source_size;
+};
+
+static_assert(sizeof(FileHeader) <= g_header_size, "Atlas header does not fit");
+static_assert(sizeof(SlotHeader) == g_slot_header_size, "Unexpected atlas slot header size");
+
+inline int levelSize(int _level)
+{
+    return (_level + 1) * GameIconAtlas::level_step;
+}
+
+qint64 levelOffset(int _level)
+{
+    qint64 offset = g_slot_header_size;
+    for(int i = 0; i < _level; ++i)
+        offset += static_cast<qint64>(levelSize(i)) * levelSize(i) * 4;
+    return offset;
+}
+
+const qint64 g_slot_size = levelOffset(GameIconAtlas::level_count);
+
+} // namespace
+
+GameIconAtlas::GameIconAtlas(const QString & _filepath) :
+    m_file(_filepath),
+    mp_data(nullptr),
+    m_slot_count(0)
+{
+}
+
+GameIconAtlas::~GameIconAtlas()
+{
+    close();
+}
+
+bool GameIconAtlas::open()
+{
+    QMutexLocker locker(&m_mutex);
+    if(mp_data)
+        return true;
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+    if(!m_file.open(QIODevice::ReadWrite))
+        return false;
+    bool valid = false;
+    if(m_file.size() >= g_header_size)
+    {
+        FileHeader header;
+        if(m_file.read(reinterpret_cast<char *>(&header), sizeof(FileHeader)) == sizeof(FileHeader) &&
+            std::memcmp(header.magic, g_magic, sizeof(g_magic)) == 0 &&
+            header.version == g_version &&
+            header.slot_size == g_slot_size &&
+            m_file.size() == g_header_size + static_cast<qint64>(header.slot_count) * g_slot_size)
+        {
+            m_slot_count = header.slot_count;
+            valid = true;
+        }
+    }
+    // A foreign or truncated file is just a cache: start from scratch
+    if(!(valid ? map() : reset()))
+    {
+        m_file.close();
+        return false;
+    }
+    readIndex();
+    return true;
+}
+
+void GameIconAtlas::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if(mp_data)
+    {
+        m_file.unmap(mp_data);
+        mp_data = nullptr;
+    }
+    m_file.close();
+    m_index.clear();
+    m_free_slots.clear();
+    m_slot_count = 0;
+}
+
+bool GameIconAtlas::reset()
+{
+    m_slot_count = 0;
+    if(!m_file.resize(g_header_size))
+        return false;
+    if(!map())
+        return false;
+    FileHeader header;
+    std::memset(mp_data, 0, g_header_size);
+    std::memcpy(header.magic, g_magic, sizeof(g_magic));
+    header.version = g_version;
+    header.slot_size = g_slot_size;
+    header.slot_count = 0;
+    std::memcpy(mp_data, &header, sizeof(FileHeader));
+    return true;
+}
+
+bool GameIconAtlas::map()
+{
+    if(mp_data)
+    {
+        m_file.unmap(mp_data);
+        mp_data = nullptr;
+    }
+    mp_data = m_file.map(0, m_file.size());
+    return mp_data != nullptr;
+}
+
+bool GameIconAtlas::grow()
+{
+    int new_count = m_slot_count + g_grow_step;
+    if(mp_data)
+    {
+        m_file.unmap(mp_data);
+        mp_data = nullptr;
+    }
+    if(!m_file.resize(g_header_size + new_count * g_slot_size) || !map())
+    {
+        // The atlas is unusable without the mapping
+        m_index.clear();
+        m_free_slots.clear();
+        m_slot_count = 0;
+        return false;
+    }
+    for(int i = m_slot_count; i < new_count; ++i)
+    {
+        std::memset(slot(i), 0, g_slot_header_size);
+        m_free_slots.append(i);
+    }
+    m_slot_count = new_count;
+    quint32 slot_count = m_slot_count;
+    std::memcpy(mp_data + offsetof(FileHeader, slot_count), &slot_count, sizeof(slot_count));
+    return true;
+}
+
+void GameIconAtlas::readIndex()
+{
+    m_index.clear();
+    m_free_slots.clear();
+    for(int i = 0; i < m_slot_count; ++i)
+    {
+        const char * id = reinterpret_cast<const char *>(slot(i));
+        if(id[0] == '\0')
+            m_free_slots.append(i);
+        else
+            m_index[QString::fromUtf8(id, qstrnlen(id, g_id_size))] = i;
+    }
+}
+
+uchar * GameIconAtlas::slot(int _index) const
+{
+    return mp_data + g_header_size + static_cast<qint64>(_index) * g_slot_size;
+}
+
+bool GameIconAtlas::contains(const QString & _game_id) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.contains(_game_id);
+}
+
+bool GameIconAtlas::isUpToDate(const QString & _game_id, qint64 _source_mtime, qint64 _source_size) const
+{
+    QMutexLocker locker(&m_mutex);
+    int index = m_index.value(_game_id, -1);
+    if(index < 0)
+        return false;
+    SlotHeader header;
+    std::memcpy(&header, slot(index), sizeof(SlotHeader));
+    return header.source_mtime == _source_mtime && header.source_size == _source_size;
+}
+
+QImage GameIconAtlas::image(const QString & _game_id, int _size) const
+{
+    int level = qBound(0, _size / level_step - 1, level_count - 1);
+    int size = levelSize(level);
+    QMutexLocker locker(&m_mutex);
+    int index = m_index.value(_game_id, -1);
+    if(index < 0)
+        return QImage();
+    // The mapping can move when the atlas grows, so the caller gets its own copy of the pixels
+    return QImage(slot(index) + levelOffset(level), size, size, size * 4, QImage::Format_ARGB32_Premultiplied).copy();
+}
+
+void GameIconAtlas::store(const QString & _game_id, const QImage & _icon, qint64 _source_mtime, qint64 _source_size, bool _overwrite)
+{
+    QByteArray id = _game_id.toUtf8();
+    if(id.isEmpty() || id.size() >= g_id_size || _icon.isNull())
+        return;
+    if(!_overwrite && contains(_game_id))
+        return;
+    QImage levels[level_count];
+    QImage icon = _icon.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    for(int level = 0; level < level_count; ++level)
+    {
+        int size = levelSize(level);
+        levels[level] = icon.size() == QSize(size, size) ? icon :
+            icon.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    QMutexLocker locker(&m_mutex);
+    if(mp_data == nullptr)
+        return;
+    int index = m_index.value(_game_id, -1);
+    if(index >= 0 && !_overwrite)
+        return;
+    if(index < 0)
+    {
+        if(m_free_slots.isEmpty() && !grow())
+            return;
+        index = m_free_slots.takeLast();
+    }
+    uchar * data = slot(index);
+    for(int level = 0; level < level_count; ++level)
+    {
+        int size = levelSize(level);
+        uchar * pixels = data + levelOffset(level);
+        for(int y = 0; y < size; ++y)
+            std::memcpy(pixels + y * size * 4, levels[level].constScanLine(y), size * 4);
+    }
+    SlotHeader header;
+    std::memset(&header, 0, sizeof(SlotHeader));
+    std::memcpy(header.id, id.constData(), id.size());
+    header.source_mtime = _source_mtime;
+    header.source_size = _source_size;
+    std::memcpy(data, &header, sizeof(SlotHeader));
+    m_index[_game_id] = index;
+}
+
+void GameIconAtlas::remove(const QString & _game_id)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_index.find(_game_id);
+    if(it == m_index.end())
+        return;
+    std::memset(slot(it.value()), 0, g_slot_header_size);
+    m_free_slots.append(it.value());
+    m_index.erase(it);
+}
+
+QStringList GameIconAtlas::gameIds() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index.keys();
+}
@@ -0,0 +1,74 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMEICONATLAS__
+#define __OPLPCTOOLS_GAMEICONATLAS__
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+
+namespace OplPcTools {
+
+/*
+ * A memory-mapped file with pre-scaled game icons for every icon size of the game list (16, 32, 48 and 64 pixels).
+ * Each game occupies a fixed-size slot that stores the modification time and the size of the source file,
+ * so an entry can be validated without decoding the image and can be replaced in place.
+ * All the methods are thread-safe.
+ */
+class GameIconAtlas final
+{
+    Q_DISABLE_COPY(GameIconAtlas)
+
+public:
+    static const int level_count = 4;
+    static const int level_step = 16;
+
+public:
+    explicit GameIconAtlas(const QString & _filepath);
+    ~GameIconAtlas();
+    bool open();
+    void close();
+    bool contains(const QString & _game_id) const;
+    bool isUpToDate(const QString & _game_id, qint64 _source_mtime, qint64 _source_size) const;
+    QImage image(const QString & _game_id, int _size) const;
+    void store(const QString & _game_id, const QImage & _icon, qint64 _source_mtime, qint64 _source_size, bool _overwrite);
+    void remove(const QString & _game_id);
+    QStringList gameIds() const;
+
+private:
+    bool map();
+    bool reset();
+    bool grow();
+    void readIndex();
+    uchar * slot(int _index) const;
+
+private:
+    mutable QMutex m_mutex;
+    QFile m_file;
+    uchar * mp_data;
+    int m_slot_count;
+    QHash<QString, int> m_index;
+    QVector<int> m_free_slots;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMEICONATLAS__
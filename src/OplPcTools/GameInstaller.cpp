@@ -29,7 +29,8 @@ GameInstaller::GameInstaller(Device & _device, GameCollection & _collection, QOb
 
 MediaType GameInstaller::deviceMediaType() const
 {
-    const quint64 iso_size = mr_device.size();
+    // Trimming must not turn a small DVD into a CD
+    const quint64 iso_size = mr_device.declaredSize();
     MediaType type = mr_device.mediaType();
     if(type == MediaType::Unknown)
         type = iso_size > 681984000 ? MediaType::DVD : MediaType::CD;
@@ -23,6 +23,7 @@
 #include <QStringList>
 #include <OplPcTools/GameCollection.h>
 #include <OplPcTools/Device.h>
+#include <OplPcTools/TransferProgress.h>
 
 namespace OplPcTools {
 
@@ -34,13 +35,14 @@ public:
     GameInstaller(Device & _device, GameCollection & _collection, QObject * _parent = nullptr);
     virtual bool install() = 0;
     virtual const Game * installedGame() const = 0;
+    inline const TransferProgress & transferProgress() const;
 
 signals:
-    void progress(quint64 _total_bytes, quint64 _done_bytes);
     void registrationStarted();
     void registrationFinished();
     void rollbackStarted();
     void rollbackFinished();
+    void suspended(const QString & _journal_filepath);
 
 protected:
     MediaType deviceMediaType() const;  
@@ -48,8 +50,15 @@ protected:
 protected:
     Device & mr_device;
     GameCollection & mr_collection;
+    TransferProgress m_progress;
+    QString m_journal_filepath;
 };
 
+const TransferProgress & GameInstaller::transferProgress() const
+{
+    return m_progress;
+}
+
 } // namespace OplPcTools
 
 #endif // __OPLPCTOOLS_GAMEINSTALLER__
@@ -0,0 +1,153 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/GameSearchIndex.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const int g_trigram_length = 3;
+
+} // namespace
+
+GameSearchIndex::GameSearchIndex()
+{
+}
+
+void GameSearchIndex::insert(const QString & _game_id, const QString & _title)
+{
+    remove(_game_id);
+    int index;
+    if(m_free_documents.isEmpty())
+    {
+        index = m_documents.count();
+        m_documents.append(Document());
+    }
+    else
+    {
+        index = m_free_documents.takeLast();
+    }
+    Document & document = m_documents[index];
+    document.game_id = _game_id;
+    const QString title = normalize(_title);
+    const QString id = normalize(_game_id);
+    document.text = title + QChar('\n') + id;
+    // The title and the ID are split to not produce the trigrams spanning both of them
+    document.trigrams = trigrams(title) + trigrams(id);
+    std::sort(document.trigrams.begin(), document.trigrams.end());
+    document.trigrams.erase(std::unique(document.trigrams.begin(), document.trigrams.end()), document.trigrams.end());
+    for(Trigram trigram : document.trigrams)
+        m_postings[trigram].append(index);
+    m_document_ids.insert(_game_id, index);
+}
+
+void GameSearchIndex::remove(const QString & _game_id)
+{
+    auto it = m_document_ids.find(_game_id);
+    if(it == m_document_ids.end())
+        return;
+    const int index = it.value();
+    m_document_ids.erase(it);
+    Document & document = m_documents[index];
+    for(Trigram trigram : document.trigrams)
+    {
+        auto posting = m_postings.find(trigram);
+        posting->removeOne(index);
+        if(posting->isEmpty())
+            m_postings.erase(posting);
+    }
+    document = Document();
+    m_free_documents.append(index);
+}
+
+void GameSearchIndex::clear()
+{
+    m_documents.clear();
+    m_free_documents.clear();
+    m_document_ids.clear();
+    m_postings.clear();
+}
+
+QSet<QString> GameSearchIndex::search(const QString & _query) const
+{
+    OPT_TRACE_SCOPE("GameSearchIndex::search");
+    QSet<QString> result;
+    const QString query = normalize(_query.trimmed());
+    if(query.isEmpty())
+        return result;
+    const QVector<Trigram> query_trigrams = trigrams(query);
+    if(query_trigrams.isEmpty())
+    {
+        for(const Document & document : m_documents)
+        {
+            if(!document.game_id.isEmpty() && document.text.contains(query))
+                result.insert(document.game_id);
+        }
+        return result;
+    }
+    const int required_count = requiredTrigramCount(query_trigrams.count());
+    QVector<quint16> hits(m_documents.count(), 0);
+    for(Trigram trigram : query_trigrams)
+    {
+        auto posting = m_postings.constFind(trigram);
+        if(posting == m_postings.cend())
+            continue;
+        for(int index : *posting)
+        {
+            if(++hits[index] == required_count)
+                result.insert(m_documents[index].game_id);
+        }
+    }
+    return result;
+}
+
+QString GameSearchIndex::normalize(const QString & _text)
+{
+    return _text.toCaseFolded();
+}
+
+// Unique trigrams of the _text, each packed into an integer
+QVector<GameSearchIndex::Trigram> GameSearchIndex::trigrams(const QString & _text)
+{
+    QVector<Trigram> result;
+    const int count = _text.size() - g_trigram_length + 1;
+    if(count <= 0)
+        return result;
+    result.reserve(count);
+    for(int i = 0; i < count; ++i)
+    {
+        result.append(
+            static_cast<Trigram>(_text[i].unicode()) << 32 |
+            static_cast<Trigram>(_text[i + 1].unicode()) << 16 |
+            static_cast<Trigram>(_text[i + 2].unicode()));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+// A typo breaks up to three trigrams of the query, so the longer queries tolerate more missing trigrams
+int GameSearchIndex::requiredTrigramCount(int _query_trigram_count)
+{
+    if(_query_trigram_count <= 2)
+        return _query_trigram_count;
+    return std::max(2, (_query_trigram_count * 2 + 2) / 3);
+}
@@ -0,0 +1,75 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMESEARCHINDEX__
+#define __OPLPCTOOLS_GAMESEARCHINDEX__
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QString>
+
+namespace OplPcTools {
+
+/*
+ * Trigram index over the titles and the IDs of the games.
+ * A query matches a game if the game contains the most of the trigrams of the query,
+ * so a query with a typo still finds the game. The queries shorter than a trigram are matched as substrings.
+ * The matching is case-insensitive.
+ */
+class GameSearchIndex final
+{
+    Q_DISABLE_COPY(GameSearchIndex)
+
+    using Trigram = quint64;
+
+    struct Document
+    {
+        QString game_id;
+        QString text;
+        QVector<Trigram> trigrams;
+    };
+
+public:
+    GameSearchIndex();
+    void insert(const QString & _game_id, const QString & _title);
+    void remove(const QString & _game_id);
+    void clear();
+    int count() const;
+    QSet<QString> search(const QString & _query) const;
+
+private:
+    static QString normalize(const QString & _text);
+    static QVector<Trigram> trigrams(const QString & _text);
+    static int requiredTrigramCount(int _query_trigram_count);
+
+private:
+    QVector<Document> m_documents;
+    QVector<int> m_free_documents;
+    QHash<QString, int> m_document_ids;
+    QHash<Trigram, QVector<int>> m_postings;
+};
+
+inline int GameSearchIndex::count() const
+{
+    return m_document_ids.count();
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMESEARCHINDEX__
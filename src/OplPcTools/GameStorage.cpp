@@ -16,13 +16,24 @@
  *                                                                                             *
  ***********************************************************************************************/
 
+#include <QHash>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
 #include <OplPcTools/GameStorage.h>
 
 using namespace OplPcTools;
 
+namespace {
+
+const qint64 g_max_discovery_interval = 100;
+
+} // namespace
+
 GameStorage::GameStorage(QObject * _parent /*= nullptr*/) :
-    QObject(_parent)
+    QObject(_parent),
+    m_discovery_batch_size(0),
+    m_discovered_count(0),
+    mp_cancellation_flag(nullptr)
 {
 }
 
@@ -36,6 +47,7 @@ void GameStorage::clear()
     for(Game * game : m_games)
         delete game;
     m_games.clear();
+    m_discovered_count = 0;
 }
 
 const Game * GameStorage::operator [](int _index) const
@@ -66,15 +78,122 @@ Game * GameStorage::findNonConstGame(const QString & _id) const
 
 bool GameStorage::load(const QDir & _directory)
 {
+    OPT_TRACE_SCOPE("GameStorage::load");
     clear();
+    m_discovery_timer.start();
     if(performLoading(_directory))
     {
+        reportDiscoveredGames(true);
         emit loaded();
         return true;
     }
     return false;
 }
 
+// Shows the _games without touching the storage, e.g. from a snapshot
+void GameStorage::restore(const QDir & _directory, const QList<Game> & _games)
+{
+    clear();
+    performRestoring(_directory);
+    m_games.reserve(_games.count());
+    for(const Game & game : _games)
+        m_games.append(new Game(game));
+    emit loaded();
+}
+
+// Applies the difference between the current games and the _games, notifying about every change.
+// Changes of the media type and the part count are reported as renaming.
+void GameStorage::merge(const QList<Game> & _games)
+{
+    QHash<QString, const Game *> new_games;
+    for(const Game & game : _games)
+        new_games.insert(game.id(), &game);
+    for(int i = m_games.count() - 1; i >= 0; --i)
+    {
+        Game * game = m_games[i];
+        const Game * new_game = new_games.value(game->id());
+        if(new_game == nullptr)
+        {
+            const QString id = game->id();
+            emit gameAboutToBeDeleted(id);
+            m_games.remove(i);
+            delete game;
+            emit gameDeleted(id);
+        }
+        else
+        {
+            if(game->title() != new_game->title() || game->mediaType() != new_game->mediaType() ||
+                game->partCount() != new_game->partCount())
+            {
+                *game = *new_game;
+                emit gameRenamed(game->id());
+            }
+            new_games.remove(game->id());
+        }
+    }
+    for(const Game & game : _games)
+    {
+        if(new_games.contains(game.id()))
+        {
+            m_games.append(new Game(game));
+            emit gameRegistered(game.id());
+        }
+    }
+}
+
+// Adds the already loaded _games, e.g. reported by gamesDiscovered of another storage
+void GameStorage::append(const QList<Game> & _games)
+{
+    m_games.reserve(m_games.count() + _games.count());
+    for(const Game & game : _games)
+        m_games.append(new Game(game));
+}
+
+// Makes the loading report the created games with gamesDiscovered in batches of up to _size games.
+// A batch is reported earlier if the loading is slow. Zero disables the reporting.
+void GameStorage::setDiscoveryBatchSize(int _size)
+{
+    m_discovery_batch_size = _size;
+}
+
+// The loading is interrupted as soon as the _flag is set
+void GameStorage::setCancellationFlag(const QAtomicInt * _flag)
+{
+    mp_cancellation_flag = _flag;
+}
+
+bool GameStorage::isLoadingCanceled() const
+{
+    return mp_cancellation_flag && mp_cancellation_flag->load();
+}
+
+void GameStorage::reportDiscoveredGames(bool _force)
+{
+    if(m_discovery_batch_size <= 0)
+        return;
+    const int pending_count = m_games.count() - m_discovered_count;
+    if(pending_count == 0)
+        return;
+    if(!_force && pending_count < m_discovery_batch_size && !m_discovery_timer.hasExpired(g_max_discovery_interval))
+        return;
+    QList<Game> games;
+    games.reserve(pending_count);
+    for(int i = m_discovered_count; i < m_games.count(); ++i)
+        games.append(*m_games[i]);
+    m_discovered_count = m_games.count();
+    m_discovery_timer.restart();
+    emit gamesDiscovered(games);
+}
+
+QList<Game> GameStorage::games() const
+{
+    QList<Game> result;
+    result.reserve(m_games.count());
+    for(const Game * game : m_games)
+        result.append(*game);
+    return result;
+}
+
 int GameStorage::count() const
 {
     return m_games.count();
@@ -82,6 +201,8 @@ int GameStorage::count() const
 
 Game * GameStorage::createGame(const QString & _id)
 {
+    // The previously created games are complete at this point
+    reportDiscoveredGames(false);
     Game * game = new Game(_id, installationType());
     m_games.append(game);
     return game;
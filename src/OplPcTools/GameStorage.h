@@ -22,6 +22,8 @@
 #include <QDir>
 #include <QVector>
 #include <QObject>
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <OplPcTools/Game.h>
 
 namespace OplPcTools {
@@ -36,6 +38,12 @@ public:
     const Game * operator [](int _index) const;
     const Game * findGame(const QString & _id) const;
     bool load(const QDir & _directory);
+    void restore(const QDir & _directory, const QList<Game> & _games);
+    void merge(const QList<Game> & _games);
+    void append(const QList<Game> & _games);
+    QList<Game> games() const;
+    void setDiscoveryBatchSize(int _size);
+    void setCancellationFlag(const QAtomicInt * _flag);
     int count() const;
     bool renameGame(const QString & _id, const QString & _title);
     bool renameGame(const int _index, const QString & _title);
@@ -51,6 +59,7 @@ public:
 
 signals:
     void loaded();
+    void gamesDiscovered(const QList<Game> & _games);
     void gameRegistered(const QString & _game_id);
     void gameRenamed(const QString & _game_id);
     void gameAboutToBeDeleted(const QString & _game_id);
@@ -61,8 +70,10 @@ protected:
     Game * createGame(const QString & _id);
     Game * findNonConstGame(const QString & _id) const;
     Game * gameAt(int _index) const;
+    bool isLoadingCanceled() const;
 
     virtual bool performLoading(const QDir & _directory) = 0;
+    virtual void performRestoring(const QDir & _directory) = 0;
     virtual bool performRenaming(const Game & _game, const QString & _title) = 0;
     virtual bool performRegistration(const Game & _game) = 0;
     virtual bool performDeletion(const Game & _game) = 0;
@@ -70,9 +81,14 @@ protected:
 private:
     void clear();
     bool renameGame(Game * _game, const QString & _title);
+    void reportDiscoveredGames(bool _force);
 
 private:
     QVector<Game *> m_games;
+    int m_discovery_batch_size;
+    int m_discovered_count;
+    QElapsedTimer m_discovery_timer;
+    const QAtomicInt * mp_cancellation_flag;
 };
 
 } // namespace OplPcTools
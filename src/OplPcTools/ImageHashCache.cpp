@@ -0,0 +1,219 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <limits>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QSet>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/Device.h>
+#include <OplPcTools/Iso9660Structures.h>
+#include <OplPcTools/Iso9660DeviceSource.h>
+#include <OplPcTools/MultipartDeviceSource.h>
+#include <OplPcTools/ImageHashCache.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const quint32 g_magic = 0x4F505448; // OPTH
+const quint32 g_version = 1;
+const QDataStream::Version g_stream_version = QDataStream::Qt_5_6;
+const qint64 g_read_size = 4194304;
+const qint64 g_block_count_offset = ISO9660_OFFSET + 80;
+const qint64 g_block_count_size = 8;
+const QCryptographicHash::Algorithm g_hash_algorithm = QCryptographicHash::Sha1;
+
+inline QString makeKey(const QStringList & _filepaths)
+{
+    return _filepaths.join('\n');
+}
+
+} // namespace
+
+ImageHashCache::ImageHashCache()
+{
+}
+
+QString ImageHashCache::filepath(const QString & _cache_directory, const QString & _library_directory)
+{
+    QString name = QString::fromLatin1(QCryptographicHash::hash(
+        QDir(_library_directory).absolutePath().toUtf8(), QCryptographicHash::Sha1).toHex());
+    return QDir(_cache_directory).absoluteFilePath(name + ".hashes");
+}
+
+void ImageHashCache::readIdentity(const QStringList & _filepaths, ImageHash & _hash)
+{
+    _hash.filepaths = _filepaths;
+    _hash.sizes.clear();
+    _hash.mtimes.clear();
+    for(const QString & filepath : _filepaths)
+    {
+        QFileInfo file_info(filepath);
+        _hash.sizes.append(file_info.size());
+        _hash.mtimes.append(file_info.lastModified().toMSecsSinceEpoch());
+    }
+}
+
+// Reads all the files once, the content hash stops at the end of the last extent found by the file system
+bool ImageHashCache::computeHash(const QStringList & _filepaths, const QAtomicInt & _is_canceled, ImageHash & _hash, QString & _error)
+{
+    OPT_TRACE_SCOPE("ImageHashCache::computeHash");
+    readIdentity(_filepaths, _hash);
+    QSharedPointer<DeviceSource> source(_filepaths.count() == 1 ?
+        static_cast<DeviceSource *>(new Iso9660DeviceSource(_filepaths.first())) :
+        static_cast<DeviceSource *>(new MultipartDeviceSource(_filepaths)));
+    // The padding is everything after the last extent, an image without a file system is hashed completely
+    Device device(source);
+    _hash.content_size = device.init() ? device.usedSize() : std::numeric_limits<quint64>::max();
+    if(!source->isOpen() && !source->open())
+    {
+        _error = QObject::tr("Unable to open file to read: \"%1\"").arg(_filepaths.first());
+        return false;
+    }
+    source->seek(0);
+    QCryptographicHash content_hash(g_hash_algorithm);
+    QCryptographicHash full_hash(g_hash_algorithm);
+    QByteArray buffer(g_read_size, Qt::Uninitialized);
+    quint64 offset = 0;
+    for(;;)
+    {
+        if(_is_canceled.load() != 0)
+            return false;
+        qint64 read_bytes = 0;
+        {
+            OPT_TRACE_SCOPE("read");
+            read_bytes = source->read(buffer);
+        }
+        if(read_bytes < 0)
+        {
+            _error = QObject::tr("Unable to read the file: \"%1\"").arg(_filepaths.first());
+            return false;
+        }
+        if(read_bytes == 0)
+            break;
+        full_hash.addData(buffer.constData(), static_cast<int>(read_bytes));
+        if(offset < _hash.content_size)
+        {
+            const qint64 content_bytes = static_cast<qint64>(qMin<quint64>(read_bytes, _hash.content_size - offset));
+            const qint64 position = static_cast<qint64>(offset);
+            if(position < g_block_count_offset + g_block_count_size && position + content_bytes > g_block_count_offset)
+            {
+                // Trimming rewrites the volume size, it must not make the content different
+                for(qint64 i = qMax<qint64>(g_block_count_offset - position, 0);
+                    i < qMin<qint64>(g_block_count_offset + g_block_count_size - position, content_bytes); ++i)
+                {
+                    buffer[static_cast<int>(i)] = 0;
+                }
+            }
+            content_hash.addData(buffer.constData(), static_cast<int>(content_bytes));
+        }
+        offset += read_bytes;
+        OPT_TRACE_COUNTER("hashed bytes", offset);
+        Job::throttleCurrentJob(static_cast<quint64>(read_bytes));
+        if(read_bytes < g_read_size)
+            break;
+    }
+    _hash.content_hash = content_hash.result();
+    _hash.full_hash = full_hash.result();
+    return true;
+}
+
+bool ImageHashCache::find(const QStringList & _filepaths, ImageHash & _hash) const
+{
+    ImageHash identity;
+    readIdentity(_filepaths, identity);
+    QMutexLocker locker(&m_mutex);
+    auto it = m_hashes.constFind(makeKey(_filepaths));
+    if(it == m_hashes.cend() || it->sizes != identity.sizes || it->mtimes != identity.mtimes)
+        return false;
+    _hash = *it;
+    return true;
+}
+
+void ImageHashCache::insert(const ImageHash & _hash)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hashes.insert(makeKey(_hash.filepaths), _hash);
+}
+
+// Drops the hashes of the images that are not in the library anymore
+void ImageHashCache::retain(const QList<QStringList> & _filepaths)
+{
+    QSet<QString> keys;
+    for(const QStringList & filepaths : _filepaths)
+        keys.insert(makeKey(filepaths));
+    QMutexLocker locker(&m_mutex);
+    for(auto it = m_hashes.begin(); it != m_hashes.end();)
+    {
+        if(keys.contains(it.key()))
+            ++it;
+        else
+            it = m_hashes.erase(it);
+    }
+}
+
+bool ImageHashCache::load(const QString & _filepath)
+{
+    OPT_TRACE_SCOPE("ImageHashCache::load");
+    QFile file(_filepath);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(g_stream_version);
+    quint32 magic = 0, version = 0, count = 0;
+    stream >> magic >> version;
+    if(magic != g_magic || version != g_version)
+        return false;
+    stream >> count;
+    QHash<QString, ImageHash> hashes;
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        ImageHash hash;
+        stream >> hash.filepaths >> hash.sizes >> hash.mtimes >> hash.content_size >> hash.content_hash >> hash.full_hash;
+        hashes.insert(makeKey(hash.filepaths), hash);
+    }
+    if(stream.status() != QDataStream::Ok)
+        return false;
+    QMutexLocker locker(&m_mutex);
+    m_hashes = hashes;
+    return true;
+}
+
+bool ImageHashCache::save(const QString & _filepath) const
+{
+    OPT_TRACE_SCOPE("ImageHashCache::save");
+    QDir().mkpath(QFileInfo(_filepath).absolutePath());
+    QSaveFile file(_filepath);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(g_stream_version);
+    QMutexLocker locker(&m_mutex);
+    stream << g_magic << g_version << static_cast<quint32>(m_hashes.count());
+    for(const ImageHash & hash : m_hashes)
+        stream << hash.filepaths << hash.sizes << hash.mtimes << hash.content_size << hash.content_hash << hash.full_hash;
+    return stream.status() == QDataStream::Ok && file.commit();
+}
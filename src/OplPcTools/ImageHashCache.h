@@ -0,0 +1,72 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_IMAGEHASHCACHE__
+#define __OPLPCTOOLS_IMAGEHASHCACHE__
+
+#include <QHash>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QStringList>
+#include <QByteArray>
+
+namespace OplPcTools {
+
+struct ImageHash
+{
+    ImageHash() :
+        content_size(0)
+    {
+    }
+
+    // Identity of the files, the hashes are valid while it stays the same
+    QStringList filepaths;
+    QList<qint64> sizes;
+    QList<qint64> mtimes;
+    quint64 content_size; // Bytes up to the end of the last file system extent
+    QByteArray content_hash; // Hash of the content without the padding and the declared volume size
+    QByteArray full_hash; // Hash of all the bytes of the files
+};
+
+/*
+ * Persistent hashes of the installed images, so only new and changed images are read again.
+ * Saved in a versioned binary file next to the collection snapshot. The cache is safe to use from several threads.
+ */
+class ImageHashCache final
+{
+    Q_DISABLE_COPY(ImageHashCache)
+
+public:
+    ImageHashCache();
+    static QString filepath(const QString & _cache_directory, const QString & _library_directory);
+    static void readIdentity(const QStringList & _filepaths, ImageHash & _hash);
+    static bool computeHash(const QStringList & _filepaths, const QAtomicInt & _is_canceled, ImageHash & _hash, QString & _error);
+    bool find(const QStringList & _filepaths, ImageHash & _hash) const;
+    void insert(const ImageHash & _hash);
+    void retain(const QList<QStringList> & _filepaths);
+    bool load(const QString & _filepath);
+    bool save(const QString & _filepath) const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, ImageHash> m_hashes;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_IMAGEHASHCACHE__
@@ -0,0 +1,100 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif
+#include <QThread>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/IoThrottle.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const double g_burst_duration = 0.25;
+const double g_min_capacity = 65536;
+const qint64 g_max_sleep_ms = 100;
+
+#ifdef __linux__
+const int g_ioprio_who_process = 1;
+const int g_ioprio_class_shift = 13;
+const int g_ioprio_class_best_effort = 2;
+const int g_ioprio_class_idle = 3;
+const int g_ioprio_best_effort_level = 4;
+#endif
+
+} // namespace
+
+bool OplPcTools::setThreadIoClass(IoClass _io_class)
+{
+#if defined(_WIN32)
+    return SetThreadPriority(GetCurrentThread(),
+        _io_class == IoClass::Idle ? THREAD_MODE_BACKGROUND_BEGIN : THREAD_MODE_BACKGROUND_END) != 0;
+#elif defined(__linux__)
+    const int priority = _io_class == IoClass::Idle ?
+        g_ioprio_class_idle << g_ioprio_class_shift :
+        (g_ioprio_class_best_effort << g_ioprio_class_shift) | g_ioprio_best_effort_level;
+    // Zero addresses the calling thread, not the whole process
+    return syscall(SYS_ioprio_set, g_ioprio_who_process, 0, priority) == 0;
+#else
+    Q_UNUSED(_io_class)
+    return false;
+#endif
+}
+
+IoThrottle::IoThrottle(quint64 _bandwidth_limit /*= 0*/) :
+    m_bandwidth_limit(0),
+    m_capacity(0),
+    m_tokens(0)
+{
+    setBandwidthLimit(_bandwidth_limit);
+}
+
+void IoThrottle::setBandwidthLimit(quint64 _bandwidth_limit)
+{
+    m_bandwidth_limit = _bandwidth_limit;
+    m_capacity = qMax(g_min_capacity, m_bandwidth_limit * g_burst_duration);
+    m_tokens = m_capacity;
+    m_clock.start();
+}
+
+void IoThrottle::refill()
+{
+    const qint64 elapsed_ns = m_clock.nsecsElapsed();
+    m_clock.start();
+    m_tokens = qMin(m_capacity, m_tokens + elapsed_ns * 1e-9 * m_bandwidth_limit);
+}
+
+// Waits until the _bytes fit into the limit. The wait is interrupted when the current job is canceled.
+void IoThrottle::consume(quint64 _bytes)
+{
+    if(m_bandwidth_limit == 0)
+        return;
+    refill();
+    m_tokens -= _bytes;
+    while(m_tokens < 0 && !Job::isCurrentJobCanceled())
+    {
+        const qint64 debt_ms = static_cast<qint64>(-m_tokens * 1000 / m_bandwidth_limit) + 1;
+        QThread::msleep(static_cast<unsigned long>(qMin(debt_ms, g_max_sleep_ms)));
+        refill();
+    }
+}
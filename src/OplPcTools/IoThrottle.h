@@ -0,0 +1,77 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_IOTHROTTLE__
+#define __OPLPCTOOLS_IOTHROTTLE__
+
+#include <QElapsedTimer>
+
+namespace OplPcTools {
+
+enum class IoClass
+{
+    BestEffort,
+    Idle // The disk is used only when nobody else needs it
+};
+
+struct IoPolicy
+{
+    IoPolicy() :
+        io_class(IoClass::BestEffort),
+        bandwidth_limit(0)
+    {
+    }
+
+    IoClass io_class;
+    quint64 bandwidth_limit; // Bytes per second. 0 means no limit.
+};
+
+// Sets the I/O scheduling class of the calling thread. Returns false if the system does not support it.
+bool setThreadIoClass(IoClass _io_class);
+
+/*
+ * A token bucket that keeps the average transfer rate under the limit.
+ * The bucket holds up to a quarter of a second of transfer, so short bursts are not delayed.
+ * A transfer larger than the bucket is let through and the debt is paid off by the following calls.
+ */
+class IoThrottle final
+{
+public:
+    explicit IoThrottle(quint64 _bandwidth_limit = 0);
+    inline quint64 bandwidthLimit() const;
+    void setBandwidthLimit(quint64 _bandwidth_limit);
+    void consume(quint64 _bytes);
+
+private:
+    void refill();
+
+private:
+    quint64 m_bandwidth_limit;
+    double m_capacity;
+    double m_tokens;
+    QElapsedTimer m_clock;
+};
+
+quint64 IoThrottle::bandwidthLimit() const
+{
+    return m_bandwidth_limit;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_IOTHROTTLE__
@@ -0,0 +1,161 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_ISO9660STRUCTURES__
+#define __OPLPCTOOLS_ISO9660STRUCTURES__
+
+#include <QtEndian>
+
+#define ISO9660_OFFSET 0x8000
+
+namespace OplPcTools {
+
+template<typename IntType>
+struct LBInt
+{
+    IntType le;
+    IntType be;
+
+    operator IntType() const
+    {
+#if BYTE_ORDER == LITTLE_ENDIAN
+        return le;
+#else
+        return be;
+#endif
+
+    }
+
+    void setValue(IntType _value)
+    {
+        le = qToLittleEndian(_value);
+        be = qToBigEndian(_value);
+    }
+} __attribute__((packed));
+
+using LBInt16 = LBInt<qint16>;
+using LBInt32 = LBInt<qint32>;
+
+struct DateTimeDR
+{
+    qint8 year;
+    qint8 month;
+    qint8 day;
+    qint8 hour;
+    qint8 minute;
+    qint8 second;
+    qint8 timezone_offset;
+} __attribute__((packed));
+
+struct FileFlags
+{
+    bool hidden: 1;
+    bool directory: 1;
+    bool associated: 1;
+    bool extend_attr_has_info : 1;
+    bool extend_attr_has_perms: 1;
+    bool unused_1: 1;
+    bool unused_2: 1;
+    bool is_not_final_dir: 1;
+};
+
+struct FileRecord
+{
+    qint8 record_length;
+    qint8 extended_attr_record_length;
+    LBInt32 extent_location;
+    LBInt32 data_length;
+    DateTimeDR recording_date;
+    FileFlags file_flags;
+    qint8 file_unit_size;
+    qint8 interleave_gap_size;
+    LBInt16 volume_sequence_number;
+    qint8 filename_length;
+    char filename[1];
+} __attribute__((packed));
+
+struct DateTimePVD
+{
+    char year[4];
+    char month[2];
+    char day[2];
+    char hour[2];
+    char minute[2];
+    char second[2];
+    char second_hundredths[2];
+    qint8 timezone_offset;
+} __attribute__((packed));
+
+enum class VolumeDescriptorType : qint8
+{
+    BootRecord = 0,
+    PrimaryVolumeDescriptor = 1,
+    SupplementaryVolumeDescriptor  = 2,
+    VolumePartitionDescriptor  = 3,
+    VolumeDescriptorSetTerminator = -1
+};
+
+struct BasicVolumeDescriptor
+{
+    VolumeDescriptorType type;
+    char id[5];
+    qint8 version;
+} __attribute__((packed));
+
+struct VolumeDescriptor : BasicVolumeDescriptor
+{
+    qint8 data[2041];
+} __attribute__((packed));
+
+struct PrimaryVolumeDescriptor : BasicVolumeDescriptor
+{
+    qint8 unused_1;
+    char system_id[32];
+    char volume_id[32];
+    qint8 unused_2[8];
+    LBInt32 block_count;
+    qint8 unused_3[32];
+    LBInt16 volume_set_size;
+    LBInt16 volume_number;
+    LBInt16 block_size;
+    LBInt32 path_table_size;
+    qint32 path_table_location_le;
+    qint32 optional_path_table_location_le;
+    qint32 path_table_location_be;
+    qint32 optional_path_table_location_be;
+    FileRecord root_directory;
+    char volume_set_id[128];
+    char publisher_id[128];
+    char data_preparer_id[128];
+    char application_id[128];
+    char copyright_file_id[38];
+    char abstract_file_id[36];
+    char bibliographic_file_id[37];
+    DateTimePVD creation_date;
+    DateTimePVD modification_date;
+    DateTimePVD expiration_date;
+    DateTimePVD effective_date;
+    qint8 file_structure_version;
+    qint8 unused_4;
+    qint8 application_data[512];
+    qint8 unused_5[653];
+} __attribute__((packed));
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_ISO9660STRUCTURES__
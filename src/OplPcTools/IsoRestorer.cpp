@@ -18,16 +18,27 @@
 
 #include <QFile>
 #include <QDir>
-#include <QThread>
+#include <OplPcTools/JobScheduler.h>
 #include <OplPcTools/UlConfigGameStorage.h>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/WriteBackFile.h>
+#include <OplPcTools/TransferJournal.h>
 #include <OplPcTools/IsoRestorer.h>
 
 using namespace OplPcTools;
 
+namespace {
+
+const quint64 g_checkpoint_interval = 268435456;
+
+} // namespace
+
 IsoRestorer::IsoRestorer(const Game & _game, const QString & _game_dirpath, const QString & _iso_filepath, QObject * _parent /*= nullptr*/) :
     QObject(_parent),
-    mr_game(_game),
+    m_game(_game),
     m_game_dirpath(_game_dirpath),
     m_iso_filepath(_iso_filepath)
 {
@@ -35,59 +46,97 @@ IsoRestorer::IsoRestorer(const Game & _game, const QString & _game_dirpath, cons
 
 bool IsoRestorer::restore()
 {
-    QFile iso(m_iso_filepath);
-    if(!iso.open(QIODevice::WriteOnly | QIODevice::Truncate))
-        throw IOException(tr("Unable to open file to write: \"%1\"").arg(m_iso_filepath));
+    OPT_TRACE_SCOPE("IsoRestorer::restore");
     QStringList filenames;
-    filenames.reserve(mr_game.partCount());
+    filenames.reserve(m_game.partCount());
     QDir games_dir(m_game_dirpath);
     quint64 all_files_total_size = 0;
-    for(quint8 part = 0; part < mr_game.partCount(); ++part)
+    for(quint8 part = 0; part < m_game.partCount(); ++part)
     {
-        QString filename = games_dir.absoluteFilePath(UlConfigGameStorage::makePartFilename(mr_game.id(), mr_game.title(), part));
+        QString filename = games_dir.absoluteFilePath(UlConfigGameStorage::makePartFilename(m_game.id(), m_game.title(), part));
         filenames.append(filename);
         QFileInfo file_info(filename);
         if(!file_info.exists())
-        {
-            rollback();
             throw IOException(tr("File not found: \"%1\"").arg(filename));
-        }
         all_files_total_size += file_info.size();
     }
+    const QString journal_filepath = TransferJournal::filepath(m_iso_filepath);
+    TransferJournal journal;
+    journal.source_filepath = filenames.value(0);
+    journal.game_id = m_game.id();
+    journal.source_size = all_files_total_size;
+    journal.source_mtime = QFileInfo(journal.source_filepath).lastModified().toMSecsSinceEpoch();
+    journal.destination_filepaths << m_iso_filepath;
     quint64 total_write_bytes = 0;
+    if(QFile::exists(m_iso_filepath))
+    {
+        total_write_bytes = journal.resume(journal_filepath, [&filenames](quint64 _offset, QByteArray & _buffer) {
+            return TransferJournal::readFiles(filenames, _offset, _buffer);
+        });
+    }
+    WriteBackFile iso(m_iso_filepath,
+        Settings::instance().writeBackPolicy(storageDeviceId(QFileInfo(m_iso_filepath).absolutePath())));
+    if(!(total_write_bytes > 0 ? iso.openAt(total_write_bytes) : iso.open(QIODevice::WriteOnly | QIODevice::Truncate)))
+        throw IOException(tr("Unable to open file to write: \"%1\"").arg(m_iso_filepath));
+    m_progress.reset(all_files_total_size);
+    m_progress.setDoneBytes(total_write_bytes);
     const qint64 batch_size = 2048 * 2048;
     QByteArray buffer(batch_size, Qt::Uninitialized);
+    quint64 file_offset = 0;
+    quint64 checkpoint_bytes = total_write_bytes;
     for(const QString & filename : filenames)
     {
         QFile file(filename);
-        if(!file.open(QIODevice::ReadOnly))
+        const quint64 file_size = static_cast<quint64>(file.size());
+        // Parts before the checkpoint are already restored.
+        if(file_offset + file_size <= total_write_bytes)
+        {
+            file_offset += file_size;
+            continue;
+        }
+        if(!file.open(QIODevice::ReadOnly) || !file.seek(total_write_bytes - file_offset))
             throw IOException(tr("Unable to open file to read: \"%1\"").arg(filename));
-        for(int i = 0; ; ++i)
+        file_offset += file_size;
+        for(;;)
         {
-            if(QThread::currentThread()->isInterruptionRequested())
+            if(Job::isCurrentJobCanceled())
             {
-                rollback();
+                iso.sync();
+                suspend(journal, iso.durableBytes());
                 return false;
             }
-            qint64 read_bytes = file.read(buffer.data(), batch_size);
+            qint64 read_bytes = 0;
+            {
+                OPT_TRACE_SCOPE("read");
+                read_bytes = file.read(buffer.data(), batch_size);
+            }
             if(read_bytes > 0)
             {
-                qint64 write_bytes = iso.write(buffer.constData(), read_bytes);
+                qint64 write_bytes = 0;
+                {
+                    OPT_TRACE_SCOPE("write");
+                    write_bytes = iso.write(buffer.constData(), read_bytes);
+                }
                 if(write_bytes <= 0)
                 {
-                    rollback();
+                    iso.sync();
+                    suspend(journal, iso.durableBytes());
                     throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(m_iso_filepath));
                 }
                 total_write_bytes += write_bytes;
-                if(i % 5 == 0 || total_write_bytes == all_files_total_size)
+                m_progress.setDoneBytes(iso.flushedBytes());
+                OPT_TRACE_COUNTER("restored bytes", total_write_bytes);
+                Job::throttleCurrentJob(write_bytes);
+                if(total_write_bytes - checkpoint_bytes >= g_checkpoint_interval && iso.sync())
                 {
-                    iso.flush();
+                    checkpoint_bytes = journal.durable_bytes = total_write_bytes;
+                    journal.save(journal_filepath);
                 }
-                emit progress(all_files_total_size, total_write_bytes);
             }
             else if(read_bytes < 0)
             {
-                rollback();
+                iso.sync();
+                suspend(journal, iso.durableBytes());
                 throw IOException(tr("Unable to read the file: \"%1\"").arg(filename));
             }
             if(read_bytes == 0 || read_bytes < batch_size)
@@ -96,12 +145,22 @@ bool IsoRestorer::restore()
             }
         }
     }
+    if(!iso.sync())
+    {
+        suspend(journal, iso.durableBytes());
+        throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(m_iso_filepath));
+    }
+    QFile::remove(journal_filepath);
+    m_progress.setDoneBytes(total_write_bytes);
     return true;
 }
 
-void IsoRestorer::rollback()
+// Stops the restoration keeping the written data and a checkpoint at the last synced offset
+void IsoRestorer::suspend(TransferJournal & _journal, quint64 _durable_bytes)
 {
-    emit rollbackStarted();
-    QFile::remove(m_iso_filepath);
-    emit rollbackFinished();
+    OPT_TRACE_SCOPE("IsoRestorer::suspend");
+    const QString journal_filepath = TransferJournal::filepath(m_iso_filepath);
+    _journal.durable_bytes = _durable_bytes;
+    _journal.save(journal_filepath);
+    emit suspended(journal_filepath);
 }
@@ -21,6 +21,8 @@
 
 #include <QObject>
 #include <OplPcTools/Game.h>
+#include <OplPcTools/TransferProgress.h>
+#include <OplPcTools/TransferJournal.h>
 
 namespace OplPcTools {
 
@@ -31,21 +33,26 @@ class IsoRestorer final : public QObject
 public:
     IsoRestorer(const Game & _game, const QString & _game_dirpath, const QString & _iso_filepath, QObject * _parent = nullptr);
     bool restore();
+    inline const TransferProgress & transferProgress() const;
 
 signals:
-    void progress(quint64 _total_bytes, quint64 _done_bytes);
-    void rollbackStarted();
-    void rollbackFinished();
+    void suspended(const QString & _journal_filepath);
 
 private:
-    void rollback();
+    void suspend(TransferJournal & _journal, quint64 _durable_bytes);
 
 private:
-    const Game & mr_game;
+    const Game m_game;
     const QString m_game_dirpath;
     const QString m_iso_filepath;
+    TransferProgress m_progress;
 };
 
+const TransferProgress & IsoRestorer::transferProgress() const
+{
+    return m_progress;
+}
+
 } // namespace OplPcTools
 
 #endif // __OPLPCTOOLS_ISORESTORER__
@@ -0,0 +1,251 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QCoreApplication>
+#include <QThread>
+#include <QRunnable>
+#include <QMutexLocker>
+#include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/JobScheduler.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+// Enough for the simultaneous transfers of the installer and a couple of background jobs,
+// a job that the UI shows as running must not wait for a free thread
+const int g_io_thread_count = 6;
+
+thread_local Job * g_current_job = nullptr;
+
+QThread::Priority threadPriority(JobPriority _priority)
+{
+    switch(_priority)
+    {
+    case JobPriority::Low:
+        return QThread::LowPriority;
+    case JobPriority::High:
+        return QThread::HighPriority;
+    default:
+        return QThread::NormalPriority;
+    }
+}
+
+} // namespace
+
+namespace OplPcTools {
+
+class JobRunnable final : public QRunnable
+{
+public:
+    JobRunnable(JobScheduler & _scheduler, const JobPointer & _job, bool _is_dependency_failed);
+    void run() override;
+
+private:
+    JobScheduler & mr_scheduler;
+    JobPointer m_job_ptr;
+    const bool m_is_dependency_failed;
+};
+
+} // namespace OplPcTools
+
+JobRunnable::JobRunnable(JobScheduler & _scheduler, const JobPointer & _job, bool _is_dependency_failed) :
+    mr_scheduler(_scheduler),
+    m_job_ptr(_job),
+    m_is_dependency_failed(_is_dependency_failed)
+{
+}
+
+void JobRunnable::run()
+{
+    Job & job = *m_job_ptr;
+    Job::State state = Job::State::Canceled;
+    QString error_message;
+    if(!m_is_dependency_failed && !job.m_cancellation_token.isCanceled())
+    {
+        OPT_TRACE_SCOPE("JobRunnable::run");
+        QThread * thread = QThread::currentThread();
+        thread->setPriority(threadPriority(job.m_priority));
+        // The pool threads are shared, so the I/O class is set for the time of the job only
+        const bool is_idle_io = job.m_io_policy.io_class == IoClass::Idle && setThreadIoClass(IoClass::Idle);
+        job.m_throttle.setBandwidthLimit(job.m_io_policy.bandwidth_limit);
+        job.setState(Job::State::Running);
+        emit job.started();
+        g_current_job = &job;
+        try
+        {
+            job.m_work();
+            state = Job::State::Finished;
+        }
+        catch(const Exception & exception)
+        {
+            error_message = exception.message();
+            state = Job::State::Failed;
+        }
+        catch(const std::exception & exception)
+        {
+            error_message = QString::fromStdString(exception.what());
+            state = Job::State::Failed;
+        }
+        catch(...)
+        {
+            error_message = QObject::tr("An unknown error has occurred");
+            state = Job::State::Failed;
+        }
+        g_current_job = nullptr;
+        if(is_idle_io)
+            setThreadIoClass(IoClass::BestEffort);
+        thread->setPriority(QThread::NormalPriority);
+    }
+    // The work may hold resources that must not outlive the job
+    job.m_work = nullptr;
+    mr_scheduler.complete(m_job_ptr, state, error_message);
+}
+
+CancellationToken::CancellationToken() :
+    m_flag_ptr(new QAtomicInt(0))
+{
+}
+
+Job::Job(JobKind _kind, std::function<void()> _work) :
+    m_kind(_kind),
+    m_priority(JobPriority::Normal),
+    m_work(_work),
+    m_state(static_cast<int>(State::Pending)),
+    mp_scheduler(nullptr)
+{
+}
+
+// The last reference may be released on a pool thread, which runs no event loop, so the job is moved
+// to the main thread and deleted by its event loop after the signals queued by the worker have been delivered.
+// Without a running event loop (the CLI) the jobs are not deleted until the exit.
+QSharedPointer<Job> Job::create(JobKind _kind, std::function<void()> _work)
+{
+    Job * job = new Job(_kind, _work);
+    if(QCoreApplication * application = QCoreApplication::instance())
+        job->moveToThread(application->thread());
+    return QSharedPointer<Job>(job, &QObject::deleteLater);
+}
+
+// Must be called before the job is submitted, the _job must be submitted too
+void Job::addDependency(const QSharedPointer<Job> & _job)
+{
+    m_dependencies.append(_job);
+}
+
+void Job::setState(State _state)
+{
+    QMutexLocker locker(&m_done_mutex);
+    m_state.store(static_cast<int>(_state));
+    if(isDone())
+        m_done_condition.wakeAll();
+}
+
+// The running job stops when it checks isCurrentJobCanceled(), the pending one is not started
+void Job::cancel()
+{
+    m_cancellation_token.cancel();
+    if(mp_scheduler)
+    {
+        QMutexLocker locker(&mp_scheduler->m_mutex);
+        mp_scheduler->dispatch();
+    }
+}
+
+bool Job::wait(unsigned long _timeout /*= ULONG_MAX*/)
+{
+    QMutexLocker locker(&m_done_mutex);
+    if(!isDone())
+        m_done_condition.wait(&m_done_mutex, _timeout);
+    return isDone();
+}
+
+// Tells the work whether it should stop. Outside the jobs it falls back to the interruption of the current thread.
+bool Job::isCurrentJobCanceled()
+{
+    if(g_current_job)
+        return g_current_job->m_cancellation_token.isCanceled();
+    return QThread::currentThread()->isInterruptionRequested();
+}
+
+// Delays the current job to keep its transfer within the bandwidth limit of its I/O policy
+void Job::throttleCurrentJob(quint64 _bytes)
+{
+    if(g_current_job)
+        g_current_job->m_throttle.consume(_bytes);
+}
+
+JobScheduler::JobScheduler()
+{
+    m_cpu_pool.setMaxThreadCount(QThread::idealThreadCount());
+    m_io_pool.setMaxThreadCount(g_io_thread_count);
+}
+
+JobScheduler & JobScheduler::instance()
+{
+    static JobScheduler * scheduler = new JobScheduler();
+    return *scheduler;
+}
+
+void JobScheduler::submit(const JobPointer & _job)
+{
+    QMutexLocker locker(&m_mutex);
+    _job->mp_scheduler = this;
+    m_pending_jobs.append(_job);
+    dispatch();
+}
+
+// Starts the pending jobs whose dependencies are done. The canceled jobs are started as well,
+// they complete at once, so every job reports its completion from a worker thread.
+void JobScheduler::dispatch()
+{
+    for(auto it = m_pending_jobs.begin(); it != m_pending_jobs.end();)
+    {
+        const JobPointer & job = *it;
+        bool is_ready = true;
+        bool is_dependency_failed = false;
+        for(const JobPointer & dependency : job->m_dependencies)
+        {
+            const Job::State state = dependency->state();
+            if(state == Job::State::Failed || state == Job::State::Canceled)
+                is_dependency_failed = true;
+            else if(state != Job::State::Finished)
+                is_ready = false;
+        }
+        if(!is_ready && !is_dependency_failed && !job->m_cancellation_token.isCanceled())
+        {
+            ++it;
+            continue;
+        }
+        pool(job->m_kind).start(new JobRunnable(*this, job, is_dependency_failed), static_cast<int>(job->m_priority));
+        it = m_pending_jobs.erase(it);
+    }
+}
+
+void JobScheduler::complete(const JobPointer & _job, Job::State _state, const QString & _error_message)
+{
+    _job->setState(_state);
+    QMutexLocker locker(&m_mutex);
+    _job->m_dependencies.clear();
+    dispatch();
+    locker.unlock();
+    if(_state == Job::State::Failed)
+        emit _job->failed(_error_message);
+    emit _job->finished();
+}
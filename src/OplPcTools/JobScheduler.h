@@ -0,0 +1,206 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_JOBSCHEDULER__
+#define __OPLPCTOOLS_JOBSCHEDULER__
+
+#include <climits>
+#include <functional>
+#include <QObject>
+#include <QSharedPointer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QList>
+#include <OplPcTools/IoThrottle.h>
+
+namespace OplPcTools {
+
+enum class JobKind
+{
+    Cpu,
+    Io
+};
+
+enum class JobPriority
+{
+    Low,
+    Normal,
+    High
+};
+
+class CancellationToken final
+{
+public:
+    CancellationToken();
+    inline bool isCanceled() const;
+    inline void cancel();
+
+private:
+    QSharedPointer<QAtomicInt> m_flag_ptr;
+};
+
+class JobScheduler;
+
+class Job final : public QObject
+{
+    Q_OBJECT
+    friend class JobScheduler;
+    friend class JobRunnable;
+
+public:
+    enum class State
+    {
+        Pending,
+        Running,
+        Finished,
+        Failed,
+        Canceled
+    };
+
+public:
+    static QSharedPointer<Job> create(JobKind _kind, std::function<void()> _work);
+    inline JobKind kind() const;
+    inline JobPriority priority() const;
+    inline void setPriority(JobPriority _priority);
+    inline const IoPolicy & ioPolicy() const;
+    inline void setIoPolicy(const IoPolicy & _policy);
+    void addDependency(const QSharedPointer<Job> & _job);
+    inline State state() const;
+    inline bool isDone() const;
+    inline const CancellationToken & cancellationToken() const;
+    void cancel();
+    bool wait(unsigned long _timeout = ULONG_MAX);
+    static bool isCurrentJobCanceled();
+    static void throttleCurrentJob(quint64 _bytes);
+
+signals:
+    void started();
+    void failed(QString _message);
+    void finished();
+
+private:
+    Job(JobKind _kind, std::function<void()> _work);
+    void setState(State _state);
+
+private:
+    const JobKind m_kind;
+    JobPriority m_priority;
+    IoPolicy m_io_policy;
+    IoThrottle m_throttle;
+    std::function<void()> m_work;
+    QList<QSharedPointer<Job>> m_dependencies;
+    CancellationToken m_cancellation_token;
+    QAtomicInt m_state;
+    JobScheduler * mp_scheduler;
+    QMutex m_done_mutex;
+    QWaitCondition m_done_condition;
+};
+
+typedef QSharedPointer<Job> JobPointer;
+
+/*
+ * Runs all the background operations of the application. The CPU-bound jobs share a pool sized to the processor,
+ * the I/O-bound jobs share a small pool, so the load stays bounded however many operations are requested.
+ * A job waits for its dependencies and is canceled if any of them fails or is canceled.
+ * The I/O policy of a job sets the I/O class of its thread and the bandwidth limit checked by throttleCurrentJob().
+ * The signals of a job are emitted on the worker thread.
+ */
+class JobScheduler final
+{
+    Q_DISABLE_COPY(JobScheduler)
+    friend class Job;
+    friend class JobRunnable;
+
+public:
+    static JobScheduler & instance();
+    void submit(const JobPointer & _job);
+
+private:
+    JobScheduler();
+    void dispatch();
+    void complete(const JobPointer & _job, Job::State _state, const QString & _error_message);
+    inline QThreadPool & pool(JobKind _kind);
+
+private:
+    QMutex m_mutex;
+    QList<JobPointer> m_pending_jobs;
+    QThreadPool m_cpu_pool;
+    QThreadPool m_io_pool;
+};
+
+bool CancellationToken::isCanceled() const
+{
+    return m_flag_ptr->load() != 0;
+}
+
+void CancellationToken::cancel()
+{
+    m_flag_ptr->store(1);
+}
+
+JobKind Job::kind() const
+{
+    return m_kind;
+}
+
+JobPriority Job::priority() const
+{
+    return m_priority;
+}
+
+void Job::setPriority(JobPriority _priority)
+{
+    m_priority = _priority;
+}
+
+const IoPolicy & Job::ioPolicy() const
+{
+    return m_io_policy;
+}
+
+void Job::setIoPolicy(const IoPolicy & _policy)
+{
+    m_io_policy = _policy;
+}
+
+Job::State Job::state() const
+{
+    return static_cast<State>(m_state.load());
+}
+
+bool Job::isDone() const
+{
+    const State state = this->state();
+    return state == State::Finished || state == State::Failed || state == State::Canceled;
+}
+
+const CancellationToken & Job::cancellationToken() const
+{
+    return m_cancellation_token;
+}
+
+QThreadPool & JobScheduler::pool(JobKind _kind)
+{
+    return _kind == JobKind::Cpu ? m_cpu_pool : m_io_pool;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_JOBSCHEDULER__
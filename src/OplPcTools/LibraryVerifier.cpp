@@ -0,0 +1,242 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/Device.h>
+#include <OplPcTools/Iso9660DeviceSource.h>
+#include <OplPcTools/MultipartDeviceSource.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/LibraryVerifier.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const qint64 g_ul_part_size = 1073741824;
+const int g_max_structure_thread_count = 4;
+
+struct VerificationContext
+{
+    LibraryVerifier * verifier;
+    const QString * library_directory;
+    bool is_full_read_enabled;
+    ImageHashCache * cache;
+    QAtomicInt * is_canceled;
+    QAtomicInt processed;
+    QAtomicInt verified;
+    int total;
+    int last_reported_percent;
+    QMutex mutex;
+};
+
+class VerificationTask final
+{
+public:
+    VerificationTask(VerificationContext & _context, GameIntegrityReport & _report);
+    void run();
+
+private:
+    void verifyFiles(const QStringList & _filepaths);
+    void verifyImage(const QStringList & _filepaths);
+    void verifyChecksum(const QStringList & _filepaths);
+    void reportProgress();
+
+private:
+    VerificationContext & mr_context;
+    GameIntegrityReport & mr_report;
+};
+
+} // namespace
+
+VerificationTask::VerificationTask(VerificationContext & _context, GameIntegrityReport & _report) :
+    mr_context(_context),
+    mr_report(_report)
+{
+}
+
+void VerificationTask::run()
+{
+    if(mr_context.is_canceled->load() == 0)
+    {
+        OPT_TRACE_SCOPE("LibraryVerifier::verifyGame");
+        const QStringList filepaths = GameCollection::gameFiles(*mr_context.library_directory, *mr_report.game);
+        verifyFiles(filepaths);
+        if(mr_report.issues.isEmpty())
+            verifyImage(filepaths);
+        if(mr_report.issues.isEmpty() && mr_context.is_full_read_enabled)
+            verifyChecksum(filepaths);
+        if(mr_context.is_canceled->load() == 0)
+        {
+            mr_context.verified.fetchAndAddOrdered(1);
+            emit mr_context.verifier->gameVerified(mr_report.game->id(), mr_report.issues);
+        }
+    }
+    reportProgress();
+}
+
+// The installer fills every part of a UL game up to its size except the last one
+void VerificationTask::verifyFiles(const QStringList & _filepaths)
+{
+    const bool is_ul_game = mr_report.game->installationType() == GameInstallationType::UlConfig;
+    if(_filepaths.isEmpty())
+        mr_report.issues.append(QObject::tr("No parts are declared in ul.cfg"));
+    for(int i = 0; i < _filepaths.count(); ++i)
+    {
+        const QString & filepath = _filepaths[i];
+        QFileInfo info(filepath);
+        if(!info.exists())
+            mr_report.issues.append(QObject::tr("File not found: \"%1\"").arg(filepath));
+        else if(info.size() == 0)
+            mr_report.issues.append(QObject::tr("File is empty: \"%1\"").arg(filepath));
+        else if(is_ul_game && i < _filepaths.count() - 1 && info.size() != g_ul_part_size)
+            mr_report.issues.append(QObject::tr("Part has %1 bytes instead of %2: \"%3\"")
+                .arg(info.size()).arg(g_ul_part_size).arg(filepath));
+        else if(is_ul_game && info.size() > g_ul_part_size)
+            mr_report.issues.append(QObject::tr("Part is larger than %1 bytes: \"%2\"").arg(g_ul_part_size).arg(filepath));
+    }
+}
+
+void VerificationTask::verifyImage(const QStringList & _filepaths)
+{
+    QSharedPointer<DeviceSource> source(_filepaths.count() == 1 ?
+        static_cast<DeviceSource *>(new Iso9660DeviceSource(_filepaths.first())) :
+        static_cast<DeviceSource *>(new MultipartDeviceSource(_filepaths)));
+    Device device(source);
+    if(!device.init())
+    {
+        mr_report.issues.append(QObject::tr("Invalid file format: \"%1\"").arg(_filepaths.first()));
+        return;
+    }
+    quint64 image_size = 0;
+    for(const QString & filepath : _filepaths)
+        image_size += QFileInfo(filepath).size();
+    if(device.gameId() != mr_report.game->id())
+        mr_report.issues.append(QObject::tr("Image declares the game ID \"%1\"").arg(device.gameId()));
+    if(device.usedSize() > device.declaredSize())
+        mr_report.issues.append(QObject::tr("File system extends beyond the volume: %1 of %2 bytes")
+            .arg(device.usedSize()).arg(device.declaredSize()));
+    if(image_size < device.declaredSize())
+        mr_report.issues.append(QObject::tr("Image is truncated: %1 of %2 bytes").arg(image_size).arg(device.declaredSize()));
+}
+
+// A changed checksum of the files with the same size and modification time means that the data is damaged
+void VerificationTask::verifyChecksum(const QStringList & _filepaths)
+{
+    ImageHash hash;
+    QString error;
+    if(!ImageHashCache::computeHash(_filepaths, *mr_context.is_canceled, hash, error))
+    {
+        if(!error.isEmpty())
+            mr_report.issues.append(error);
+        return;
+    }
+    mr_report.checksum = hash.full_hash;
+    if(!mr_context.cache)
+        return;
+    ImageHash cached_hash;
+    if(!mr_context.cache->find(_filepaths, cached_hash))
+        mr_context.cache->insert(hash);
+    else if(cached_hash.full_hash != hash.full_hash)
+        mr_report.issues.append(QObject::tr("Checksum mismatch: the data has changed while the file sizes and times have not"));
+}
+
+void VerificationTask::reportProgress()
+{
+    int processed = mr_context.processed.fetchAndAddOrdered(1) + 1;
+    int percent = static_cast<int>(static_cast<qint64>(processed) * 100 / mr_context.total);
+    {
+        QMutexLocker locker(&mr_context.mutex);
+        if(percent == mr_context.last_reported_percent && processed != mr_context.total)
+            return;
+        mr_context.last_reported_percent = percent;
+    }
+    emit mr_context.verifier->progress(processed, mr_context.total);
+}
+
+LibraryVerifier::LibraryVerifier(const QString & _library_directory, QObject * _parent /*= nullptr*/) :
+    QObject(_parent),
+    m_library_directory(_library_directory),
+    m_is_full_read_enabled(false),
+    mp_cache(nullptr),
+    m_is_canceled(0)
+{
+}
+
+void LibraryVerifier::cancel()
+{
+    m_is_canceled.store(1);
+}
+
+LibraryVerificationResult LibraryVerifier::verify(const GameList & _games)
+{
+    OPT_TRACE_SCOPE("LibraryVerifier::verify");
+    m_is_canceled.store(0);
+    LibraryVerificationResult result;
+    if(_games.isEmpty())
+        return result;
+    VerificationContext context;
+    context.verifier = this;
+    context.library_directory = &m_library_directory;
+    context.is_full_read_enabled = m_is_full_read_enabled;
+    context.cache = mp_cache;
+    context.is_canceled = &m_is_canceled;
+    context.total = _games.count();
+    context.last_reported_percent = -1;
+    // Each task fills its own report, the list is not resized while the tasks run
+    for(const QSharedPointer<const Game> & game : _games)
+        result.reports.append(GameIntegrityReport { game, {}, {} });
+    // Reading a drive by several threads makes it seek between the images, the structure checks are short
+    // random reads that benefit from the queue of the drive.
+    // The jobs of a drive form this number of chains, each job waits for the one submitted that many jobs before it.
+    const int chain_count = m_is_full_read_enabled ? 1 : qMin(g_max_structure_thread_count, QThread::idealThreadCount());
+    const IoPolicy io_policy = Settings::instance().ioPolicy();
+    QHash<QString, QList<JobPointer>> device_jobs;
+    for(GameIntegrityReport & report : result.reports)
+    {
+        const QStringList filepaths = GameCollection::gameFiles(m_library_directory, *report.game);
+        const QString device_id = storageDeviceId(filepaths.isEmpty() ?
+            m_library_directory : QFileInfo(filepaths.first()).absolutePath());
+        QList<JobPointer> & jobs = device_jobs[device_id];
+        VerificationTask task(context, report);
+        JobPointer job = Job::create(JobKind::Io, [task]() mutable { task.run(); });
+        job->setIoPolicy(io_policy);
+        if(jobs.count() >= chain_count)
+            job->addDependency(jobs[jobs.count() - chain_count]);
+        jobs.append(job);
+        JobScheduler::instance().submit(job);
+    }
+    for(const QList<JobPointer> & jobs : device_jobs)
+    {
+        for(const JobPointer & job : jobs)
+            job->wait();
+    }
+    result.verified = context.verified.load();
+    for(const GameIntegrityReport & report : result.reports)
+    {
+        if(!report.issues.isEmpty())
+            ++result.broken;
+    }
+    return result;
+}
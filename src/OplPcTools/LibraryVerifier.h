@@ -0,0 +1,95 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_LIBRARYVERIFIER__
+#define __OPLPCTOOLS_LIBRARYVERIFIER__
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <OplPcTools/GameCollection.h>
+#include <OplPcTools/ImageHashCache.h>
+
+namespace OplPcTools {
+
+struct GameIntegrityReport
+{
+    QSharedPointer<const Game> game;
+    QStringList issues;
+    QByteArray checksum; // Hash of all the bytes of the files, empty if the data is not read
+};
+
+struct LibraryVerificationResult
+{
+    LibraryVerificationResult() :
+        verified(0),
+        broken(0)
+    {
+    }
+
+    QList<GameIntegrityReport> reports;
+    int verified;
+    int broken;
+};
+
+/*
+ * Checks that the games of the library are intact: the files listed by ul.cfg and the directories are present
+ * with plausible sizes, the primary volume descriptor is valid and the ID in SYSTEM.CNF matches the one of the game.
+ * With full reading enabled the whole images are read and their checksums are compared with the cached ones,
+ * so a damaged file is found even if its size and modification time are unchanged.
+ * The games are checked by the I/O jobs of the JobScheduler with the I/O policy of the settings. The jobs are
+ * grouped by the drive that holds the games, so the drives are read simultaneously while a drive is read
+ * by one job at a time when the data is read completely.
+ * verify() blocks until all the games are checked, the signals are emitted from the worker threads.
+ * It must not be called from an I/O job, the job would hold a thread that the checks need.
+ */
+class LibraryVerifier final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LibraryVerifier(const QString & _library_directory, QObject * _parent = nullptr);
+    inline void setFullReadEnabled(bool _enabled);
+    inline void setChecksumCache(ImageHashCache * _cache);
+    LibraryVerificationResult verify(const GameList & _games);
+    void cancel();
+
+signals:
+    void progress(int _processed, int _total);
+    void gameVerified(const QString & _game_id, const QStringList & _issues);
+
+private:
+    const QString m_library_directory;
+    bool m_is_full_read_enabled;
+    ImageHashCache * mp_cache;
+    QAtomicInt m_is_canceled;
+};
+
+void LibraryVerifier::setFullReadEnabled(bool _enabled)
+{
+    m_is_full_read_enabled = _enabled;
+}
+
+void LibraryVerifier::setChecksumCache(ImageHashCache * _cache)
+{
+    mp_cache = _cache;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_LIBRARYVERIFIER__
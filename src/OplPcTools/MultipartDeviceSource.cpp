@@ -0,0 +1,103 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <OplPcTools/MultipartDeviceSource.h>
+
+using namespace OplPcTools;
+
+MultipartDeviceSource::MultipartDeviceSource(const QStringList & _filepaths) :
+    m_filepaths(_filepaths),
+    m_position(0)
+{
+}
+
+QString MultipartDeviceSource::filepath() const
+{
+    return m_filepaths.value(0);
+}
+
+bool MultipartDeviceSource::isReadOnly() const
+{
+    return true;
+}
+
+bool MultipartDeviceSource::open()
+{
+    close();
+    qint64 offset = 0;
+    for(const QString & filepath : m_filepaths)
+    {
+        QSharedPointer<QFile> file(new QFile(filepath));
+        if(!file->open(QIODevice::ReadOnly))
+        {
+            close();
+            return false;
+        }
+        m_files.append(file);
+        m_offsets.append(offset);
+        offset += file->size();
+    }
+    m_position = 0;
+    return !m_files.isEmpty();
+}
+
+bool MultipartDeviceSource::isOpen() const
+{
+    return !m_files.isEmpty();
+}
+
+void MultipartDeviceSource::close()
+{
+    m_files.clear();
+    m_offsets.clear();
+}
+
+bool MultipartDeviceSource::seek(qint64 _offset)
+{
+    if(_offset < 0 || m_files.isEmpty())
+        return false;
+    m_position = _offset;
+    return true;
+}
+
+qint64 MultipartDeviceSource::read(QByteArray & _buffer)
+{
+    qint64 total_read_bytes = 0;
+    while(total_read_bytes < _buffer.size())
+    {
+        // The last part that starts at or before the position
+        const int index = static_cast<int>(std::upper_bound(m_offsets.cbegin(), m_offsets.cend(), m_position) - m_offsets.cbegin()) - 1;
+        if(index < 0)
+            return -1;
+        QFile & file = *m_files[index];
+        const qint64 file_position = m_position - m_offsets[index];
+        if(file_position >= file.size())
+            break;
+        if(file.pos() != file_position && !file.seek(file_position))
+            return total_read_bytes > 0 ? total_read_bytes : -1;
+        const qint64 read_bytes = file.read(_buffer.data() + total_read_bytes, _buffer.size() - total_read_bytes);
+        if(read_bytes < 0)
+            return total_read_bytes > 0 ? total_read_bytes : -1;
+        if(read_bytes == 0)
+            break;
+        total_read_bytes += read_bytes;
+        m_position += read_bytes;
+    }
+    return total_read_bytes;
+}
@@ -0,0 +1,56 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_MULTIPARTDEVICESOURCE__
+#define __OPLPCTOOLS_MULTIPARTDEVICESOURCE__
+
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+#include <QSharedPointer>
+#include <OplPcTools/DeviceSource.h>
+
+namespace OplPcTools {
+
+/*
+ * An image split up into parts, e.g. a UL game, read as one stream.
+ */
+class MultipartDeviceSource : public DeviceSource
+{
+    Q_DISABLE_COPY(MultipartDeviceSource)
+
+public:
+    explicit MultipartDeviceSource(const QStringList & _filepaths);
+    QString filepath() const override;
+    bool isReadOnly() const override;
+    bool open() override;
+    bool isOpen() const override;
+    void close() override;
+    bool seek(qint64 _offset) override;
+    qint64 read(QByteArray & _buffer) override;
+
+private:
+    QStringList m_filepaths;
+    QVector<QSharedPointer<QFile>> m_files;
+    QVector<qint64> m_offsets; // Offset of each part in the stream
+    qint64 m_position;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_MULTIPARTDEVICESOURCE__
@@ -37,6 +37,8 @@ const char * flagToKey(Settings::Flag _flag)
         return "Settings/MoveISO";
     case Settings::Flag::RenameIso:
         return "Settings/RenameISO";
+    case Settings::Flag::TrimIso:
+        return "Settings/TrimISO";
     case Settings::Flag::CheckNewVersion:
         return "Settings/CheckNewVersion";
     case Settings::Flag::ValidateUlCfg:
@@ -46,6 +48,18 @@ const char * flagToKey(Settings::Flag _flag)
     }
 }
 
+QString writeBackGroup(const QString & _storage_device_id)
+{
+    // Device identifiers are paths, they must not create nested groups
+    return QString("WriteBack/%1").arg(QString::fromLatin1(_storage_device_id.toUtf8().toHex()));
+}
+
+const char * g_write_back_default_group = "WriteBack/Default";
+const char * g_write_back_window_size_key = "WindowSize";
+const char * g_write_back_dirty_limit_key = "DirtyLimit";
+const char * g_io_idle_class_key = "IO/IdleClass";
+const char * g_io_bandwidth_limit_key = "IO/BandwidthLimit";
+
 } // namespace
 
 
@@ -58,6 +72,7 @@ Settings::Settings()
     loadFlag(settings, Flag::SplitUpIso, true);
     loadFlag(settings, Flag::MoveIso, false);
     loadFlag(settings, Flag::RenameIso, true);
+    loadFlag(settings, Flag::TrimIso, false);
     loadFlag(settings, Flag::CheckNewVersion, true);
     loadFlag(settings, Flag::ValidateUlCfg, true);
 }
@@ -83,3 +98,54 @@ Settings & Settings::instance()
     static Settings * settings = new Settings();
     return *settings;
 }
+
+WriteBackPolicy Settings::writeBackPolicy(const QString & _storage_device_id) const
+{
+    WriteBackPolicy policy;
+    QSettings settings;
+    QStringList groups { g_write_back_default_group };
+    if(!_storage_device_id.isEmpty())
+        groups.append(writeBackGroup(_storage_device_id));
+    for(const QString & group : groups)
+    {
+        settings.beginGroup(group);
+        policy.window_size = settings.value(g_write_back_window_size_key, policy.window_size).toULongLong();
+        policy.dirty_limit = settings.value(g_write_back_dirty_limit_key, policy.dirty_limit).toULongLong();
+        settings.endGroup();
+    }
+    return policy;
+}
+
+void Settings::setWriteBackPolicy(const QString & _storage_device_id, const WriteBackPolicy & _policy)
+{
+    QSettings settings;
+    settings.beginGroup(_storage_device_id.isEmpty() ? QString(g_write_back_default_group) : writeBackGroup(_storage_device_id));
+    settings.setValue(g_write_back_window_size_key, _policy.window_size);
+    settings.setValue(g_write_back_dirty_limit_key, _policy.dirty_limit);
+    settings.endGroup();
+}
+
+void Settings::resetWriteBackPolicy(const QString & _storage_device_id)
+{
+    if(_storage_device_id.isEmpty())
+        return;
+    QSettings settings;
+    settings.remove(writeBackGroup(_storage_device_id));
+}
+
+IoPolicy Settings::ioPolicy() const
+{
+    IoPolicy policy;
+    QSettings settings;
+    if(settings.value(g_io_idle_class_key, false).toBool())
+        policy.io_class = IoClass::Idle;
+    policy.bandwidth_limit = settings.value(g_io_bandwidth_limit_key, policy.bandwidth_limit).toULongLong();
+    return policy;
+}
+
+void Settings::setIoPolicy(const IoPolicy & _policy)
+{
+    QSettings settings;
+    settings.setValue(g_io_idle_class_key, _policy.io_class == IoClass::Idle);
+    settings.setValue(g_io_bandwidth_limit_key, _policy.bandwidth_limit);
+}
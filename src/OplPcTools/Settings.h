@@ -22,6 +22,8 @@
 #include <QString>
 #include <QSettings>
 #include <OplPcTools/GameInstallationType.h>
+#include <OplPcTools/WriteBackFile.h>
+#include <OplPcTools/IoThrottle.h>
 
 namespace OplPcTools {
 
@@ -38,6 +40,7 @@ public:
         SplitUpIso,
         MoveIso,
         RenameIso,
+        TrimIso,
         CheckNewVersion,
         ValidateUlCfg
     };
@@ -46,6 +49,13 @@ public:
     static Settings & instance();
     inline bool flag(Flag _flag) const;
     void setFlag(Flag _flag, bool _value);
+    // Policies are stored per destination drive (see storageDeviceId). An empty identifier addresses the default one.
+    WriteBackPolicy writeBackPolicy(const QString & _storage_device_id) const;
+    void setWriteBackPolicy(const QString & _storage_device_id, const WriteBackPolicy & _policy);
+    void resetWriteBackPolicy(const QString & _storage_device_id);
+    // The default policy of the installations and restorations, the installer can change it per task
+    IoPolicy ioPolicy() const;
+    void setIoPolicy(const IoPolicy & _policy);
 
 private:
     Settings();
@@ -0,0 +1,82 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStorageInfo>
+#ifndef _WIN32
+#   include <sys/stat.h>
+#   include <sys/types.h>
+#endif
+#ifdef __linux__
+#   include <sys/sysmacros.h>
+#endif
+#include <OplPcTools/StorageDevice.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+#ifdef __linux__
+
+QString wholeDiskId(dev_t _device)
+{
+    // /sys/dev/block/MAJ:MIN points to the partition directory which is nested into the disk one.
+    QFileInfo block_info(QString("/sys/dev/block/%1:%2").arg(major(_device)).arg(minor(_device)));
+    QFileInfo partition_info(block_info.canonicalFilePath());
+    if(partition_info.exists() && QFileInfo(partition_info.absoluteFilePath() + "/partition").exists())
+        return partition_info.absolutePath();
+    if(partition_info.exists())
+        return partition_info.absoluteFilePath();
+    return QString("%1:%2").arg(major(_device)).arg(minor(_device));
+}
+
+#endif // __linux__
+
+} // namespace
+
+QString OplPcTools::storageDeviceId(const QString & _path)
+{
+    QFileInfo file_info(_path);
+    QString path = file_info.exists() ? _path : file_info.absolutePath();
+#ifdef _WIN32
+    if(_path.startsWith("\\\\.\\"))
+        return _path;
+    return QString::fromLatin1(QStorageInfo(path).device());
+#else
+    struct stat file_stat;
+    if(stat(QFile::encodeName(path).constData(), &file_stat) != 0)
+        return QString::fromLatin1(QStorageInfo(path).device());
+    dev_t device = S_ISBLK(file_stat.st_mode) || S_ISCHR(file_stat.st_mode) ? file_stat.st_rdev : file_stat.st_dev;
+#   ifdef __linux__
+    return wholeDiskId(device);
+#   else
+    return QString::number(static_cast<quint64>(device));
+#   endif
+#endif
+}
+
+bool OplPcTools::areTransfersConflicting(const QString & _source_id1, const QString & _destination_id1,
+    const QString & _source_id2, const QString & _destination_id2)
+{
+    // Sequential writes to the same drive are merged by the page cache well enough,
+    // but a read competes with any other stream on the same drive.
+    return _source_id1 == _source_id2 ||
+        _source_id1 == _destination_id2 ||
+        _destination_id1 == _source_id2;
+}
@@ -0,0 +1,42 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_STORAGEDEVICE__
+#define __OPLPCTOOLS_STORAGEDEVICE__
+
+#include <QString>
+
+namespace OplPcTools {
+
+/*
+ * Returns an identifier of the physical drive that holds the _path.
+ * Partitions of the same disk share the identifier, so two paths with equal identifiers
+ * compete for the same spindle. Raw drive files (/dev/sr0, \\.\E:) are identified by themselves.
+ */
+QString storageDeviceId(const QString & _path);
+
+/*
+ * Returns true if two transfers identified by the storage devices of their sources and destinations
+ * should not run simultaneously.
+ */
+bool areTransfersConflicting(const QString & _source_id1, const QString & _destination_id1,
+    const QString & _source_id2, const QString & _destination_id2);
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_STORAGEDEVICE__
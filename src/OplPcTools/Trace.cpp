@@ -0,0 +1,224 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifdef _OPLPCTOOLS_TRACING
+
+#include <cstdlib>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QPair>
+#include <QThread>
+#include <QVector>
+#include <OplPcTools/Trace.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const int g_max_buffered_events = 65536;
+
+struct TraceEvent
+{
+    const char * name;
+    char phase;
+    quint32 thread_id;
+    qint64 timestamp;
+    qint64 value; // Duration of a complete event or value of a counter
+};
+
+class TraceSession final
+{
+    Q_DISABLE_COPY(TraceSession)
+
+public:
+    TraceSession();
+    inline bool isEnabled() const;
+    inline qint64 timestamp() const;
+    void record(const char * _name, char _phase, qint64 _timestamp, qint64 _value);
+    void finish();
+
+private:
+    quint32 currentThreadId();
+    void appendSeparator(QByteArray & _json);
+    void writeBufferedEvents();
+
+private:
+    QString m_filepath;
+    QFile m_file;
+    bool m_has_written_events;
+    bool m_is_finished; // The pool threads are not joined before exit and may still record events
+    QElapsedTimer m_clock;
+    QMutex m_mutex;
+    QVector<TraceEvent> m_events;
+    QVector<QPair<quint32, QString>> m_threads;
+    QAtomicInteger<quint32> m_last_thread_id;
+};
+
+TraceSession & session()
+{
+    static TraceSession * session = new TraceSession();
+    return *session;
+}
+
+void finishSessionAtExit()
+{
+    session().finish();
+}
+
+QByteArray escapeJson(const QString & _string)
+{
+    QByteArray result = _string.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    return result;
+}
+
+} // namespace
+
+TraceSession::TraceSession() :
+    m_has_written_events(false),
+    m_is_finished(false),
+    m_last_thread_id(0)
+{
+    m_filepath = QString::fromLocal8Bit(qgetenv("OPLPCTOOLS_TRACE"));
+    if(m_filepath.isEmpty())
+        return;
+    m_file.setFileName(m_filepath);
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_filepath.clear();
+        return;
+    }
+    m_file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    m_clock.start();
+    m_events.reserve(g_max_buffered_events);
+    std::atexit(finishSessionAtExit);
+}
+
+bool TraceSession::isEnabled() const
+{
+    return !m_filepath.isEmpty();
+}
+
+qint64 TraceSession::timestamp() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+quint32 TraceSession::currentThreadId()
+{
+    static thread_local quint32 thread_id = 0;
+    if(thread_id == 0)
+    {
+        thread_id = m_last_thread_id.fetchAndAddOrdered(1) + 1;
+        QThread * thread = QThread::currentThread();
+        QString name = thread->objectName();
+        if(name.isEmpty())
+            name = QString("%1 #%2").arg(thread->metaObject()->className()).arg(thread_id);
+        m_threads.append(qMakePair(thread_id, name));
+    }
+    return thread_id;
+}
+
+void TraceSession::record(const char * _name, char _phase, qint64 _timestamp, qint64 _value)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_is_finished)
+        return;
+    m_events.append(TraceEvent { _name, _phase, currentThreadId(), _timestamp, _value });
+    if(m_events.size() >= g_max_buffered_events)
+        writeBufferedEvents();
+}
+
+void TraceSession::appendSeparator(QByteArray & _json)
+{
+    if(m_has_written_events)
+        _json.append(",\n");
+    else
+        m_has_written_events = true;
+}
+
+void TraceSession::writeBufferedEvents()
+{
+    QByteArray json;
+    for(const QPair<quint32, QString> & thread : m_threads)
+    {
+        appendSeparator(json);
+        json.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":")
+            .append(QByteArray::number(thread.first))
+            .append(",\"args\":{\"name\":\"").append(escapeJson(thread.second)).append("\"}}");
+    }
+    m_threads.clear();
+    for(const TraceEvent & event : m_events)
+    {
+        appendSeparator(json);
+        json.append("{\"name\":\"").append(event.name)
+            .append("\",\"cat\":\"oplpctools\",\"ph\":\"").append(event.phase)
+            .append("\",\"pid\":1,\"tid\":").append(QByteArray::number(event.thread_id))
+            .append(",\"ts\":").append(QByteArray::number(event.timestamp));
+        if(event.phase == 'X')
+            json.append(",\"dur\":").append(QByteArray::number(event.value));
+        else
+            json.append(",\"args\":{\"bytes\":").append(QByteArray::number(event.value)).append("}");
+        json.append("}");
+        if(json.size() > 1048576)
+        {
+            m_file.write(json);
+            json.clear();
+        }
+    }
+    m_events.clear();
+    m_file.write(json);
+    m_file.flush();
+}
+
+void TraceSession::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_is_finished)
+        return;
+    m_is_finished = true;
+    writeBufferedEvents();
+    m_file.write("\n]}\n");
+    m_file.close();
+}
+
+bool Trace::isEnabled()
+{
+    return session().isEnabled();
+}
+
+qint64 Trace::timestamp()
+{
+    return session().timestamp();
+}
+
+void Trace::complete(const char * _name, qint64 _start, qint64 _duration)
+{
+    session().record(_name, 'X', _start, _duration);
+}
+
+void Trace::counter(const char * _name, quint64 _value)
+{
+    TraceSession & trace_session = session();
+    trace_session.record(_name, 'C', trace_session.timestamp(), static_cast<qint64>(_value));
+}
+
+#endif // _OPLPCTOOLS_TRACING
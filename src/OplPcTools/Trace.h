@@ -0,0 +1,84 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_TRACE__
+#define __OPLPCTOOLS_TRACE__
+
+/*
+ * Chrome/Perfetto trace-event instrumentation.
+ * The scopes are compiled in only when the project is configured with OPT_ENABLE_TRACING=ON.
+ * The trace is recorded when the OPLPCTOOLS_TRACE environment variable holds a path to the output JSON file.
+ * Events are buffered in memory and appended to the file each time the buffer fills up and at exit.
+ */
+
+#ifdef _OPLPCTOOLS_TRACING
+
+#include <QtGlobal>
+
+namespace OplPcTools {
+
+class Trace final
+{
+public:
+    static bool isEnabled();
+    static qint64 timestamp();
+    static void complete(const char * _name, qint64 _start, qint64 _duration);
+    static void counter(const char * _name, quint64 _value);
+};
+
+class TraceScope final
+{
+    Q_DISABLE_COPY(TraceScope)
+
+public:
+    explicit TraceScope(const char * _name) :
+        mp_name(Trace::isEnabled() ? _name : nullptr),
+        m_start(mp_name ? Trace::timestamp() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if(mp_name)
+            Trace::complete(mp_name, m_start, Trace::timestamp() - m_start);
+    }
+
+private:
+    const char * mp_name;
+    qint64 m_start;
+};
+
+} // namespace OplPcTools
+
+#define OPT_TRACE_CONCAT_IMPL(a, b) a##b
+#define OPT_TRACE_CONCAT(a, b) OPT_TRACE_CONCAT_IMPL(a, b)
+#define OPT_TRACE_SCOPE(name) OplPcTools::TraceScope OPT_TRACE_CONCAT(opt_trace_scope_, __LINE__)(name)
+#define OPT_TRACE_COUNTER(name, value)                    \
+    do {                                                  \
+        if(OplPcTools::Trace::isEnabled())                \
+            OplPcTools::Trace::counter(name, value);      \
+    } while(false)
+
+#else // _OPLPCTOOLS_TRACING
+
+#define OPT_TRACE_SCOPE(name)
+#define OPT_TRACE_COUNTER(name, value)
+
+#endif // _OPLPCTOOLS_TRACING
+
+#endif // __OPLPCTOOLS_TRACE__
@@ -0,0 +1,146 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/TransferJournal.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const quint32 g_magic = 0x4F50544A; // OPTJ
+const quint32 g_version = 1;
+const QDataStream::Version g_stream_version = QDataStream::Qt_5_6;
+const quint64 g_verification_size = 4194304;
+
+} // namespace
+
+QString TransferJournal::filepath(const QString & _destination_filepath)
+{
+    return _destination_filepath + ".journal";
+}
+
+// Reads _buffer.size() bytes at the _offset of the files joined one after another
+bool TransferJournal::readFiles(const QStringList & _filepaths, quint64 _offset, QByteArray & _buffer)
+{
+    quint64 file_offset = 0;
+    qint64 read_bytes = 0;
+    for(const QString & filepath : _filepaths)
+    {
+        QFile file(filepath);
+        const quint64 file_size = static_cast<quint64>(file.size());
+        const quint64 position = _offset + read_bytes;
+        if(position < file_offset + file_size)
+        {
+            if(!file.open(QIODevice::ReadOnly) || !file.seek(position - file_offset))
+                return false;
+            const qint64 size = file.read(_buffer.data() + read_bytes, _buffer.size() - read_bytes);
+            if(size <= 0)
+                return false;
+            read_bytes += size;
+            if(read_bytes == _buffer.size())
+                return true;
+        }
+        file_offset += file_size;
+    }
+    return false;
+}
+
+// Removes the files of a suspended transfer that is not going to be continued along with its journal
+void TransferJournal::discard(const QString & _filepath)
+{
+    TransferJournal journal;
+    if(journal.load(_filepath))
+    {
+        for(const QString & filepath : journal.destination_filepaths)
+            QFile::remove(filepath);
+    }
+    QFile::remove(_filepath);
+}
+
+bool TransferJournal::isSameTransfer(const TransferJournal & _journal) const
+{
+    return source_filepath == _journal.source_filepath &&
+        game_id == _journal.game_id &&
+        source_size == _journal.source_size &&
+        source_mtime == _journal.source_mtime;
+}
+
+// Takes the checkpoint of the journal saved at the _filepath if it belongs to the same transfer
+// and the tail of its destination before the checkpoint matches the source read by _read_source.
+// Returns the offset to continue from, 0 if the transfer must start over.
+quint64 TransferJournal::resume(const QString & _filepath, std::function<bool(quint64, QByteArray &)> _read_source)
+{
+    OPT_TRACE_SCOPE("TransferJournal::resume");
+    TransferJournal saved_journal;
+    if(!saved_journal.load(_filepath) || !isSameTransfer(saved_journal) ||
+        saved_journal.durable_bytes == 0 || saved_journal.durable_bytes > source_size)
+    {
+        return 0;
+    }
+    const quint64 tail_size = qMin(g_verification_size, saved_journal.durable_bytes);
+    const quint64 tail_offset = saved_journal.durable_bytes - tail_size;
+    QByteArray source_tail(static_cast<int>(tail_size), Qt::Uninitialized);
+    QByteArray destination_tail(static_cast<int>(tail_size), Qt::Uninitialized);
+    if(!_read_source(tail_offset, source_tail) ||
+        !readFiles(saved_journal.destination_filepaths, tail_offset, destination_tail) ||
+        source_tail != destination_tail)
+    {
+        return 0;
+    }
+    destination_filepaths = saved_journal.destination_filepaths;
+    durable_bytes = saved_journal.durable_bytes;
+    return durable_bytes;
+}
+
+bool TransferJournal::load(const QString & _filepath)
+{
+    QFile file(_filepath);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(g_stream_version);
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if(magic != g_magic || version != g_version)
+        return false;
+    TransferJournal journal;
+    stream >> journal.source_filepath >> journal.game_id >> journal.source_size >> journal.source_mtime >>
+        journal.destination_filepaths >> journal.durable_bytes;
+    if(stream.status() != QDataStream::Ok)
+        return false;
+    *this = journal;
+    return true;
+}
+
+// The journal is replaced atomically, so a crash leaves either the previous checkpoint or the new one
+bool TransferJournal::save(const QString & _filepath) const
+{
+    QSaveFile file(_filepath);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream stream(&file);
+    stream.setVersion(g_stream_version);
+    stream << g_magic << g_version << source_filepath << game_id << source_size << source_mtime <<
+        destination_filepaths << durable_bytes;
+    return stream.status() == QDataStream::Ok && file.commit();
+}
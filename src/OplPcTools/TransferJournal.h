@@ -0,0 +1,61 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_TRANSFERJOURNAL__
+#define __OPLPCTOOLS_TRANSFERJOURNAL__
+
+#include <functional>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+namespace OplPcTools {
+
+/*
+ * Checkpoint of a transfer, kept next to its destination until the transfer completes.
+ * The destination files joined one after another hold durable_bytes of the source, so an interrupted transfer
+ * continues from there when it is started again instead of starting over.
+ */
+struct TransferJournal
+{
+    TransferJournal() :
+        source_size(0),
+        source_mtime(0),
+        durable_bytes(0)
+    {
+    }
+
+    QString source_filepath;
+    QString game_id;
+    quint64 source_size;
+    qint64 source_mtime;
+    QStringList destination_filepaths;
+    quint64 durable_bytes;
+
+    static QString filepath(const QString & _destination_filepath);
+    static bool readFiles(const QStringList & _filepaths, quint64 _offset, QByteArray & _buffer);
+    static void discard(const QString & _filepath);
+    bool isSameTransfer(const TransferJournal & _journal) const;
+    quint64 resume(const QString & _filepath, std::function<bool(quint64, QByteArray &)> _read_source);
+    bool load(const QString & _filepath);
+    bool save(const QString & _filepath) const;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_TRANSFERJOURNAL__
@@ -0,0 +1,73 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_TRANSFERPROGRESS__
+#define __OPLPCTOOLS_TRANSFERPROGRESS__
+
+#include <QAtomicInteger>
+
+namespace OplPcTools {
+
+/*
+ * Written by a worker thread and sampled by the UI thread. No events are posted on updates.
+ */
+class TransferProgress final
+{
+    Q_DISABLE_COPY(TransferProgress)
+
+public:
+    TransferProgress() :
+        m_total_bytes(0),
+        m_done_bytes(0)
+    {
+    }
+
+    void reset(quint64 _total_bytes)
+    {
+        m_done_bytes.storeRelease(0);
+        m_total_bytes.storeRelease(_total_bytes);
+    }
+
+    void setTotalBytes(quint64 _total_bytes)
+    {
+        m_total_bytes.storeRelease(_total_bytes);
+    }
+
+    void setDoneBytes(quint64 _done_bytes)
+    {
+        m_done_bytes.storeRelease(_done_bytes);
+    }
+
+    quint64 totalBytes() const
+    {
+        return m_total_bytes.loadAcquire();
+    }
+
+    quint64 doneBytes() const
+    {
+        return m_done_bytes.loadAcquire();
+    }
+
+private:
+    QAtomicInteger<quint64> m_total_bytes;
+    QAtomicInteger<quint64> m_done_bytes;
+};
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_TRANSFERPROGRESS__
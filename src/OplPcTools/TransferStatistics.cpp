@@ -0,0 +1,106 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <cmath>
+#include <QObject>
+#include <OplPcTools/TransferStatistics.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+const double g_smoothing_time_constant_ms = 3000.0;
+const qint64 g_stall_timeout_ms = 10000;
+
+} // namespace
+
+TransferStatistics::TransferStatistics()
+{
+    reset();
+}
+
+void TransferStatistics::reset()
+{
+    m_has_sample = false;
+    m_has_rate = false;
+    m_last_done_bytes = 0;
+    m_remaining_bytes = 0;
+    m_last_timestamp = 0;
+    m_last_progress_timestamp = 0;
+    m_bytes_per_second = 0;
+    m_is_stalled = false;
+}
+
+void TransferStatistics::sample(quint64 _total_bytes, quint64 _done_bytes, qint64 _timestamp_ms)
+{
+    m_remaining_bytes = _total_bytes > _done_bytes ? _total_bytes - _done_bytes : 0;
+    if(!m_has_sample)
+    {
+        m_has_sample = true;
+        m_last_done_bytes = _done_bytes;
+        m_last_timestamp = _timestamp_ms;
+        m_last_progress_timestamp = _timestamp_ms;
+        return;
+    }
+    const qint64 elapsed = _timestamp_ms - m_last_timestamp;
+    if(elapsed <= 0)
+        return;
+    const quint64 delta = _done_bytes > m_last_done_bytes ? _done_bytes - m_last_done_bytes : 0;
+    const double rate = delta * 1000.0 / elapsed;
+    if(m_has_rate)
+    {
+        // Exponential moving average which does not depend on the sampling interval.
+        const double alpha = 1.0 - std::exp(-elapsed / g_smoothing_time_constant_ms);
+        m_bytes_per_second += alpha * (rate - m_bytes_per_second);
+    }
+    else
+    {
+        m_bytes_per_second = rate;
+        m_has_rate = true;
+    }
+    if(delta > 0)
+        m_last_progress_timestamp = _timestamp_ms;
+    m_is_stalled = m_remaining_bytes > 0 && _timestamp_ms - m_last_progress_timestamp >= g_stall_timeout_ms;
+    m_last_done_bytes = _done_bytes;
+    m_last_timestamp = _timestamp_ms;
+}
+
+qint64 TransferStatistics::etaSeconds() const
+{
+    if(m_remaining_bytes == 0)
+        return 0;
+    if(m_is_stalled || m_bytes_per_second < 1.0)
+        return -1;
+    return static_cast<qint64>(std::ceil(m_remaining_bytes / m_bytes_per_second));
+}
+
+QString TransferStatistics::toString() const
+{
+    if(m_is_stalled)
+        return QObject::tr("stalled");
+    QString text = QObject::tr("%1 MB/s").arg(m_bytes_per_second / 1048576.0, 0, 'f', 1);
+    const qint64 eta = etaSeconds();
+    if(eta >= 0)
+    {
+        text += QString(", %1:%2:%3")
+            .arg(eta / 3600)
+            .arg(eta % 3600 / 60, 2, 10, QChar('0'))
+            .arg(eta % 60, 2, 10, QChar('0'));
+    }
+    return text;
+}
@@ -0,0 +1,60 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_TRANSFERSTATISTICS__
+#define __OPLPCTOOLS_TRANSFERSTATISTICS__
+
+#include <QString>
+
+namespace OplPcTools {
+
+class TransferStatistics final
+{
+public:
+    TransferStatistics();
+    void reset();
+    void sample(quint64 _total_bytes, quint64 _done_bytes, qint64 _timestamp_ms);
+    inline double bytesPerSecond() const;
+    qint64 etaSeconds() const;
+    inline bool isStalled() const;
+    QString toString() const;
+
+private:
+    bool m_has_sample;
+    bool m_has_rate;
+    quint64 m_last_done_bytes;
+    quint64 m_remaining_bytes;
+    qint64 m_last_timestamp;
+    qint64 m_last_progress_timestamp;
+    double m_bytes_per_second;
+    bool m_is_stalled;
+};
+
+double TransferStatistics::bytesPerSecond() const
+{
+    return m_bytes_per_second;
+}
+
+bool TransferStatistics::isStalled() const
+{
+    return m_is_stalled;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_TRANSFERSTATISTICS__
@@ -17,8 +17,8 @@
  ***********************************************************************************************/
 
 #include <QPushButton>
-#include <QThread>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/JobScheduler.h>
 #include <OplPcTools/UI/ChooseOpticalDiscDialog.h>
 #include <OplPcTools/OpticalDriveDeviceSource.h>
 
@@ -71,27 +71,19 @@ QSharedPointer<Device> DeviceListItem::device() const
     return m_data.device;
 }
 
-class InitializationThread : public QThread
+class Initialization
 {
 public:
-    explicit InitializationThread(QObject * _parent = nullptr);
+    void run();
     inline const QString & errorMessage() const;
     inline QList<DeviceDisplayData> & devices();
 
-protected:
-    void run() override;
-
 private:
     QString m_error_message;
     QList<DeviceDisplayData> m_devices;
 };
 
-InitializationThread::InitializationThread(QObject * _parent /*= nullptr*/) :
-    QThread(_parent)
-{
-}
-
-void InitializationThread::run()
+void Initialization::run()
 {
     try
     {
@@ -112,12 +104,12 @@ void InitializationThread::run()
     }
 }
 
-const QString & InitializationThread::errorMessage() const
+const QString & Initialization::errorMessage() const
 {
     return m_error_message;
 }
 
-QList<DeviceDisplayData> & InitializationThread::devices()
+QList<DeviceDisplayData> & Initialization::devices()
 {
     return m_devices;
 }
@@ -132,17 +124,20 @@ ChooseOpticalDiscDialog::ChooseOpticalDiscDialog(QWidget * _parent /*= nullptr*/
     mp_label_error->setVisible(false);
     mp_button_box->button(QDialogButtonBox::Open)->setDisabled(true);
     mp_tree_devices->setColumnWidth(0, 180);
-    InitializationThread * thread = new InitializationThread(this);
-    connect(thread, &QThread::finished, thread, [this, thread]() {
+    // The dialog may be closed before the drives are read, so the result is shared with the job
+    QSharedPointer<Initialization> initialization(new Initialization);
+    JobPointer job = Job::create(JobKind::Io, [initialization]() { initialization->run(); });
+    job->setPriority(JobPriority::High);
+    connect(job.data(), &Job::finished, this, [this, initialization]() {
         mp_widget_loading->setVisible(false);
-        QList<DeviceDisplayData> & devices = thread->devices();
+        QList<DeviceDisplayData> & devices = initialization->devices();
         for(const DeviceDisplayData & display_data : devices)
         {
             fixDeviceTitle(*display_data.device);
             mp_tree_devices->addTopLevelItem(new DeviceListItem(mp_tree_devices, display_data));
         }
         mp_tree_devices->sortItems(0, Qt::AscendingOrder);
-        QString error_message = thread->errorMessage();
+        QString error_message = initialization->errorMessage();
         if(error_message.isEmpty() && devices.isEmpty())
             error_message = tr("There are no available CD/DVD drives");
         if(error_message.isEmpty())
@@ -155,8 +150,7 @@ ChooseOpticalDiscDialog::ChooseOpticalDiscDialog(QWidget * _parent /*= nullptr*/
             mp_label_error->setVisible(true);
         }
     });
-    connect(thread, &QThread::finished, thread, &QThread::deleteLater);
-    thread->start();
+    JobScheduler::instance().submit(job);
 }
 
 void ChooseOpticalDiscDialog::fixDeviceTitle(Device & _device) const
@@ -0,0 +1,80 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <OplPcTools/UI/DummyFilesDialog.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::UI;
+
+namespace {
+
+const quint64 g_mebibyte = 1048576;
+const int g_size_role = Qt::UserRole;
+
+} // namespace
+
+DummyFilesDialog::DummyFilesDialog(const QList<Iso9660File> & _files, const QStringList & _selected_filepaths,
+    QWidget * _parent /*= nullptr*/) :
+    QDialog(_parent, Qt::WindowSystemMenuHint | Qt::WindowTitleHint)
+{
+    setupUi(this);
+    QList<Iso9660File> files = _files;
+    std::sort(files.begin(), files.end(), [](const Iso9660File & _left, const Iso9660File & _right) {
+        return _left.size > _right.size;
+    });
+    for(const Iso9660File & file : files)
+    {
+        QTreeWidgetItem * item = new QTreeWidgetItem(mp_tree_files);
+        item->setText(0, file.path);
+        item->setText(1, tr("%1 MiB").arg(static_cast<double>(file.size) / g_mebibyte, 0, 'f', 1));
+        item->setData(1, g_size_role, file.size);
+        item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+        const bool is_selected = _selected_filepaths.isEmpty() ?
+            DummyStrippingDeviceSource::isDummyFile(file) :
+            _selected_filepaths.contains(file.path, Qt::CaseInsensitive);
+        item->setCheckState(0, is_selected ? Qt::Checked : Qt::Unchecked);
+    }
+    mp_tree_files->resizeColumnToContents(0);
+    connect(mp_tree_files, &QTreeWidget::itemChanged, this, &DummyFilesDialog::updateFreedSize);
+    updateFreedSize();
+}
+
+QStringList DummyFilesDialog::selectedFilepaths() const
+{
+    QStringList filepaths;
+    for(int i = 0; i < mp_tree_files->topLevelItemCount(); ++i)
+    {
+        const QTreeWidgetItem * item = mp_tree_files->topLevelItem(i);
+        if(item->checkState(0) == Qt::Checked)
+            filepaths.append(item->text(0));
+    }
+    return filepaths;
+}
+
+void DummyFilesDialog::updateFreedSize()
+{
+    quint64 freed_size = 0;
+    for(int i = 0; i < mp_tree_files->topLevelItemCount(); ++i)
+    {
+        const QTreeWidgetItem * item = mp_tree_files->topLevelItem(i);
+        if(item->checkState(0) == Qt::Checked)
+            freed_size += item->data(1, g_size_role).toULongLong();
+    }
+    mp_label_freed_size->setText(tr("Space to be freed: %1 MiB").arg(static_cast<double>(freed_size) / g_mebibyte, 0, 'f', 1));
+}
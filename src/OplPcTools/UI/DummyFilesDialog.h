@@ -16,57 +16,29 @@
  *                                                                                             *
  ***********************************************************************************************/
 
-#ifndef __OPLPCTOOLS_LAMBDATHREAD__
-#define __OPLPCTOOLS_LAMBDATHREAD__
+#ifndef __OPLPCTOOLS_DUMMYFILESDIALOG__
+#define __OPLPCTOOLS_DUMMYFILESDIALOG__
 
-#include <functional>
-#include <QThread>
-#include <OplPcTools/Exception.h>
+#include <QDialog>
+#include <OplPcTools/DummyStrippingDeviceSource.h>
+#include "ui_DummyFilesDialog.h"
 
 namespace OplPcTools {
 namespace UI {
 
-class LambdaThread : public QThread
+class DummyFilesDialog : public QDialog, private Ui::DummyFilesDialog
 {
     Q_OBJECT
 
 public:
-    explicit LambdaThread(std::function<void()> _lambda, QObject * _parent = nullptr) :
-        QThread(_parent),
-        m_lambda(_lambda)
-    {
-    }
+    DummyFilesDialog(const QList<Iso9660File> & _files, const QStringList & _selected_filepaths, QWidget * _parent = nullptr);
+    QStringList selectedFilepaths() const;
 
-
-protected:
-    void run() override
-    {
-        try
-        {
-            m_lambda();
-        }
-        catch(const OplPcTools::Exception & ex)
-        {
-            emit exception(ex.message());
-        }
-        catch(const std::exception & err)
-        {
-            emit exception(QString::fromStdString(err.what()));
-        }
-        catch(...)
-        {
-            emit exception(tr("An unknown error has occurred"));
-        }
-    }
-
-signals:
-    void exception(QString _message);
-
-private:
-    std::function<void()> m_lambda;
+private slots:
+    void updateFreedSize();
 };
 
 } // namespace UI
 } // namespace OplPcTools
 
-#endif // __OPLPCTOOLS_LAMBDATHREAD__
+#endif // __OPLPCTOOLS_DUMMYFILESDIALOG__
@@ -16,16 +16,34 @@
  *                                                                                             *
  ***********************************************************************************************/
 
+#include <algorithm>
 #include <QShortcut>
+#include <QApplication>
+#include <QCache>
+#include <QPainter>
+#include <QStyledItemDelegate>
 #include <QMessageBox>
 #include <QFileDialog>
 #include <QAbstractItemModel>
+#include <QProgressDialog>
+#include <QEventLoop>
+#include <QStandardPaths>
 #include <OplPcTools/Settings.h>
+#include <OplPcTools/Trace.h>
 #include <OplPcTools/GameCollection.h>
+#include <OplPcTools/GameCollectionSnapshot.h>
+#include <OplPcTools/GameIconAtlas.h>
+#include <OplPcTools/GameArtImporter.h>
+#include <OplPcTools/GameArtOptimizer.h>
+#include <OplPcTools/DuplicateFinder.h>
+#include <OplPcTools/LibraryVerifier.h>
+#include <OplPcTools/GameSearchIndex.h>
+#include <OplPcTools/JobScheduler.h>
 #include <OplPcTools/UI/Application.h>
 #include <OplPcTools/UI/GameDetailsActivity.h>
 #include <OplPcTools/UI/IsoRestorerActivity.h>
 #include <OplPcTools/UI/GameCollectionActivity.h>
+#include <OplPcTools/UI/GameCoverGridView.h>
 #include <OplPcTools/UI/GameInstallerActivity.h>
 #include <OplPcTools/UI/GameRenameDialog.h>
 
@@ -36,11 +54,26 @@ namespace {
 
 namespace SettingsKey {
 
-const char * ul_dir     = "ULDirectory";
-const char * icons_size = "GameListIconSize";
+const char * ul_dir       = "ULDirectory";
+const char * icons_size   = "GameListIconSize";
+const char * art_pack_dir = "ArtPackDirectory";
+const char * cover_grid   = "GameListCoverGrid";
 
 } // namespace SettingsKey
 
+const int g_snapshot_save_delay = 1000;
+const int g_filter_delay = 150;
+const int g_fetch_batch_size = 1000;
+const int g_max_cached_icons = 2000;
+const int g_item_margin = 4;
+const int g_item_padding = 2;
+const QColor g_broken_game_color(Qt::red);
+
+QString snapshotFilepath(const QString & _directory)
+{
+    return GameCollectionSnapshot::filepath(QStandardPaths::writableLocation(QStandardPaths::CacheLocation), _directory);
+}
+
 class GameCollectionActivityIntent : public Intent
 {
 public:
@@ -50,6 +83,32 @@ public:
     }
 };
 
+// Runs the _work as a job while a modal progress dialog is shown for the _task.
+// Returns the error message of an exception thrown by the _work.
+template<typename Task>
+QString runWithProgressDialog(QWidget * _parent, const QString & _label, Task & _task, std::function<void()> _work)
+{
+    QProgressDialog progress_dialog(_label, QObject::tr("Cancel"), 0, 0, _parent);
+    progress_dialog.setWindowModality(Qt::WindowModal);
+    progress_dialog.setMinimumDuration(0);
+    QObject::connect(&_task, &Task::progress, &progress_dialog, [&progress_dialog](int _processed, int _total) {
+        progress_dialog.setMaximum(_total);
+        progress_dialog.setValue(_processed);
+    });
+    QObject::connect(&progress_dialog, &QProgressDialog::canceled, [&_task]() { _task.cancel(); });
+    QString error_message;
+    // The task submits its reads as I/O jobs, this job only waits for them and must not hold an I/O thread
+    JobPointer job = Job::create(JobKind::Cpu, _work);
+    job->setPriority(JobPriority::High);
+    QEventLoop event_loop;
+    QObject::connect(job.data(), &Job::failed, &event_loop, [&error_message](QString _message) { error_message = _message; });
+    QObject::connect(job.data(), &Job::finished, &event_loop, &QEventLoop::quit);
+    JobScheduler::instance().submit(job);
+    event_loop.exec();
+    progress_dialog.reset();
+    return error_message;
+}
+
 } // namespace
 
 class GameCollectionActivity::GameTreeModel : public QAbstractItemModel
@@ -61,84 +120,276 @@ public:
     int rowCount(const QModelIndex & _parent) const override;
     int columnCount(const QModelIndex & _parent) const override;
     QVariant data(const QModelIndex & _index, int _role) const override;
-    const Game * game(const QModelIndex & _index) const;
+    bool canFetchMore(const QModelIndex & _parent) const override;
+    void fetchMore(const QModelIndex & _parent) override;
+    QSharedPointer<const Game> game(const QModelIndex & _index) const;
+    inline const Game * game(int _row) const;
+    QPixmap icon(int _row) const;
     void setArtManager(GameArtManager & _manager);
+    void setIconSize(int _size);
+    QSet<QString> search(const QString & _query) const;
+    void fetchMatches(const QSet<QString> & _game_ids);
+    void setIntegrityIssues(const QString & _game_id, const QStringList & _issues);
+    void clearIntegrityIssues();
+    inline bool isBroken(int _row) const;
 
 private:
+    void collectionLoadingFinished();
     void collectionLoaded();
-    void gameAdded(const QString & _id);
-    void gameAboutToBeDeleted(const QString & _id);
-    void gameDeleted(const QString & _id);
-    void updateRecord(const QString & _id);
+    void updateRecord(const QString & _id, const QVector<int> & _roles);
     void gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap);
+    void gameArtsReloaded();
+    void reset();
+    void sync();
+    void syncChanges(const GameList & _games);
+    void indexGames(int _first, int _last);
 
 private:
     const QPixmap m_default_icon;
+    QPixmap m_scaled_default_icon;
     const GameCollection & mr_collection;
     GameArtManager * mp_art_manager;
-    int m_row_count;
+    mutable QCache<QString, QPixmap> m_icons;
+    QHash<QString, QStringList> m_integrity_issues; // Issues of the broken games found by the last verification
+    GameList m_games;
+    GameSearchIndex m_search_index; // Covers all the games, including the ones that have no rows yet
+    int m_fetched_row_count;
+    int m_icon_size;
+    bool m_is_populated;
 };
 
+const Game * GameCollectionActivity::GameTreeModel::game(int _row) const
+{
+    return m_games[_row].data();
+}
+
+bool GameCollectionActivity::GameTreeModel::isBroken(int _row) const
+{
+    return m_integrity_issues.contains(m_games[_row]->id());
+}
+
 
 GameCollectionActivity::GameTreeModel::GameTreeModel(GameCollection & _collection, QObject * _parent /*= nullptr*/) :
     QAbstractItemModel(_parent),
     m_default_icon(QPixmap(":/images/no-icon")),
     mr_collection(_collection),
     mp_art_manager(nullptr),
-    m_row_count(_collection.count())
+    m_icons(g_max_cached_icons),
+    m_games(*_collection.games()),
+    m_fetched_row_count(qMin(m_games.count(), g_fetch_batch_size)),
+    m_icon_size(0),
+    m_is_populated(false)
 {
+    setIconSize(GameIconAtlas::level_count * GameIconAtlas::level_step);
+    connect(&_collection, &GameCollection::loadingStarted, this, &GameCollectionActivity::GameTreeModel::reset);
+    connect(&_collection, &GameCollection::gamesLoaded, this, &GameCollectionActivity::GameTreeModel::sync);
+    connect(&_collection, &GameCollection::loadingFinished, this, &GameCollectionActivity::GameTreeModel::collectionLoadingFinished);
     connect(&_collection, &GameCollection::loaded, this, &GameCollectionActivity::GameTreeModel::collectionLoaded);
-    connect(&_collection, &GameCollection::gameRenamed, this, &GameCollectionActivity::GameTreeModel::updateRecord);
-    connect(&_collection, &GameCollection::gameAdded, this, &GameCollectionActivity::GameTreeModel::gameAdded);
-    connect(&_collection, &GameCollection::gameAboutToBeDeleted, this, &GameCollectionActivity::GameTreeModel::gameAboutToBeDeleted);
-    connect(&_collection, &GameCollection::gameDeleted, this, &GameCollectionActivity::GameTreeModel::gameDeleted);
+    connect(&_collection, &GameCollection::gameRenamed, this, &GameCollectionActivity::GameTreeModel::sync);
+    connect(&_collection, &GameCollection::gameAdded, this, &GameCollectionActivity::GameTreeModel::sync);
+    connect(&_collection, &GameCollection::gameDeleted, this, &GameCollectionActivity::GameTreeModel::sync);
+    indexGames(0, m_games.count() - 1);
 }
 
-void GameCollectionActivity::GameTreeModel::collectionLoaded()
+void GameCollectionActivity::GameTreeModel::reset()
 {
     beginResetModel();
-    m_row_count = mr_collection.count();
+    m_icons.clear();
+    m_integrity_issues.clear();
+    m_games = *mr_collection.games();
+    m_fetched_row_count = qMin(m_games.count(), g_fetch_batch_size);
+    m_search_index.clear();
+    indexGames(0, m_games.count() - 1);
     endResetModel();
 }
 
-void GameCollectionActivity::GameTreeModel::gameAdded(const QString & _id)
+void GameCollectionActivity::GameTreeModel::collectionLoadingFinished()
 {
-    Q_UNUSED(_id);
-    beginInsertRows(QModelIndex(), m_row_count, m_row_count);
-    ++m_row_count;
-    endInsertRows();
+    m_is_populated = true;
+}
+
+void GameCollectionActivity::GameTreeModel::collectionLoaded()
+{
+    if(m_is_populated)
+    {
+        // The rows have already been inserted batch by batch, resetting would lose the selection
+        m_is_populated = false;
+        sync();
+        return;
+    }
+    reset();
+}
+
+// Brings the rows to the list published by the collection. The signals may be queued from other threads,
+// so a signal is only a hint that the list has changed, the difference is found by comparing the lists.
+void GameCollectionActivity::GameTreeModel::sync()
+{
+    const GameListPointer games = mr_collection.games();
+    if(games->constData() == m_games.constData())
+        return; // Has been synchronized by a previous signal
+    const int count = m_games.count();
+    bool is_appended = games->count() >= count;
+    for(int i = 0; is_appended && i < count; ++i)
+        is_appended = games->at(i) == m_games[i];
+    // The progressively loaded games are appended to the end of the collection and exposed by fetchMore
+    if(is_appended)
+    {
+        m_games = *games;
+        indexGames(count, m_games.count() - 1);
+    }
+    else
+    {
+        syncChanges(*games);
+    }
+    // The first screen of rows is exposed at once
+    if(m_fetched_row_count < g_fetch_batch_size)
+        fetchMore(QModelIndex());
 }
 
-void GameCollectionActivity::GameTreeModel::gameAboutToBeDeleted(const QString & _id)
+// The games that remain in the list keep their order, so the rows are removed and inserted in runs
+void GameCollectionActivity::GameTreeModel::syncChanges(const GameList & _games)
 {
-    for(int i = 0; i < m_row_count; ++i)
+    OPT_TRACE_SCOPE("GameTreeModel::syncChanges");
+    QSet<QString> ids;
+    ids.reserve(_games.count());
+    for(const QSharedPointer<const Game> & game : _games)
+        ids.insert(game->id());
+    for(int last = m_games.count() - 1; last >= 0; --last)
     {
-        const Game * game = mr_collection[i];
-        if(game->id() == _id)
+        if(ids.contains(m_games[last]->id()))
+            continue;
+        int first = last;
+        while(first > 0 && !ids.contains(m_games[first - 1]->id()))
+            --first;
+        for(int row = first; row <= last; ++row)
         {
-            beginRemoveRows(QModelIndex(), i, i);
-            return;
+            m_icons.remove(m_games[row]->id());
+            m_search_index.remove(m_games[row]->id());
+        }
+        const int fetched_last = qMin(last, m_fetched_row_count - 1);
+        if(first <= fetched_last)
+        {
+            beginRemoveRows(QModelIndex(), first, fetched_last);
+            m_games.remove(first, last - first + 1);
+            m_fetched_row_count -= fetched_last - first + 1;
+            endRemoveRows();
+        }
+        else
+        {
+            m_games.remove(first, last - first + 1);
         }
+        last = first;
     }
+    ids.clear();
+    for(const QSharedPointer<const Game> & game : m_games)
+        ids.insert(game->id());
+    int row = 0;
+    for(int i = 0; i < _games.count();)
+    {
+        const QSharedPointer<const Game> & game = _games[i];
+        if(ids.contains(game->id()))
+        {
+            if(row >= m_games.count() || m_games[row]->id() != game->id())
+            {
+                // The games have been reordered, the rows cannot be matched
+                reset();
+                return;
+            }
+            if(m_games[row] != game)
+            {
+                // The files of a changed game have to be verified again
+                m_integrity_issues.remove(game->id());
+                m_search_index.insert(game->id(), game->title());
+                m_games[row] = game;
+                if(row < m_fetched_row_count)
+                    emit dataChanged(createIndex(row, 0), createIndex(row, 0));
+            }
+            ++row;
+            ++i;
+            continue;
+        }
+        int end = i + 1;
+        while(end < _games.count() && !ids.contains(_games[end]->id()))
+            ++end;
+        const int count = end - i;
+        for(int j = i; j < end; ++j)
+            m_search_index.insert(_games[j]->id(), _games[j]->title());
+        // The games that fall behind the fetched rows are exposed by fetchMore later
+        if(row < m_fetched_row_count || m_fetched_row_count == m_games.count())
+        {
+            beginInsertRows(QModelIndex(), row, row + count - 1);
+            m_games.insert(row, count, QSharedPointer<const Game>());
+            std::copy(_games.cbegin() + i, _games.cbegin() + end, m_games.begin() + row);
+            m_fetched_row_count += count;
+            endInsertRows();
+        }
+        else
+        {
+            m_games.insert(row, count, QSharedPointer<const Game>());
+            std::copy(_games.cbegin() + i, _games.cbegin() + end, m_games.begin() + row);
+        }
+        row += count;
+        i = end;
+    }
+    // Shares the data with the published list, so the next sync can skip it
+    m_games = _games;
+}
+
+// The view fetches the rows while it is scrolled down. Filtering finds the games in the index of the whole list
+// and exposes the rows up to the last match only.
+bool GameCollectionActivity::GameTreeModel::canFetchMore(const QModelIndex & _parent) const
+{
+    return !_parent.isValid() && m_fetched_row_count < m_games.count();
+}
+
+void GameCollectionActivity::GameTreeModel::fetchMore(const QModelIndex & _parent)
+{
+    if(!canFetchMore(_parent))
+        return;
+    const int count = qMin(m_games.count() - m_fetched_row_count, g_fetch_batch_size);
+    beginInsertRows(QModelIndex(), m_fetched_row_count, m_fetched_row_count + count - 1);
+    m_fetched_row_count += count;
+    endInsertRows();
+}
+
+void GameCollectionActivity::GameTreeModel::indexGames(int _first, int _last)
+{
+    for(int i = _first; i <= _last; ++i)
+        m_search_index.insert(m_games[i]->id(), m_games[i]->title());
 }
 
-void GameCollectionActivity::GameTreeModel::gameDeleted(const QString & _id)
+QSet<QString> GameCollectionActivity::GameTreeModel::search(const QString & _query) const
 {
-    Q_UNUSED(_id);
-    m_row_count = mr_collection.count();
-    endRemoveRows();
+    return m_search_index.search(_query);
 }
 
-void GameCollectionActivity::GameTreeModel::updateRecord(const QString & _id)
+// Exposes the rows up to the last of the games that have no rows yet
+void GameCollectionActivity::GameTreeModel::fetchMatches(const QSet<QString> & _game_ids)
 {
-    int count = mr_collection.count();
-    for(int i = 0; i < count; ++i)
+    int last_row = -1;
+    for(int row = m_games.count() - 1; row >= m_fetched_row_count; --row)
     {
-        const Game * game = mr_collection[i];
-        if(game->id() == _id)
+        if(_game_ids.contains(m_games[row]->id()))
         {
-            emit dataChanged(createIndex(i, 0), createIndex(i, 0));
-            return;
+            last_row = row;
+            break;
+        }
+    }
+    if(last_row < 0)
+        return;
+    beginInsertRows(QModelIndex(), m_fetched_row_count, last_row);
+    m_fetched_row_count = last_row + 1;
+    endInsertRows();
+}
+
+void GameCollectionActivity::GameTreeModel::updateRecord(const QString & _id, const QVector<int> & _roles)
+{
+    for(int row = 0; row < m_fetched_row_count; ++row)
+    {
+        if(m_games[row]->id() == _id)
+        {
+            emit dataChanged(createIndex(row, 0), createIndex(row, 0), _roles);
+            break;
         }
     }
 }
@@ -146,8 +397,17 @@ void GameCollectionActivity::GameTreeModel::updateRecord(const QString & _id)
 void GameCollectionActivity::GameTreeModel::gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap)
 {
     Q_UNUSED(_pixmap)
-    if(_type == GameArtType::Icon)
-        updateRecord(_game_id);
+    if(_type != GameArtType::Icon)
+        return;
+    m_icons.remove(_game_id);
+    updateRecord(_game_id, { Qt::DecorationRole });
+}
+
+void GameCollectionActivity::GameTreeModel::gameArtsReloaded()
+{
+    m_icons.clear();
+    if(m_fetched_row_count > 0)
+        emit dataChanged(createIndex(0, 0), createIndex(m_fetched_row_count - 1, 0), { Qt::DecorationRole });
 }
 
 QModelIndex GameCollectionActivity::GameTreeModel::index(int _row, int _column, const QModelIndex & _parent) const
@@ -166,7 +426,7 @@ int GameCollectionActivity::GameTreeModel::rowCount(const QModelIndex & _parent)
 {
     if(_parent.isValid())
         return 0;
-    return m_row_count;
+    return m_fetched_row_count;
 }
 
 int GameCollectionActivity::GameTreeModel::columnCount(const QModelIndex & _parent) const
@@ -180,29 +440,220 @@ QVariant GameCollectionActivity::GameTreeModel::data(const QModelIndex & _index,
     switch(_role)
     {
     case Qt::DisplayRole:
-        return mr_collection[_index.row()]->title();
+        return m_games[_index.row()]->title();
     case Qt::DecorationRole:
-        if(mp_art_manager)
-        {
-            QPixmap icon = mp_art_manager->load(mr_collection[_index.row()]->id(), GameArtType::Icon);
-            return QIcon(icon.isNull() ? m_default_icon : icon);
-        }
-        break;
+        return icon(_index.row());
+    case Qt::ForegroundRole:
+        return isBroken(_index.row()) ? QVariant(g_broken_game_color) : QVariant();
+    case Qt::ToolTipRole:
+        return m_integrity_issues.value(m_games[_index.row()]->id()).join("\n");
+    case GameCoverGridView::game_id_role:
+        return m_games[_index.row()]->id();
     }
     return QVariant();
 }
 
-const Game * GameCollectionActivity::GameTreeModel::game(const QModelIndex & _index) const
+// Icons come from the atlas or the art cache, otherwise the placeholder is shown until artChanged delivers the icon.
+// The icons scaled to the current size are kept until they change, so painting a row does not convert them again.
+QPixmap GameCollectionActivity::GameTreeModel::icon(int _row) const
 {
-    return _index.isValid() ? mr_collection[_index.row()] : nullptr;
+    if(!mp_art_manager)
+        return m_scaled_default_icon;
+    const QString & id = m_games[_row]->id();
+    if(const QPixmap * cached_icon = m_icons.object(id))
+        return *cached_icon;
+    QPixmap icon = mp_art_manager->requestIcon(id, m_icon_size);
+    if(icon.isNull())
+        return m_scaled_default_icon;
+    if(icon.width() != m_icon_size || icon.height() != m_icon_size)
+        icon = icon.scaled(m_icon_size, m_icon_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    m_icons.insert(id, new QPixmap(icon));
+    return icon;
+}
+
+// The game stays valid while the model is synchronized, e.g. during a dialog
+QSharedPointer<const Game> GameCollectionActivity::GameTreeModel::game(const QModelIndex & _index) const
+{
+    return _index.isValid() ? m_games[_index.row()] : QSharedPointer<const Game>();
 }
 
 void GameCollectionActivity::GameTreeModel::setArtManager(GameArtManager & _manager)
 {
     if(mp_art_manager)
+    {
         disconnect(mp_art_manager, &GameArtManager::artChanged, this, &GameTreeModel::gameArtChanged);
+        disconnect(mp_art_manager, &GameArtManager::artsReloaded, this, &GameTreeModel::gameArtsReloaded);
+    }
     mp_art_manager = &_manager;
+    m_icons.clear();
     connect(mp_art_manager, &GameArtManager::artChanged, this, &GameTreeModel::gameArtChanged);
+    connect(mp_art_manager, &GameArtManager::artsReloaded, this, &GameTreeModel::gameArtsReloaded);
+}
+
+// The results come while the verification goes on, only the broken games are remembered
+void GameCollectionActivity::GameTreeModel::setIntegrityIssues(const QString & _game_id, const QStringList & _issues)
+{
+    if(_issues.isEmpty() && m_integrity_issues.remove(_game_id) == 0)
+        return;
+    if(!_issues.isEmpty())
+        m_integrity_issues[_game_id] = _issues;
+    updateRecord(_game_id, { Qt::ForegroundRole, Qt::ToolTipRole });
+}
+
+void GameCollectionActivity::GameTreeModel::clearIntegrityIssues()
+{
+    m_integrity_issues.clear();
+    if(m_fetched_row_count > 0)
+        emit dataChanged(createIndex(0, 0), createIndex(m_fetched_row_count - 1, 0), { Qt::ForegroundRole, Qt::ToolTipRole });
+}
+
+void GameCollectionActivity::GameTreeModel::setIconSize(int _size)
+{
+    if(m_icon_size == _size)
+        return;
+    m_icon_size = _size;
+    m_scaled_default_icon = m_default_icon.scaled(_size, _size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    m_icons.clear();
+    if(m_fetched_row_count > 0)
+        emit dataChanged(createIndex(0, 0), createIndex(m_fetched_row_count - 1, 0), { Qt::DecorationRole });
+}
+
+class GameCollectionActivity::GameItemDelegate : public QStyledItemDelegate
+{
+public:
+    GameItemDelegate(const GameTreeModel & _model, const QSortFilterProxyModel & _proxy_model, QObject * _parent = nullptr);
+    void paint(QPainter * _painter, const QStyleOptionViewItem & _option, const QModelIndex & _index) const override;
+    QSize sizeHint(const QStyleOptionViewItem & _option, const QModelIndex & _index) const override;
+
+private:
+    const GameTreeModel & mr_model;
+    const QSortFilterProxyModel & mr_proxy_model;
+};
+
+
+GameCollectionActivity::GameItemDelegate::GameItemDelegate(const GameTreeModel & _model,
+        const QSortFilterProxyModel & _proxy_model, QObject * _parent /*= nullptr*/) :
+    QStyledItemDelegate(_parent),
+    mr_model(_model),
+    mr_proxy_model(_proxy_model)
+{
+}
+
+// Paints the icon and the title straight from the model, bypassing the QVariant roles and initStyleOption
+void GameCollectionActivity::GameItemDelegate::paint(QPainter * _painter, const QStyleOptionViewItem & _option, const QModelIndex & _index) const
+{
+    const int row = mr_proxy_model.mapToSource(_index).row();
+    const QSharedPointer<const Game> game = mr_model.game(mr_model.index(row, 0, QModelIndex()));
+    if(!game)
+        return;
+    const QWidget * widget = _option.widget;
+    QStyle * style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &_option, _painter, widget);
+    const QSize icon_size = _option.decorationSize;
+    const QPixmap icon = mr_model.icon(row);
+    QRect icon_rect(QPoint(), icon.size().boundedTo(icon_size));
+    icon_rect.moveCenter(QPoint(_option.rect.left() + g_item_margin + icon_size.width() / 2, _option.rect.center().y()));
+    _painter->drawPixmap(icon_rect, icon);
+    const QRect text_rect = _option.rect.adjusted(icon_size.width() + 2 * g_item_margin, 0, -g_item_margin, 0);
+    QPalette::ColorGroup color_group = QPalette::Disabled;
+    if(_option.state & QStyle::State_Enabled)
+        color_group = _option.state & QStyle::State_Active ? QPalette::Normal : QPalette::Inactive;
+    if(mr_model.isBroken(row) && !(_option.state & QStyle::State_Selected))
+        _painter->setPen(g_broken_game_color);
+    else
+        _painter->setPen(_option.palette.color(color_group,
+            _option.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+    _painter->drawText(text_rect, Qt::AlignLeft | Qt::AlignVCenter | Qt::TextSingleLine,
+        _option.fontMetrics.elidedText(game->title(), Qt::ElideRight, text_rect.width()));
+}
+
+// All the rows have the same height, the view asks it once
+QSize GameCollectionActivity::GameItemDelegate::sizeHint(const QStyleOptionViewItem & _option, const QModelIndex & _index) const
+{
+    Q_UNUSED(_index)
+    return QSize(_option.rect.width(), qMax(_option.decorationSize.height(), _option.fontMetrics.height()) + 2 * g_item_padding);
+}
+
+class GameCollectionActivity::GameFilterModel : public QSortFilterProxyModel
+{
+public:
+    GameFilterModel(GameTreeModel & _model, const GameCollection & _collection, QObject * _parent = nullptr);
+    void setFilter(const QString & _filter);
+
+protected:
+    bool filterAcceptsRow(int _source_row, const QModelIndex & _source_parent) const override;
+
+private:
+    void scheduleFiltering();
+    void applyFilter();
+
+private:
+    GameTreeModel & mr_model;
+    QString m_filter;
+    QSet<QString> m_matched_ids;
+    QTimer * mp_filter_timer;
+};
+
+
+// The matches are searched in the index of the _model, which covers the games that have no rows yet.
+// The changes of the _collection may add such games, so they are filtered again as well.
+GameCollectionActivity::GameFilterModel::GameFilterModel(GameTreeModel & _model, const GameCollection & _collection,
+        QObject * _parent /*= nullptr*/) :
+    QSortFilterProxyModel(_parent),
+    mr_model(_model),
+    mp_filter_timer(new QTimer(this))
+{
+    mp_filter_timer->setSingleShot(true);
+    mp_filter_timer->setInterval(g_filter_delay);
+    connect(mp_filter_timer, &QTimer::timeout, this, &GameFilterModel::applyFilter);
+    connect(&_model, &GameTreeModel::modelReset, this, &GameFilterModel::scheduleFiltering);
+    connect(&_model, &GameTreeModel::rowsInserted, this, &GameFilterModel::scheduleFiltering);
+    connect(&_model, &GameTreeModel::dataChanged, this,
+        [this](const QModelIndex &, const QModelIndex &, const QVector<int> & _roles) {
+            if(_roles.isEmpty() || _roles.contains(Qt::DisplayRole))
+                scheduleFiltering();
+        });
+    connect(&_collection, &GameCollection::gamesLoaded, this, &GameFilterModel::scheduleFiltering);
+    connect(&_collection, &GameCollection::gameAdded, this, &GameFilterModel::scheduleFiltering);
+    connect(&_collection, &GameCollection::gameRenamed, this, &GameFilterModel::scheduleFiltering);
+}
+
+// Filtering is deferred until typing stops
+void GameCollectionActivity::GameFilterModel::setFilter(const QString & _filter)
+{
+    m_filter = _filter.trimmed();
+    mp_filter_timer->start();
+}
+
+void GameCollectionActivity::GameFilterModel::scheduleFiltering()
+{
+    if(!m_filter.isEmpty())
+        mp_filter_timer->start();
+}
+
+void GameCollectionActivity::GameFilterModel::applyFilter()
+{
+    OPT_TRACE_SCOPE("GameFilterModel::applyFilter");
+    if(m_filter.isEmpty())
+    {
+        m_matched_ids.clear();
+    }
+    else
+    {
+        m_matched_ids = mr_model.search(m_filter);
+        mr_model.fetchMatches(m_matched_ids);
+    }
+    // The rows exposed for the matches have just been filtered
+    mp_filter_timer->stop();
+    invalidateFilter();
+}
+
+bool GameCollectionActivity::GameFilterModel::filterAcceptsRow(int _source_row, const QModelIndex & _source_parent) const
+{
+    Q_UNUSED(_source_parent)
+    if(m_filter.isEmpty())
+        return true;
+    return m_matched_ids.contains(mr_model.game(_source_row)->id());
 }
 
 GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/) :
@@ -210,9 +661,14 @@ GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/)
     mp_game_art_manager(nullptr),
     mp_model(nullptr),
     mp_context_menu(nullptr),
-    mp_proxy_model(nullptr)
+    mp_proxy_model(nullptr),
+    mp_snapshot_timer(new QTimer(this)),
+    m_is_revalidating(false)
 {
     setupUi(this);
+    mp_snapshot_timer->setSingleShot(true);
+    mp_snapshot_timer->setInterval(g_snapshot_save_delay);
+    mp_progress_loading->hide();
     QShortcut * filter_shortcat = new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_F), this);
     mp_edit_filter->setPlaceholderText(QString("%1 (%2)")
         .arg(mp_edit_filter->placeholderText())
@@ -221,11 +677,17 @@ GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/)
         .scaled(mp_label_cover->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
     GameCollection & game_collection = Application::instance().gameCollection();
     mp_model = new GameTreeModel(game_collection, this);
-    mp_proxy_model = new QSortFilterProxyModel(this);
-    mp_proxy_model->setFilterCaseSensitivity(Qt::CaseInsensitive);
+    mp_proxy_model = new GameFilterModel(*mp_model, game_collection, this);
     mp_proxy_model->setSourceModel(mp_model);
     mp_proxy_model->setDynamicSortFilter(true);
     mp_tree_games->setModel(mp_proxy_model);
+    mp_tree_games->setUniformRowHeights(true);
+    mp_tree_games->setItemDelegate(new GameItemDelegate(*mp_model, *mp_proxy_model, mp_tree_games));
+    // Both views share the selection, so the current game does not depend on the view
+    mp_grid_games->setModel(mp_proxy_model);
+    mp_grid_games->setSelectionModel(mp_tree_games->selectionModel());
+    mp_grid_games->hide();
+    mp_btn_cover_grid->setDefaultAction(mp_action_cover_grid);
     mp_btn_load->setDefaultAction(mp_action_load);
     mp_btn_reload->setDefaultAction(mp_action_reload);
     mp_btn_rename->setDefaultAction(mp_action_rename);
@@ -240,6 +702,10 @@ GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/)
     mp_context_menu->addAction(mp_action_delete);
     mp_context_menu->addSeparator();
     mp_context_menu->addAction(mp_action_install);
+    mp_context_menu->addAction(mp_action_import_art);
+    mp_context_menu->addAction(mp_action_optimize_art);
+    mp_context_menu->addAction(mp_action_find_duplicates);
+    mp_context_menu->addAction(mp_action_verify_library);
     mp_context_menu->addAction(mp_action_reload);
     mp_tree_games->setContextMenuPolicy(Qt::CustomContextMenu);
     activateCollectionControls(false);
@@ -248,6 +714,10 @@ GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/)
     connect(mp_slider_icons_size, &QSlider::valueChanged, [this](int) { changeIconsSize(); });
     connect(mp_action_load, &QAction::triggered, this, &GameCollectionActivity::load);
     connect(mp_action_reload, &QAction::triggered, this, &GameCollectionActivity::reload);
+    connect(mp_action_import_art, &QAction::triggered, this, &GameCollectionActivity::importArts);
+    connect(mp_action_optimize_art, &QAction::triggered, this, &GameCollectionActivity::optimizeArts);
+    connect(mp_action_find_duplicates, &QAction::triggered, this, &GameCollectionActivity::findDuplicates);
+    connect(mp_action_verify_library, &QAction::triggered, this, &GameCollectionActivity::verifyLibrary);
     connect(mp_action_edit, &QAction::triggered, this, &GameCollectionActivity::showGameDetails);
     connect(mp_action_rename, &QAction::triggered, this, &GameCollectionActivity::renameGame);
     connect(mp_action_delete, &QAction::triggered, this, &GameCollectionActivity::deleteGame);
@@ -255,12 +725,27 @@ GameCollectionActivity::GameCollectionActivity(QWidget * _parent /*= nullptr*/)
     connect(mp_action_restore_iso, &QAction::triggered, this, &GameCollectionActivity::showIsoRestorer);
     connect(mp_tree_games, &QTreeView::doubleClicked, [this](const QModelIndex &) { showGameDetails(); });
     connect(mp_tree_games, &QTreeView::customContextMenuRequested, this, &GameCollectionActivity::showTreeContextMenu);
+    mp_grid_games->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(mp_grid_games, &QListView::doubleClicked, [this](const QModelIndex &) { showGameDetails(); });
+    connect(mp_grid_games, &QListView::customContextMenuRequested, [this](const QPoint & _point) {
+        if(Application::instance().gameCollection().isLoaded())
+            mp_context_menu->exec(mp_grid_games->viewport()->mapToGlobal(_point));
+    });
+    connect(mp_action_cover_grid, &QAction::toggled, this, &GameCollectionActivity::showCoverGrid);
     connect(mp_tree_games->selectionModel(), &QItemSelectionModel::selectionChanged, [this](QItemSelection, QItemSelection) { gameSelected(); });
+    connect(&game_collection, &GameCollection::loadingStarted, this, &GameCollectionActivity::collectionLoadingStarted);
+    connect(&game_collection, &GameCollection::gamesLoaded, this, &GameCollectionActivity::collectionGamesLoaded);
+    connect(&game_collection, &GameCollection::loadingFailed, this, &GameCollectionActivity::collectionLoadingFailed);
     connect(&game_collection, &GameCollection::loaded, this, &GameCollectionActivity::collectionLoaded);
     connect(&game_collection, &GameCollection::gameAdded, this, &GameCollectionActivity::gameAdded);
     connect(&game_collection, &GameCollection::gameRenamed, this, &GameCollectionActivity::gameRenamed);
+    connect(&game_collection, &GameCollection::loaded, mp_snapshot_timer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(&game_collection, &GameCollection::gameAdded, mp_snapshot_timer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(&game_collection, &GameCollection::gameRenamed, mp_snapshot_timer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(&game_collection, &GameCollection::gameDeleted, mp_snapshot_timer, static_cast<void(QTimer::*)()>(&QTimer::start));
+    connect(mp_snapshot_timer, &QTimer::timeout, this, &GameCollectionActivity::saveSnapshot);
     connect(this, &GameCollectionActivity::destroyed, this, &GameCollectionActivity::saveSettings);
-    connect(mp_edit_filter, &QLineEdit::textChanged, mp_proxy_model, &QSortFilterProxyModel::setFilterFixedString);
+    connect(mp_edit_filter, &QLineEdit::textChanged, mp_proxy_model, &GameFilterModel::setFilter);
     applySettings();
 }
 
@@ -280,6 +765,7 @@ void GameCollectionActivity::changeIconsSize()
 {
     int size = mp_slider_icons_size->value() * 16;
     mp_tree_games->setIconSize(QSize(size, size));
+    mp_model->setIconSize(size);
 }
 
 void GameCollectionActivity::showTreeContextMenu(const QPoint & _point)
@@ -292,15 +778,21 @@ void GameCollectionActivity::activateCollectionControls(bool _activate)
 {
     mp_action_install->setEnabled(_activate);
     mp_action_reload->setEnabled(_activate);
+    mp_action_import_art->setEnabled(_activate);
+    mp_action_optimize_art->setEnabled(_activate);
+    mp_action_find_duplicates->setEnabled(_activate);
+    mp_action_verify_library->setEnabled(_activate);
 }
 
 void GameCollectionActivity::activateItemControls(const Game * _selected_game)
 {
     mp_widget_details->setVisible(_selected_game);
-    mp_action_delete->setEnabled(_selected_game);
-    mp_action_edit->setEnabled(_selected_game);
-    mp_action_rename->setEnabled(_selected_game);
-    mp_action_restore_iso->setEnabled(_selected_game && _selected_game->installationType() == GameInstallationType::UlConfig);
+    // The games can be browsed while the collection is loading, but not changed
+    const bool is_editable = _selected_game && !Application::instance().gameCollection().isLoading();
+    mp_action_delete->setEnabled(is_editable);
+    mp_action_edit->setEnabled(is_editable);
+    mp_action_rename->setEnabled(is_editable);
+    mp_action_restore_iso->setEnabled(is_editable && _selected_game->installationType() == GameInstallationType::UlConfig);
 }
 
 void GameCollectionActivity::applySettings()
@@ -317,12 +809,24 @@ void GameCollectionActivity::applySettings()
     mp_slider_icons_size->setValue(icons_size);
     icons_size *= 16;
     mp_tree_games->setIconSize(QSize(icons_size, icons_size));
+    mp_model->setIconSize(icons_size);
+    mp_action_cover_grid->setChecked(settings.value(SettingsKey::cover_grid, false).toBool());
 }
 
 void GameCollectionActivity::saveSettings()
 {
     QSettings settings;
     settings.setValue(SettingsKey::icons_size, mp_slider_icons_size->value());
+    settings.setValue(SettingsKey::cover_grid, mp_action_cover_grid->isChecked());
+}
+
+void GameCollectionActivity::showCoverGrid(bool _show)
+{
+    QAbstractItemView * shown_view = _show ? static_cast<QAbstractItemView *>(mp_grid_games) : mp_tree_games;
+    mp_tree_games->setVisible(!_show);
+    mp_grid_games->setVisible(_show);
+    mp_slider_icons_size->setEnabled(!_show);
+    shown_view->scrollTo(shown_view->currentIndex());
 }
 
 void GameCollectionActivity::load()
@@ -343,7 +847,8 @@ bool GameCollectionActivity::tryLoadRecentDirectory()
     if(!value.isValid()) return false;
     QDir dir(value.toString());
     if(!dir.exists()) return false;
-    loadDirectory(dir);
+    if(!restoreDirectory(dir))
+        loadDirectory(dir);
     return true;
 }
 
@@ -352,16 +857,12 @@ void GameCollectionActivity::loadDirectory(const QDir & _directory)
     try
     {
         GameCollection & game_collection = Application::instance().gameCollection();
-        game_collection.load(_directory);
-        delete mp_game_art_manager;
-        mp_game_art_manager = new GameArtManager(_directory, this);
-        connect(mp_game_art_manager, &GameArtManager::artChanged, this, &GameCollectionActivity::gameArtChanged);
-        mp_game_art_manager->addCacheType(GameArtType::Icon);
-        mp_game_art_manager->addCacheType(GameArtType::Front);
-        mp_model->setArtManager(*mp_game_art_manager);
-        mp_proxy_model->sort(0, Qt::AscendingOrder);
-        if(game_collection.count() > 0)
-            mp_tree_games->setCurrentIndex(mp_proxy_model->index(0, 0));
+        GameCollectionSnapshot hint;
+        // The images of an unchanged library are not probed again
+        if(!hint.load(snapshotFilepath(_directory.absolutePath())) || hint.directory != _directory.absolutePath())
+            hint = GameCollectionSnapshot();
+        game_collection.loadInBackground(_directory, hint);
+        setupArtManager(_directory);
     }
     catch(const Exception & exception)
     {
@@ -373,13 +874,115 @@ void GameCollectionActivity::loadDirectory(const QDir & _directory)
     }
 }
 
+// Shows the library from its snapshot immediately and checks the library itself in the background
+bool GameCollectionActivity::restoreDirectory(const QDir & _directory)
+{
+    GameCollectionSnapshot snapshot;
+    if(!snapshot.load(snapshotFilepath(_directory.absolutePath())) || snapshot.directory != _directory.absolutePath())
+        return false;
+    GameCollection & game_collection = Application::instance().gameCollection();
+    game_collection.restore(snapshot);
+    setupArtManager(_directory);
+    if(game_collection.count() > 0)
+        mp_tree_games->setCurrentIndex(mp_proxy_model->index(0, 0));
+    revalidateCollection();
+    return true;
+}
+
+// Reads the library into a separate collection and applies only the differences to the shown one.
+// The result is discarded and the reading is restarted if the collection has been changed meanwhile.
+void GameCollectionActivity::revalidateCollection()
+{
+    if(m_is_revalidating)
+        return;
+    m_is_revalidating = true;
+    GameCollection & game_collection = Application::instance().gameCollection();
+    const GameCollectionSnapshot hint = game_collection.snapshot();
+    const int revision = game_collection.revision();
+    QSharedPointer<GameCollectionSnapshot> result(new GameCollectionSnapshot);
+    QSharedPointer<QString> error_message(new QString);
+    JobPointer job = Job::create(JobKind::Io, [hint, result]() {
+        GameCollection collection;
+        collection.load(QDir(hint.directory), hint);
+        *result = collection.snapshot();
+    });
+    job->setPriority(JobPriority::Low);
+    // The library is only verified, so it must not slow down the interactive work
+    IoPolicy io_policy;
+    io_policy.io_class = IoClass::Idle;
+    job->setIoPolicy(io_policy);
+    connect(job.data(), &Job::failed, this, [error_message](QString _message) {
+        *error_message = _message;
+    });
+    connect(job.data(), &Job::finished, this, [this, hint, revision, result, error_message]() {
+        m_is_revalidating = false;
+        GameCollection & game_collection = Application::instance().gameCollection();
+        if(game_collection.directory() != hint.directory || game_collection.isLoading())
+            return; // The collection is being read again anyway
+        if(!error_message->isEmpty())
+            Application::instance().showErrorMessage(*error_message);
+        else if(game_collection.revision() != revision)
+            revalidateCollection();
+        else
+            game_collection.merge(*result);
+        saveSnapshot();
+    });
+    JobScheduler::instance().submit(job);
+}
+
+void GameCollectionActivity::setupArtManager(const QDir & _directory)
+{
+    delete mp_game_art_manager;
+    mp_game_art_manager = new GameArtManager(_directory, this);
+    connect(mp_game_art_manager, &GameArtManager::artChanged, this, &GameCollectionActivity::gameArtChanged);
+    connect(mp_game_art_manager, &GameArtManager::artsReloaded, this, &GameCollectionActivity::gameArtsReloaded);
+    mp_game_art_manager->addCacheType(GameArtType::Icon);
+    mp_game_art_manager->addCacheType(GameArtType::Front);
+    mp_game_art_manager->enableIconAtlas(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    mp_model->setArtManager(*mp_game_art_manager);
+    mp_grid_games->setArtManager(mp_game_art_manager);
+    mp_proxy_model->sort(0, Qt::AscendingOrder);
+}
+
+void GameCollectionActivity::saveSnapshot()
+{
+    mp_snapshot_timer->stop();
+    const GameCollection & game_collection = Application::instance().gameCollection();
+    if(game_collection.isLoaded() && !game_collection.isLoading())
+        game_collection.snapshot().save(snapshotFilepath(game_collection.directory()));
+}
+
 void GameCollectionActivity::reload()
 {
     loadDirectory(Application::instance().gameCollection().directory());
 }
 
+void GameCollectionActivity::collectionLoadingStarted()
+{
+    mp_label_directory->setText(Application::instance().gameCollection().directory());
+    activateCollectionControls(false);
+    mp_progress_loading->setFormat(tr("Loading..."));
+    mp_progress_loading->show();
+    gameSelected();
+}
+
+void GameCollectionActivity::collectionGamesLoaded(int _count)
+{
+    Q_UNUSED(_count)
+    mp_progress_loading->setFormat(tr("%1 games loaded").arg(Application::instance().gameCollection().count()));
+    if(!mp_tree_games->currentIndex().isValid())
+        mp_tree_games->setCurrentIndex(mp_proxy_model->index(0, 0));
+}
+
+void GameCollectionActivity::collectionLoadingFailed(const QString & _message)
+{
+    collectionLoaded();
+    Application::instance().showErrorMessage(_message);
+}
+
 void GameCollectionActivity::collectionLoaded()
 {
+    mp_progress_loading->hide();
     mp_label_directory->setText(Application::instance().gameCollection().directory());
     activateCollectionControls(true);
     gameSelected();
@@ -396,7 +999,7 @@ void GameCollectionActivity::gameAdded(const QString & _id)
 
 void GameCollectionActivity::gameRenamed(const QString & _id)
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game && game->id() == _id)
         gameSelected();
 }
@@ -405,19 +1008,29 @@ void GameCollectionActivity::gameArtChanged(const QString & _game_id, GameArtTyp
 {
     if(_type != GameArtType::Front)
         return;
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game && game->id() == _game_id)
         mp_label_cover->setPixmap(_pixmap ? *_pixmap : m_default_cover);
 }
 
+void GameCollectionActivity::gameArtsReloaded(const QStringList & _game_ids)
+{
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    if(game && _game_ids.contains(game->id()))
+    {
+        QPixmap pixmap = mp_game_art_manager->requestArt(game->id(), GameArtType::Front);
+        mp_label_cover->setPixmap(pixmap.isNull() ? m_default_cover : pixmap);
+    }
+}
+
 void GameCollectionActivity::gameSelected()
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game)
     {
         mp_label_id->setText(game->id());
         mp_label_title->setText(game->title());
-        QPixmap pixmap = mp_game_art_manager->load(game->id(), GameArtType::Front);
+        QPixmap pixmap = mp_game_art_manager->requestArt(game->id(), GameArtType::Front);
         mp_label_cover->setPixmap(pixmap.isNull() ? m_default_cover : pixmap);
         mp_label_type->setText(game->mediaType() == MediaType::CD ? "CD" : "DVD");
         mp_label_parts->setText(QString("%1").arg(game->partCount()));
@@ -429,12 +1042,159 @@ void GameCollectionActivity::gameSelected()
     {
         mp_widget_details->hide();
     }
-    activateItemControls(game);
+    activateItemControls(game.data());
+}
+
+void GameCollectionActivity::importArts()
+{
+    GameCollection & game_collection = Application::instance().gameCollection();
+    if(!mp_game_art_manager || !game_collection.isLoaded())
+        return;
+    QSettings settings;
+    QString dirpath = QFileDialog::getExistingDirectory(this, tr("Choose a Directory with Pictures"),
+        settings.value(SettingsKey::art_pack_dir).toString());
+    if(dirpath.isEmpty())
+        return;
+    settings.setValue(SettingsKey::art_pack_dir, dirpath);
+    QSet<QString> game_ids;
+    for(const QSharedPointer<const Game> & game : *game_collection.games())
+        game_ids.insert(game->id());
+    GameArtImporter importer(*mp_game_art_manager);
+    importer.setGameIds(game_ids);
+    GameArtImportResult result;
+    QString error_message = runWithProgressDialog(this, tr("Importing pictures..."), importer, [&]() {
+        result = importer.import({ dirpath });
+    });
+    mp_game_art_manager->reloadArts(result.arts);
+    if(!error_message.isEmpty())
+    {
+        Application::instance().showErrorMessage(error_message);
+        return;
+    }
+    QString message = tr("Pictures imported: %1\nFiles skipped: %2").arg(result.imported).arg(result.skipped);
+    if(result.failed > 0)
+        message += "\n" + tr("Failed: %1").arg(result.failed);
+    Application::instance().showMessage(tr("Import Pictures"), message);
+}
+
+void GameCollectionActivity::optimizeArts()
+{
+    if(!mp_game_art_manager || !Application::instance().gameCollection().isLoaded())
+        return;
+    QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Optimize Pictures"),
+        tr("All the pictures of the library will be scaled to the sizes used by OPL and recompressed.\nContinue?"));
+    if(answer != QMessageBox::Yes)
+        return;
+    GameArtOptimizer optimizer(*mp_game_art_manager);
+    GameArtOptimizationResult result;
+    QString error_message = runWithProgressDialog(this, tr("Optimizing pictures..."), optimizer, [&]() {
+        result = optimizer.optimize();
+    });
+    mp_game_art_manager->reloadArts(result.arts);
+    if(!error_message.isEmpty())
+    {
+        Application::instance().showErrorMessage(error_message);
+        return;
+    }
+    QString message = tr("Pictures optimized: %1\nPictures unchanged: %2\nSize before: %3 KiB\nSize after: %4 KiB")
+        .arg(result.optimized)
+        .arg(result.unchanged)
+        .arg(result.bytes_before / 1024)
+        .arg(result.bytes_after / 1024);
+    if(result.failed > 0)
+        message += "\n" + tr("Failed: %1").arg(result.failed);
+    Application::instance().showMessage(tr("Optimize Pictures"), message);
+}
+
+void GameCollectionActivity::findDuplicates()
+{
+    GameCollection & collection = Application::instance().gameCollection();
+    if(!collection.isLoaded())
+        return;
+    const QString cache_filepath = ImageHashCache::filepath(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation), collection.directory());
+    ImageHashCache cache;
+    cache.load(cache_filepath);
+    DuplicateFinder finder(collection, cache);
+    DuplicateSearchResult result;
+    QString error_message = runWithProgressDialog(this, tr("Searching for duplicates..."), finder, [&]() {
+        result = finder.find();
+    });
+    cache.save(cache_filepath);
+    if(!error_message.isEmpty())
+    {
+        Application::instance().showErrorMessage(error_message);
+        return;
+    }
+    QStringList lines;
+    quint64 reclaimable_size = 0;
+    for(const DuplicateGroup & group : result.groups)
+    {
+        QStringList titles;
+        for(const DuplicateImage & image : group.images)
+            titles.append(QString("%1 (%2)").arg(image.game->title()).arg(image.game->id()));
+        lines.append((group.isIdentical() ? tr("Identical: %1") : tr("Same content: %1")).arg(titles.join(", ")));
+        reclaimable_size += group.reclaimableSize();
+    }
+    QString message = result.groups.isEmpty() ?
+        tr("No duplicates found") :
+        tr("%1\n\nReclaimable size: %2 MiB").arg(lines.join("\n")).arg(reclaimable_size / 1048576);
+    if(!result.errors.isEmpty())
+        message += "\n" + tr("Unreadable images: %1").arg(result.errors.count());
+    Application::instance().showMessage(tr("Find Duplicates"), message);
+}
+
+void GameCollectionActivity::verifyLibrary()
+{
+    GameCollection & collection = Application::instance().gameCollection();
+    if(!collection.isLoaded())
+        return;
+    QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Verify Library"),
+        tr("Read the whole images and compare their checksums with the previous ones?\n"
+           "It takes as long as copying the library, otherwise only the structure of the games is checked."),
+        QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::No);
+    if(answer == QMessageBox::Cancel)
+        return;
+    const bool is_full_read_enabled = answer == QMessageBox::Yes;
+    const QString cache_filepath = ImageHashCache::filepath(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation), collection.directory());
+    ImageHashCache cache;
+    LibraryVerifier verifier(collection.directory());
+    if(is_full_read_enabled)
+    {
+        cache.load(cache_filepath);
+        verifier.setFullReadEnabled(true);
+        verifier.setChecksumCache(&cache);
+    }
+    mp_model->clearIntegrityIssues();
+    // The results are queued to the model and shown in the list while the other games are being checked
+    connect(&verifier, &LibraryVerifier::gameVerified, mp_model, &GameTreeModel::setIntegrityIssues);
+    LibraryVerificationResult result;
+    QString error_message = runWithProgressDialog(this, tr("Verifying library..."), verifier, [&]() {
+        result = verifier.verify(*collection.games());
+    });
+    if(is_full_read_enabled)
+        cache.save(cache_filepath);
+    if(!error_message.isEmpty())
+    {
+        Application::instance().showErrorMessage(error_message);
+        return;
+    }
+    QStringList titles;
+    for(const GameIntegrityReport & report : result.reports)
+    {
+        if(!report.issues.isEmpty())
+            titles.append(QString("%1 (%2)").arg(report.game->title()).arg(report.game->id()));
+    }
+    QString message = tr("Games verified: %1\nBroken games: %2").arg(result.verified).arg(result.broken);
+    if(!titles.isEmpty())
+        message += "\n\n" + titles.join("\n");
+    Application::instance().showMessage(tr("Verify Library"), message);
 }
 
 void GameCollectionActivity::renameGame()
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game)
     {
         GameRenameDialog dlg(game->title(), game->installationType(), this);
@@ -458,7 +1218,7 @@ void GameCollectionActivity::renameGame()
 
 void GameCollectionActivity::showGameDetails()
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game)
     {
         QSharedPointer<Intent> intent = GameDetailsActivity::createIntent(*mp_game_art_manager, game->id());
@@ -468,7 +1228,7 @@ void GameCollectionActivity::showGameDetails()
 
 void GameCollectionActivity::showIsoRestorer()
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(game && game->installationType() == GameInstallationType::UlConfig)
     {
         QSharedPointer<Intent> intent = IsoRestorerActivity::createIntent(game->id());
@@ -484,7 +1244,7 @@ void GameCollectionActivity::showGameInstaller()
 
 void GameCollectionActivity::deleteGame()
 {
-    const Game * game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
+    const QSharedPointer<const Game> game = mp_model->game(mp_proxy_model->mapToSource(mp_tree_games->currentIndex()));
     if(!game) return;
     const QString id = game->id();
     Settings & settings = Settings::instance();
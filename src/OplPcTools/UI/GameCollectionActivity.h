@@ -25,6 +25,7 @@
 #include <QWidget>
 #include <QMenu>
 #include <QSortFilterProxyModel>
+#include <QTimer>
 #include <OplPcTools/Game.h>
 #include <OplPcTools/GameArtManager.h>
 #include <OplPcTools/UI/Intent.h>
@@ -36,6 +37,8 @@ namespace UI {
 class GameCollectionActivity : public Activity, private Ui::GameCollectionActivity
 {
     class GameTreeModel;
+    class GameFilterModel;
+    class GameItemDelegate;
 
     Q_OBJECT
 
@@ -52,27 +55,42 @@ private:
     void activateCollectionControls(bool _activate);
     void activateItemControls(const Game * _selected_game);
     void changeIconsSize();
+    void showCoverGrid(bool _show);
     void showTreeContextMenu(const QPoint & _point);
     void load();
     void loadDirectory(const QDir & _directory);
+    bool restoreDirectory(const QDir & _directory);
+    void revalidateCollection();
+    void setupArtManager(const QDir & _directory);
+    void saveSnapshot();
     void reload();
     void renameGame();
     void showGameDetails();
     void showGameInstaller();
     void deleteGame();
+    void collectionLoadingStarted();
+    void collectionGamesLoaded(int _count);
+    void collectionLoadingFailed(const QString & _message);
     void collectionLoaded();
     void gameAdded(const QString & _id);
     void gameRenamed(const QString & _id);
     void gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap);
+    void gameArtsReloaded(const QStringList & _game_ids);
     void gameSelected();
+    void importArts();
+    void optimizeArts();
+    void findDuplicates();
+    void verifyLibrary();
     void showIsoRestorer();
 
 private:
     OplPcTools::GameArtManager * mp_game_art_manager;
     GameTreeModel * mp_model;
     QMenu * mp_context_menu;
-    QSortFilterProxyModel * mp_proxy_model;
+    GameFilterModel * mp_proxy_model;
     QPixmap m_default_cover;
+    QTimer * mp_snapshot_timer;
+    bool m_is_revalidating;
 };
 
 } // namespace UI
@@ -0,0 +1,262 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#include <algorithm>
+#include <QApplication>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyledItemDelegate>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/UI/GameCoverGridView.h>
+
+using namespace OplPcTools;
+using namespace OplPcTools::UI;
+
+namespace {
+
+const QSize g_cover_size(105, 150);
+const int g_tile_margin = 6;
+const int g_min_tile_count = 64;
+const int g_max_tile_count = 1024;
+const int g_tile_pool_screens = 3;
+const int g_prefetch_screens = 2;
+const int g_prefetch_delay = 50;
+
+inline QSize tileSize(const QSize & _cover_size, const QFontMetrics & _font_metrics)
+{
+    return QSize(_cover_size.width() + 2 * g_tile_margin, _cover_size.height() + _font_metrics.height() + 3 * g_tile_margin);
+}
+
+class CoverTileDelegate : public QStyledItemDelegate
+{
+public:
+    explicit CoverTileDelegate(GameCoverGridView * _view) :
+        QStyledItemDelegate(_view),
+        mp_view(_view)
+    {
+    }
+
+    void paint(QPainter * _painter, const QStyleOptionViewItem & _option, const QModelIndex & _index) const override;
+    QSize sizeHint(const QStyleOptionViewItem & _option, const QModelIndex & _index) const override;
+
+private:
+    GameCoverGridView * mp_view;
+};
+
+} // namespace
+
+void CoverTileDelegate::paint(QPainter * _painter, const QStyleOptionViewItem & _option, const QModelIndex & _index) const
+{
+    const QWidget * widget = _option.widget;
+    QStyle * style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &_option, _painter, widget);
+    const QSize & cover_size = mp_view->coverSize();
+    const QPixmap tile = mp_view->tile(_index.data(GameCoverGridView::game_id_role).toString());
+    QRect cover_rect(QPoint(), tile.size());
+    cover_rect.moveCenter(QPoint(_option.rect.center().x(), _option.rect.top() + g_tile_margin + cover_size.height() / 2));
+    _painter->drawPixmap(cover_rect, tile);
+    const QRect text_rect(_option.rect.left() + g_tile_margin, _option.rect.top() + cover_size.height() + 2 * g_tile_margin,
+        _option.rect.width() - 2 * g_tile_margin, _option.fontMetrics.height());
+    QPalette::ColorGroup color_group = QPalette::Disabled;
+    if(_option.state & QStyle::State_Enabled)
+        color_group = _option.state & QStyle::State_Active ? QPalette::Normal : QPalette::Inactive;
+    _painter->setPen(_option.palette.color(color_group,
+        _option.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+    _painter->drawText(text_rect, Qt::AlignHCenter | Qt::AlignTop | Qt::TextSingleLine,
+        _option.fontMetrics.elidedText(_index.data(Qt::DisplayRole).toString(), Qt::ElideRight, text_rect.width()));
+}
+
+QSize CoverTileDelegate::sizeHint(const QStyleOptionViewItem & _option, const QModelIndex & _index) const
+{
+    Q_UNUSED(_index)
+    return tileSize(mp_view->coverSize(), _option.fontMetrics);
+}
+
+GameCoverGridView::GameCoverGridView(QWidget * _parent /*= nullptr*/) :
+    QListView(_parent),
+    m_cover_size(g_cover_size),
+    mp_art_manager(nullptr),
+    m_paint_stamp(0),
+    m_max_tile_count(g_min_tile_count),
+    m_scroll_direction(1),
+    mp_prefetch_timer(new QTimer(this))
+{
+    m_default_cover = QPixmap(":/images/no-image").scaled(m_cover_size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    setViewMode(QListView::IconMode);
+    setMovement(QListView::Static);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(true);
+    setWrapping(true);
+    setSpacing(g_tile_margin);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setItemDelegate(new CoverTileDelegate(this));
+    mp_prefetch_timer->setSingleShot(true);
+    mp_prefetch_timer->setInterval(g_prefetch_delay);
+    connect(mp_prefetch_timer, &QTimer::timeout, this, &GameCoverGridView::prefetch);
+}
+
+void GameCoverGridView::setArtManager(GameArtManager * _manager)
+{
+    if(mp_art_manager)
+    {
+        disconnect(mp_art_manager, &GameArtManager::artChanged, this, &GameCoverGridView::gameArtChanged);
+        disconnect(mp_art_manager, &GameArtManager::artsReloaded, this, &GameCoverGridView::gameArtsReloaded);
+    }
+    mp_art_manager = _manager;
+    clearTiles();
+    if(mp_art_manager)
+    {
+        connect(mp_art_manager, &GameArtManager::artChanged, this, &GameCoverGridView::gameArtChanged);
+        connect(mp_art_manager, &GameArtManager::artsReloaded, this, &GameCoverGridView::gameArtsReloaded);
+    }
+    viewport()->update();
+}
+
+// Returns the tile of the game cover, or the placeholder while the cover is being decoded
+QPixmap GameCoverGridView::tile(const QString & _game_id)
+{
+    auto slot_it = m_tile_slots.constFind(_game_id);
+    if(slot_it != m_tile_slots.cend())
+    {
+        m_tile_stamps[slot_it.value()] = ++m_paint_stamp;
+        return m_tiles[slot_it.value()];
+    }
+    if(!mp_art_manager)
+        return m_default_cover;
+    const QPixmap cover = mp_art_manager->requestArt(_game_id, GameArtType::Front);
+    if(cover.isNull())
+        return m_default_cover;
+    int slot;
+    if(m_tiles.count() < m_max_tile_count)
+    {
+        slot = m_tiles.count();
+        m_tiles.append(QPixmap(m_cover_size));
+        m_tile_owners.append(QString());
+        m_tile_stamps.append(0);
+    }
+    else
+    {
+        slot = std::min_element(m_tile_stamps.cbegin(), m_tile_stamps.cend()) - m_tile_stamps.cbegin();
+        m_tile_slots.remove(m_tile_owners[slot]);
+    }
+    OPT_TRACE_SCOPE("GameCoverGridView::tile");
+    QPixmap & tile = m_tiles[slot];
+    tile.fill(Qt::transparent);
+    QSize scaled_size = cover.size().scaled(m_cover_size, Qt::KeepAspectRatio);
+    QRect target(QPoint(), scaled_size);
+    target.moveCenter(tile.rect().center());
+    QPainter painter(&tile);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(target, cover);
+    painter.end();
+    m_tile_owners[slot] = _game_id;
+    m_tile_stamps[slot] = ++m_paint_stamp;
+    m_tile_slots.insert(_game_id, slot);
+    return tile;
+}
+
+void GameCoverGridView::releaseTile(const QString & _game_id)
+{
+    auto slot_it = m_tile_slots.find(_game_id);
+    if(slot_it == m_tile_slots.end())
+        return;
+    m_tile_owners[slot_it.value()].clear();
+    m_tile_stamps[slot_it.value()] = 0;
+    m_tile_slots.erase(slot_it);
+}
+
+void GameCoverGridView::clearTiles()
+{
+    m_tiles.clear();
+    m_tile_owners.clear();
+    m_tile_stamps.clear();
+    m_tile_slots.clear();
+}
+
+void GameCoverGridView::gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap)
+{
+    Q_UNUSED(_pixmap)
+    if(_type != GameArtType::Front)
+        return;
+    releaseTile(_game_id);
+    viewport()->update();
+}
+
+void GameCoverGridView::gameArtsReloaded()
+{
+    clearTiles();
+    viewport()->update();
+}
+
+void GameCoverGridView::resizeEvent(QResizeEvent * _event)
+{
+    QListView::resizeEvent(_event);
+    updateTilePoolSize();
+}
+
+// The pool holds a few screens of tiles, the tiles above the limit are dropped
+void GameCoverGridView::updateTilePoolSize()
+{
+    m_max_tile_count = qBound(g_min_tile_count, visibleTileCount() * g_tile_pool_screens, g_max_tile_count);
+    if(m_tiles.count() > m_max_tile_count)
+        clearTiles();
+}
+
+int GameCoverGridView::visibleTileCount() const
+{
+    const QSize tile_size = tileSize(m_cover_size, fontMetrics()) + QSize(spacing(), spacing());
+    const QSize viewport_size = viewport()->size();
+    return (viewport_size.width() / tile_size.width() + 1) * (viewport_size.height() / tile_size.height() + 1);
+}
+
+void GameCoverGridView::scrollContentsBy(int _dx, int _dy)
+{
+    QListView::scrollContentsBy(_dx, _dy);
+    if(_dy != 0)
+    {
+        // The contents move up while the view is scrolled down
+        m_scroll_direction = _dy < 0 ? 1 : -1;
+        mp_prefetch_timer->start();
+    }
+}
+
+// Requests the covers of the tiles that come into the view next, the worker pool decodes them meanwhile
+void GameCoverGridView::prefetch()
+{
+    if(!mp_art_manager || !model())
+        return;
+    OPT_TRACE_SCOPE("GameCoverGridView::prefetch");
+    const QRect viewport_rect = viewport()->rect();
+    const QModelIndex edge_index = m_scroll_direction > 0 ?
+        indexAt(QPoint(viewport_rect.right() - spacing(), viewport_rect.bottom() - spacing())) :
+        indexAt(QPoint(spacing(), spacing()));
+    if(!edge_index.isValid())
+        return;
+    const int count = visibleTileCount() * g_prefetch_screens;
+    const int row_count = model()->rowCount();
+    for(int i = 1; i <= count; ++i)
+    {
+        const int row = edge_index.row() + i * m_scroll_direction;
+        if(row < 0 || row >= row_count)
+            break;
+        const QString id = model()->index(row, 0).data(game_id_role).toString();
+        if(!m_tile_slots.contains(id))
+            mp_art_manager->requestArt(id, GameArtType::Front);
+    }
+}
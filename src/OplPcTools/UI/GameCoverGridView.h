@@ -0,0 +1,86 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_GAMECOVERGRIDVIEW__
+#define __OPLPCTOOLS_GAMECOVERGRIDVIEW__
+
+#include <QListView>
+#include <QHash>
+#include <QVector>
+#include <QPixmap>
+#include <QTimer>
+#include <OplPcTools/GameArtManager.h>
+
+namespace OplPcTools {
+namespace UI {
+
+/*
+ * Grid of the game covers over the game list model, which provides the game ID by the game_id_role.
+ * Only the covers of the painted tiles are requested, plus a couple of screens ahead in the scrolling direction,
+ * which are decoded by the worker pool of the GameArtManager. The covers are drawn into a fixed pool of
+ * tile-sized pixmaps, the least recently painted tile is reused for a new one.
+ */
+class GameCoverGridView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit GameCoverGridView(QWidget * _parent = nullptr);
+    void setArtManager(GameArtManager * _manager);
+    const QSize & coverSize() const;
+    QPixmap tile(const QString & _game_id);
+
+public:
+    static const int game_id_role = Qt::UserRole;
+
+protected:
+    void scrollContentsBy(int _dx, int _dy) override;
+    void resizeEvent(QResizeEvent * _event) override;
+
+private:
+    void gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap);
+    void gameArtsReloaded();
+    void releaseTile(const QString & _game_id);
+    void clearTiles();
+    void updateTilePoolSize();
+    int visibleTileCount() const;
+    void prefetch();
+
+private:
+    const QSize m_cover_size;
+    QPixmap m_default_cover;
+    GameArtManager * mp_art_manager;
+    QVector<QPixmap> m_tiles;
+    QVector<QString> m_tile_owners;
+    QVector<quint64> m_tile_stamps;
+    QHash<QString, int> m_tile_slots;
+    quint64 m_paint_stamp;
+    int m_max_tile_count;
+    int m_scroll_direction;
+    QTimer * mp_prefetch_timer;
+};
+
+inline const QSize & GameCoverGridView::coverSize() const
+{
+    return m_cover_size;
+}
+
+} // namespace UI
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_GAMECOVERGRIDVIEW__
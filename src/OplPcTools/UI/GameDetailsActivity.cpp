@@ -131,7 +131,6 @@ QVariant ArtListItem::data(int _role) const
 GameDetailsActivity::GameDetailsActivity(OplPcTools::GameArtManager & _art_manager, QWidget * _parent /*= nullptr*/) :
     Activity(_parent),
     mr_art_manager(_art_manager),
-    mp_game(nullptr),
     mp_item_context_menu(nullptr)
 {
     setupUi(this);
@@ -146,6 +145,8 @@ GameDetailsActivity::GameDetailsActivity(OplPcTools::GameArtManager & _art_manag
     connect(mp_action_change_art, &QAction::triggered, this, &GameDetailsActivity::changeGameArt);
     connect(mp_action_delete_art, &QAction::triggered, this, &GameDetailsActivity::deleteGameArt);
     connect(mp_label_title, &ClickableLabel::clicked, this, &GameDetailsActivity::renameGame);
+    connect(&mr_art_manager, &GameArtManager::artChanged, this, &GameDetailsActivity::gameArtChanged);
+    connect(&mr_art_manager, &GameArtManager::artsReloaded, this, &GameDetailsActivity::gameArtsReloaded);
 }
 
 QSharedPointer<Intent> GameDetailsActivity::createIntent(OplPcTools::GameArtManager & _art_manager, const QString & _game_id)
@@ -171,14 +172,15 @@ void GameDetailsActivity::setupShortcuts()
 
 void GameDetailsActivity::renameGame()
 {
-    if(mp_game == nullptr) return;
-    GameRenameDialog dlg(mp_game->title(), mp_game->installationType(), this);
+    if(!m_game_ptr) return;
+    GameRenameDialog dlg(m_game_ptr->title(), m_game_ptr->installationType(), this);
     if(dlg.exec() != QDialog::Accepted)
         return;
     try
     {
-        Application::instance().gameCollection().renameGame(*mp_game, dlg.name());
-        mp_label_title->setText(dlg.name());
+        Application::instance().gameCollection().renameGame(*m_game_ptr, dlg.name());
+        m_game_ptr = Application::instance().gameCollection().game(m_game_ptr->id());
+        mp_label_title->setText(m_game_ptr ? m_game_ptr->title() : dlg.name());
     }
     catch(const Exception & exception)
     {
@@ -220,7 +222,7 @@ void GameDetailsActivity::changeGameArt()
         if(filename.isEmpty())
             return;
         settings.setValue(g_settings_key_cover_dir, QFileInfo(filename).absoluteDir().absolutePath());
-        QPixmap pixmap = mr_art_manager.setArt(mp_game->id(), item->type(), filename);
+        QPixmap pixmap = mr_art_manager.setArt(m_game_ptr->id(), item->type(), filename);
         item->setPixmap(pixmap);
         mp_list_arts->doItemsLayout();
     }
@@ -254,7 +256,7 @@ void GameDetailsActivity::deleteGameArt()
             if(checkbox->isChecked())
                 settings.setFlag(Settings::Flag::ConfirmPixmapDeletion, false);
         }
-        mr_art_manager.deleteArt(mp_game->id(), item->type());
+        mr_art_manager.deleteArt(m_game_ptr->id(), item->type());
         item->setPixmap(QPixmap());
         mp_list_arts->doItemsLayout();
     }
@@ -270,18 +272,18 @@ void GameDetailsActivity::deleteGameArt()
 
 void GameDetailsActivity::setGameId(const QString & _id)
 {
-    mp_game = Application::instance().gameCollection().findGame(_id);
+    m_game_ptr = Application::instance().gameCollection().game(_id);
     initGameControls();
 }
 
 void GameDetailsActivity::initGameControls()
 {
-    if(mp_game == nullptr)
+    if(!m_game_ptr)
     {
         clearGameControls();
         return;
     }
-    mp_label_title->setText(mp_game->title());
+    mp_label_title->setText(m_game_ptr->title());
     mp_list_arts->clear();
     addArtListItem(GameArtType::Icon, tr("Icon"));
     addArtListItem(GameArtType::Front, tr("Front Cover"));
@@ -295,7 +297,37 @@ void GameDetailsActivity::initGameControls()
 
 void GameDetailsActivity::addArtListItem(GameArtType _type, const QString & _text)
 {
-    mp_list_arts->addItem(new ArtListItem(_type, _text, mr_art_manager.load(mp_game->id(), _type)));
+    mp_list_arts->addItem(new ArtListItem(_type, _text, mr_art_manager.requestArt(m_game_ptr->id(), _type)));
+}
+
+void GameDetailsActivity::gameArtsReloaded(const QStringList & _game_ids)
+{
+    if(!m_game_ptr || !_game_ids.contains(m_game_ptr->id()))
+        return;
+    int count = mp_list_arts->count();
+    for(int i = 0; i < count; ++i)
+    {
+        ArtListItem * item = static_cast<ArtListItem *>(mp_list_arts->item(i));
+        item->setPixmap(mr_art_manager.requestArt(m_game_ptr->id(), item->type()));
+    }
+    mp_list_arts->doItemsLayout();
+}
+
+void GameDetailsActivity::gameArtChanged(const QString & _game_id, GameArtType _type, const QPixmap * _pixmap)
+{
+    if(!m_game_ptr || m_game_ptr->id() != _game_id)
+        return;
+    int count = mp_list_arts->count();
+    for(int i = 0; i < count; ++i)
+    {
+        ArtListItem * item = static_cast<ArtListItem *>(mp_list_arts->item(i));
+        if(item->type() == _type)
+        {
+            item->setPixmap(_pixmap ? *_pixmap : QPixmap());
+            mp_list_arts->doItemsLayout();
+            return;
+        }
+    }
 }
 
 void GameDetailsActivity::clearGameControls()
@@ -52,10 +52,12 @@ private slots:
     void showItemContextMenu(const QPoint & _point);
     void changeGameArt();
     void deleteGameArt();
+    void gameArtChanged(const QString & _game_id, OplPcTools::GameArtType _type, const QPixmap * _pixmap);
+    void gameArtsReloaded(const QStringList & _game_ids);
 
 private:
     OplPcTools::GameArtManager & mr_art_manager;
-    const OplPcTools::Game * mp_game;
+    QSharedPointer<const OplPcTools::Game> m_game_ptr;
     QMenu * mp_item_context_menu;
 };
 
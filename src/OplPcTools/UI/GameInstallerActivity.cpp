@@ -23,17 +23,21 @@
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QMimeData>
+#include <QMessageBox>
 #include <OplPcTools/Device.h>
-#include <OplPcTools/Iso9660DeviceSource.h>
-#include <OplPcTools/BinCueDeviceSource.h>
-#include <OplPcTools/NrgDeviceSource.h>
+#include <OplPcTools/DeviceSourceFactory.h>
+#include <OplPcTools/DummyStrippingDeviceSource.h>
 #include <OplPcTools/OpticalDriveDeviceSource.h>
 #include <OplPcTools/Settings.h>
+#include <OplPcTools/StorageDevice.h>
 #include <OplPcTools/UlConfigGameInstaller.h>
 #include <OplPcTools/DirectoryGameInstaller.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/TransferJournal.h>
 #include <OplPcTools/UI/Application.h>
 #include <OplPcTools/UI/ChooseOpticalDiscDialog.h>
 #include <OplPcTools/UI/GameRenameDialog.h>
+#include <OplPcTools/UI/DummyFilesDialog.h>
 #include <OplPcTools/UI/GameInstallerActivity.h>
 
 using namespace OplPcTools;
@@ -54,6 +58,9 @@ enum
 } // namespace Column
 
 const int g_progressbar_max_value = 1000;
+const int g_max_concurrent_tasks = 4;
+const int g_progress_sampling_interval = 250;
+const quint64 g_mebibyte = 1048576;
 const char * g_iso_ext = ".iso";
 const char * g_bin_ext = ".bin";
 const char * g_nrg_ext = ".nrg";
@@ -65,7 +72,8 @@ enum class GameInstallationStatus
     Registration,
     Done,
     Error,
-    RollingBack
+    RollingBack,
+    Suspended
 };
 
 class GameInstallerActivityIntent : public Intent
@@ -83,13 +91,20 @@ public:
     TaskListItem(QSharedPointer<Device> _device, QTreeWidget * _widget);
     QVariant data(int _column, int _role) const;
     inline Device & device();
+    void setDevice(QSharedPointer<Device> _device);
     void rename(const QString & _new_name);
     void setStatus(GameInstallationStatus _status);
     void setError(const QString & _message);
+    void setSuspended(const QString & _journal_filepath);
     inline GameInstallationStatus status() const;
+    inline const QString & journalFilepath() const;
+    void discardSuspendedData();
     inline const QString & errorMessage() const;
     inline void setProgress(int _progress);
     inline int progress() const;
+    inline void setProgressText(const QString & _text);
+    inline const QString & progressText() const;
+    inline TransferStatistics & statistics();
     inline void setMediaType(MediaType _media_type);
     inline bool isSplittingUpEnabled() const;
     inline void enabelSplittingUp(bool _enable);
@@ -97,15 +112,31 @@ public:
     inline void enabelRenaming(bool _enable);
     inline bool isMovingEnabled() const;
     inline void enabelMoving(bool _enable);
+    inline const IoPolicy & ioPolicy() const;
+    inline void setIoPolicy(const IoPolicy & _policy);
+    inline void setStorageDeviceIds(const QString & _source_id, const QString & _destination_id);
+    inline const QString & sourceStorageDeviceId() const;
+    inline const QString & destinationStorageDeviceId() const;
+    inline void setWorker(JobPointer _job, GameInstaller * _installer);
+    inline const JobPointer & job() const;
+    inline GameInstaller * installer() const;
 
 private:
     QSharedPointer<Device> m_device_ptr;
     GameInstallationStatus m_status;
     int m_progress;
+    QString m_progress_text;
+    TransferStatistics m_statistics;
     QString m_error_message;
+    QString m_journal_filepath; // Checkpoint of the suspended installation
     bool m_is_splitting_up_enabled;
     bool m_is_renaming_enabled;
     bool m_is_moving_enabled;
+    IoPolicy m_io_policy;
+    QString m_source_storage_device_id;
+    QString m_destination_storage_device_id;
+    JobPointer m_job_ptr;
+    GameInstaller * mp_installer;
 };
 
 class TaskListViewDelegate : public QStyledItemDelegate
@@ -123,18 +154,27 @@ private:
     QTreeWidget * mp_tree;
 };
 
+bool areTasksConflicting(const TaskListItem & _task1, const TaskListItem & _task2)
+{
+    return areTransfersConflicting(_task1.sourceStorageDeviceId(), _task1.destinationStorageDeviceId(),
+        _task2.sourceStorageDeviceId(), _task2.destinationStorageDeviceId());
+}
+
 } // namespace
 
 TaskListItem::TaskListItem(QSharedPointer<Device> _device, QTreeWidget * _widget) :
     QTreeWidgetItem(_widget, QTreeWidgetItem::UserType),
     m_device_ptr(_device),
     m_status(GameInstallationStatus::Queued),
-    m_progress(0)
+    m_progress(0),
+    mp_installer(nullptr)
 {
     const Settings & settings = Settings::instance();
     m_is_splitting_up_enabled = settings.flag(Settings::Flag::SplitUpIso);
     m_is_renaming_enabled = settings.flag(Settings::Flag::RenameIso);
     m_is_moving_enabled = settings.flag(Settings::Flag::MoveIso) && !_device->isReadOnly();
+    _device->enableTrimming(settings.flag(Settings::Flag::TrimIso));
+    m_io_policy = settings.ioPolicy();
 }
 
 QVariant TaskListItem::data(int _column, int _role) const
@@ -155,6 +195,8 @@ QVariant TaskListItem::data(int _column, int _role) const
         return QObject::tr("Registration...");
     case GameInstallationStatus::RollingBack:
         return QObject::tr("Rolling back...");
+    case GameInstallationStatus::Suspended:
+        return QObject::tr("Suspended");
     }
     return QVariant();
 }
@@ -164,6 +206,14 @@ Device & TaskListItem::device()
     return *m_device_ptr;
 }
 
+void TaskListItem::setDevice(QSharedPointer<Device> _device)
+{
+    m_device_ptr = _device;
+    if(_device->isReadOnly())
+        m_is_moving_enabled = false;
+    emitDataChanged();
+}
+
 void TaskListItem::rename(const QString & _new_name)
 {
     m_device_ptr->setTitle(_new_name);
@@ -184,11 +234,33 @@ void TaskListItem::setError(const QString & _message)
     emitDataChanged();
 }
 
+// The written data is kept, installing the same image again continues from the checkpoint
+void TaskListItem::setSuspended(const QString & _journal_filepath)
+{
+    m_status = GameInstallationStatus::Suspended;
+    m_error_message = QString();
+    m_journal_filepath = _journal_filepath;
+    emitDataChanged();
+}
+
 GameInstallationStatus TaskListItem::status() const
 {
     return m_status;
 }
 
+const QString & TaskListItem::journalFilepath() const
+{
+    return m_journal_filepath;
+}
+
+void TaskListItem::discardSuspendedData()
+{
+    if(m_journal_filepath.isEmpty())
+        return;
+    TransferJournal::discard(m_journal_filepath);
+    m_journal_filepath.clear();
+}
+
 const QString & TaskListItem::errorMessage() const
 {
     return m_error_message;
@@ -208,6 +280,25 @@ int TaskListItem::progress() const
     return m_progress;
 }
 
+void TaskListItem::setProgressText(const QString & _text)
+{
+    if(m_progress_text != _text)
+    {
+        m_progress_text = _text;
+        emitDataChanged();
+    }
+}
+
+const QString & TaskListItem::progressText() const
+{
+    return m_progress_text;
+}
+
+TransferStatistics & TaskListItem::statistics()
+{
+    return m_statistics;
+}
+
 void TaskListItem::setMediaType(MediaType _media_type)
 {
     m_device_ptr->setMediaType(_media_type);
@@ -243,6 +334,48 @@ void TaskListItem::enabelMoving(bool _enable)
     m_is_moving_enabled = _enable;
 }
 
+const IoPolicy & TaskListItem::ioPolicy() const
+{
+    return m_io_policy;
+}
+
+void TaskListItem::setIoPolicy(const IoPolicy & _policy)
+{
+    m_io_policy = _policy;
+}
+
+void TaskListItem::setStorageDeviceIds(const QString & _source_id, const QString & _destination_id)
+{
+    m_source_storage_device_id = _source_id;
+    m_destination_storage_device_id = _destination_id;
+}
+
+const QString & TaskListItem::sourceStorageDeviceId() const
+{
+    return m_source_storage_device_id;
+}
+
+const QString & TaskListItem::destinationStorageDeviceId() const
+{
+    return m_destination_storage_device_id;
+}
+
+void TaskListItem::setWorker(JobPointer _job, GameInstaller * _installer)
+{
+    m_job_ptr = _job;
+    mp_installer = _installer;
+}
+
+const JobPointer & TaskListItem::job() const
+{
+    return m_job_ptr;
+}
+
+GameInstaller * TaskListItem::installer() const
+{
+    return mp_installer;
+}
+
 void TaskListViewDelegate::paint(QPainter * _painter, const QStyleOptionViewItem & _option, const QModelIndex & _index ) const
 {
     QStyledItemDelegate::paint(_painter, _option, _index);
@@ -260,6 +393,8 @@ void TaskListViewDelegate::paint(QPainter * _painter, const QStyleOptionViewItem
     progress_bar_option.textVisible = true;
     progress_bar_option.progress = item->progress();
     progress_bar_option.text = QString::asprintf("%d%%", progress_bar_option.progress / (g_progressbar_max_value / 100));
+    if(!item->progressText().isEmpty())
+        progress_bar_option.text += " " + item->progressText();
     QStyleOption progress_indicator_option;
     progress_indicator_option.state = QStyle::State_Enabled;
     progress_indicator_option.direction = _option.direction;
@@ -273,9 +408,8 @@ void TaskListViewDelegate::paint(QPainter * _painter, const QStyleOptionViewItem
 
 GameInstallerActivity::GameInstallerActivity(QWidget * _parent /*= nullptr*/) :
     Activity(_parent),
-    mp_working_thread(nullptr),
-    mp_installer(nullptr),
-    m_processing_task_index(0),
+    mp_progress_timer(nullptr),
+    m_is_installing(false),
     m_is_canceled(false)
 {
     setupUi(this);
@@ -284,6 +418,9 @@ GameInstallerActivity::GameInstallerActivity(QWidget * _parent /*= nullptr*/) :
     mp_tree_tasks->setItemDelegate(new TaskListViewDelegate(mp_tree_tasks));
     mp_btn_cancel->setDisabled(true);
     mp_btn_install->setDisabled(true);
+    mp_progress_timer = new QTimer(this);
+    mp_progress_timer->setInterval(g_progress_sampling_interval);
+    connect(mp_progress_timer, &QTimer::timeout, this, &GameInstallerActivity::sampleProgress);
     connect(mp_btn_back, &QPushButton::clicked, this, &GameInstallerActivity::close);
     connect(mp_tree_tasks, &QTreeWidget::itemSelectionChanged, this, &GameInstallerActivity::taskSelectionChanged);
     connect(mp_btn_add_image, &QPushButton::clicked, [this]() { addDiscImage(); });
@@ -296,6 +433,10 @@ GameInstallerActivity::GameInstallerActivity(QWidget * _parent /*= nullptr*/) :
     connect(mp_radio_mtcd, &QRadioButton::clicked, this, &GameInstallerActivity::mediaTypeChanged);
     connect(mp_checkbox_move, &QCheckBox::clicked, this, &GameInstallerActivity::moveOptionChanged);
     connect(mp_checkbox_rename, &QCheckBox::clicked, this, &GameInstallerActivity::renameOptionChanged);
+    connect(mp_checkbox_trim, &QCheckBox::clicked, this, &GameInstallerActivity::trimOptionChanged);
+    connect(mp_btn_dummy_files, &QPushButton::clicked, this, &GameInstallerActivity::chooseDummyFiles);
+    connect(mp_checkbox_idle_io, &QCheckBox::clicked, this, &GameInstallerActivity::ioPolicyChanged);
+    connect(mp_spinbox_bandwidth_limit, &QSpinBox::editingFinished, this, &GameInstallerActivity::ioPolicyChanged);
     connect(mp_radio_split_up, &QRadioButton::clicked, this, &GameInstallerActivity::splitUpOptionChanged);
     connect(mp_radio_dnot_split_up, &QRadioButton::clicked, this, &GameInstallerActivity::splitUpOptionChanged);
     connect(mp_btn_install, &QPushButton::clicked, this, &GameInstallerActivity::install);
@@ -321,8 +462,30 @@ void GameInstallerActivity::setupShortcuts()
 
 void GameInstallerActivity::close()
 {
-    if(mp_btn_back->isEnabled())
-        deleteLater();
+    if(!mp_btn_back->isEnabled())
+        return;
+    QList<TaskListItem *> suspended_tasks;
+    for(int i = 0; i < mp_tree_tasks->topLevelItemCount(); ++i)
+    {
+        TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i));
+        if(!item->journalFilepath().isEmpty())
+            suspended_tasks.append(item);
+    }
+    if(!suspended_tasks.isEmpty())
+    {
+        QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Suspended Installations"),
+            tr("Some installations have been interrupted.\n"
+               "Keep the written data to continue them when the images are installed again?"),
+            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::Yes);
+        if(answer == QMessageBox::Cancel)
+            return;
+        if(answer == QMessageBox::No)
+        {
+            for(TaskListItem * item : suspended_tasks)
+                item->discardSuspendedData();
+        }
+    }
+    deleteLater();
 }
 
 QSharedPointer<Intent> GameInstallerActivity::createIntent()
@@ -343,6 +506,8 @@ void GameInstallerActivity::taskSelectionChanged()
     mp_widget_task_details->show();
     if(item->status() == GameInstallationStatus::Error)
         mp_label_error_message->setText(item->errorMessage());
+    else if(item->status() == GameInstallationStatus::Suspended)
+        mp_label_error_message->setText(suspendedMessage());
     else
         mp_label_error_message->clear();
     mp_label_title->setText(item->device().title());
@@ -365,6 +530,10 @@ void GameInstallerActivity::taskSelectionChanged()
     mp_checkbox_rename->setChecked(item->isRenamingEnabled());
     mp_checkbox_move->setDisabled(split_up || item->device().isReadOnly());
     mp_checkbox_rename->setDisabled(split_up);
+    mp_checkbox_trim->setChecked(item->device().isTrimmingEnabled());
+    mp_checkbox_trim->setEnabled(item->device().usedSize() < item->device().declaredSize());
+    mp_checkbox_idle_io->setChecked(item->ioPolicy().io_class == IoClass::Idle);
+    mp_spinbox_bandwidth_limit->setValue(static_cast<int>(item->ioPolicy().bandwidth_limit / g_mebibyte));
 }
 
 void GameInstallerActivity::addDiscImage()
@@ -394,15 +563,9 @@ void GameInstallerActivity::addDiscImage(const QString & _file_path)
         mp_tree_tasks->setCurrentItem(existingTask);
         return;
     }
-    DeviceSource * source = nullptr;
-    if(_file_path.endsWith(g_iso_ext))
-        source = new Iso9660DeviceSource(_file_path);
-    else if(_file_path.endsWith(g_bin_ext))
-        source = new BinCueDeviceSource(_file_path);
-    else if(_file_path.endsWith(g_nrg_ext))
-        source = new NrgDeviceSource(_file_path);
-    QSharedPointer<Device> device(new Device(QSharedPointer<DeviceSource>(source)));
-    if(device->init())
+    QSharedPointer<DeviceSource> source = createDeviceSource(_file_path);
+    QSharedPointer<Device> device(source ? new Device(source) : nullptr);
+    if(device && device->init())
     {
         device->setTitle(file_info.completeBaseName());
         TaskListItem * item = new TaskListItem(device, mp_tree_tasks);
@@ -429,7 +592,7 @@ QTreeWidgetItem * GameInstallerActivity::findTaskInList(const QString & _device_
 
 void GameInstallerActivity::dragEnterEvent(QDragEnterEvent * _event)
 {
-    if(mp_working_thread)
+    if(m_is_installing)
     {
         _event->ignore();
         return;
@@ -479,7 +642,7 @@ void GameInstallerActivity::addDisc()
 
 void GameInstallerActivity::renameGame()
 {
-    if(mp_working_thread) return;
+    if(m_is_installing) return;
     TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
     if(!item || item->status() != GameInstallationStatus::Queued)
         return;
@@ -494,9 +657,20 @@ void GameInstallerActivity::renameGame()
 
 void GameInstallerActivity::removeGame()
 {
-    if(mp_working_thread) return;
+    if(m_is_installing) return;
     TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
-    if(item->status() != GameInstallationStatus::Queued) return;
+    if(!item->journalFilepath().isEmpty())
+    {
+        QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Suspended Installation"),
+            tr("Discard the data written by the interrupted installation of \"%1\"?").arg(item->device().title()));
+        if(answer != QMessageBox::Yes)
+            return;
+        item->discardSuspendedData();
+    }
+    else if(item->status() != GameInstallationStatus::Queued)
+    {
+        return;
+    }
     delete item;
     if(mp_tree_tasks->topLevelItemCount() == 0)
     {
@@ -535,6 +709,50 @@ void GameInstallerActivity::renameOptionChanged()
     item->enabelRenaming(mp_checkbox_rename->isChecked());
 }
 
+void GameInstallerActivity::trimOptionChanged()
+{
+    TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
+    if(!item) return;
+    item->device().enableTrimming(mp_checkbox_trim->isChecked());
+}
+
+void GameInstallerActivity::chooseDummyFiles()
+{
+    TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
+    if(!item) return;
+    Device & device = item->device();
+    QSharedPointer<DummyStrippingDeviceSource> stripping_source = device.source().dynamicCast<DummyStrippingDeviceSource>();
+    QSharedPointer<DeviceSource> source = stripping_source ? stripping_source->originalSource() : device.source();
+    if(!source->isOpen() && !source->open())
+    {
+        Application::instance().showErrorMessage(tr("Unable to open device to read: \"%1\"").arg(source->filepath()));
+        return;
+    }
+    const QList<Iso9660File> files = DummyStrippingDeviceSource::listFiles(*source);
+    if(files.isEmpty())
+    {
+        Application::instance().showErrorMessage(tr("Unable to read the file system of the image"));
+        return;
+    }
+    DummyFilesDialog dlg(files, stripping_source ? stripping_source->dummyFilepaths() : QStringList(), this);
+    if(dlg.exec() != QDialog::Accepted)
+        return;
+    const QStringList dummy_filepaths = dlg.selectedFilepaths();
+    if(!dummy_filepaths.isEmpty())
+        source.reset(new DummyStrippingDeviceSource(source, dummy_filepaths));
+    QSharedPointer<Device> new_device(new Device(source));
+    if(!new_device->init())
+    {
+        Application::instance().showErrorMessage(tr("Unable to rebuild the image without the chosen files"));
+        return;
+    }
+    new_device->setTitle(device.title());
+    new_device->setMediaType(device.mediaType());
+    new_device->enableTrimming(device.isTrimmingEnabled());
+    item->setDevice(new_device);
+    taskSelectionChanged();
+}
+
 void GameInstallerActivity::moveOptionChanged()
 {
     TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
@@ -542,10 +760,21 @@ void GameInstallerActivity::moveOptionChanged()
     item->enabelMoving(mp_checkbox_move->isChecked());
 }
 
+void GameInstallerActivity::ioPolicyChanged()
+{
+    TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->currentItem());
+    if(!item) return;
+    IoPolicy policy;
+    policy.io_class = mp_checkbox_idle_io->isChecked() ? IoClass::Idle : IoClass::BestEffort;
+    policy.bandwidth_limit = static_cast<quint64>(mp_spinbox_bandwidth_limit->value()) * g_mebibyte;
+    item->setIoPolicy(policy);
+}
+
 void GameInstallerActivity::install()
 {
     mp_groupbox_media_type->setDisabled(true);
     mp_groupbox_options->setDisabled(true);
+    mp_groupbox_io->setDisabled(true);
     mp_btn_add_image->setDisabled(true);
     mp_btn_add_disc->setDisabled(true);
     mp_btn_install->setDisabled(true);
@@ -553,36 +782,188 @@ void GameInstallerActivity::install()
     mp_btn_remove->setDisabled(true);
     mp_btn_rename->setDisabled(true);
     mp_btn_cancel->setDisabled(false);
-    m_processing_task_index = 0;
     mp_progressbar_overall->setMaximum(g_progressbar_max_value);
-    startTask();
+    const QString destination_id = storageDeviceId(Application::instance().gameCollection().directory());
+    for(int i = mp_tree_tasks->topLevelItemCount() - 1; i >= 0; --i)
+    {
+        TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i));
+        item->setStorageDeviceIds(storageDeviceId(item->device().filepath()), destination_id);
+    }
+    m_is_installing = true;
+    m_overall_statistics.reset();
+    m_clock.start();
+    mp_progress_timer->start();
+    startTasks();
+    if(m_running_tasks.isEmpty())
+        installationFinished();
 }
 
-void GameInstallerActivity::installProgress(quint64 _total_bytes, quint64 _processed_bytes)
+void GameInstallerActivity::startTasks()
 {
-    double current_progress = static_cast<double>(_processed_bytes) / _total_bytes;
-    double single_task_in_overal_progress = 1.0 / mp_tree_tasks->topLevelItemCount();
-    double overall_progress = single_task_in_overal_progress * m_processing_task_index +
-            single_task_in_overal_progress * current_progress;
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index))->
-        setProgress(current_progress * g_progressbar_max_value);
-    mp_progressbar_overall->setValue(overall_progress * g_progressbar_max_value);
+    if(m_is_canceled)
+        return;
+    const int count = mp_tree_tasks->topLevelItemCount();
+    for(int i = 0; i < count && m_running_tasks.count() < g_max_concurrent_tasks; ++i)
+    {
+        TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i));
+        if(item->status() != GameInstallationStatus::Queued || item->job())
+            continue;
+        if(!isConflictingWithRunningTasks(item))
+            startTask(item);
+    }
 }
 
-void GameInstallerActivity::rollbackStarted()
+bool GameInstallerActivity::isConflictingWithRunningTasks(const QTreeWidgetItem * _item) const
 {
-    mp_btn_cancel->setDisabled(true);
-    setOverallProgressUnknownStatus(true);
-    mp_progressbar_overall->setValue(0);
-    mp_progressbar_overall->setMaximum(0);
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index))->
-            setStatus(GameInstallationStatus::RollingBack);
+    const TaskListItem * item = static_cast<const TaskListItem *>(_item);
+    for(const QTreeWidgetItem * task : m_running_tasks)
+    {
+        if(areTasksConflicting(*item, *static_cast<const TaskListItem *>(task)))
+            return true;
+    }
+    return false;
 }
 
-void GameInstallerActivity::rollbackFinished()
+void GameInstallerActivity::startTask(QTreeWidgetItem * _item)
 {
-    setTaskError(canceledErrorMessage());
-    setOverallProgressUnknownStatus(false, g_progressbar_max_value);
+    TaskListItem * item = static_cast<TaskListItem *>(_item);
+    GameCollection & collection = Application::instance().gameCollection();
+    GameInstaller * installer = nullptr;
+    if(item->isSplittingUpEnabled())
+    {
+        installer = new UlConfigGameInstaller(item->device(), collection, this);
+    }
+    else
+    {
+        DirectoryGameInstaller * dir_installer = new DirectoryGameInstaller(item->device(), collection, this);
+        dir_installer->setOptionMoveFile(item->isMovingEnabled());
+        dir_installer->setOptionRenameFile(item->isRenamingEnabled());
+        installer = dir_installer;
+    }
+    JobPointer job = Job::create(JobKind::Io, [installer]() {
+        installer->install();
+    });
+    job->setPriority(JobPriority::High);
+    job->setIoPolicy(item->ioPolicy());
+    connect(job.data(), &Job::started, this, [this, item]() { taskStarted(item); });
+    connect(job.data(), &Job::finished, this, [this, item]() { taskFinished(item); });
+    connect(job.data(), &Job::failed, this, [this, item](QString _message) {
+        installerError(item, _message);
+    });
+    connect(installer, &GameInstaller::rollbackStarted, this, [this, item]() { rollbackStarted(item); });
+    connect(installer, &GameInstaller::rollbackFinished, this, [this, item]() { rollbackFinished(item); });
+    connect(installer, &GameInstaller::suspended, this, [this, item](const QString & _journal_filepath) {
+        taskSuspended(item, _journal_filepath);
+    });
+    connect(installer, &GameInstaller::registrationStarted, this, [this, item]() { registrationStarted(item); });
+    connect(installer, &GameInstaller::registrationFinished, this, [this, item]() { registrationFinished(item); });
+    item->setWorker(job, installer);
+    item->statistics().reset();
+    m_running_tasks.append(item);
+    JobScheduler::instance().submit(job);
+}
+
+bool GameInstallerActivity::isLastActiveTask(const QTreeWidgetItem * _item) const
+{
+    if(m_running_tasks.count() != 1 || m_running_tasks.first() != _item)
+        return false;
+    for(int i = mp_tree_tasks->topLevelItemCount() - 1; i >= 0; --i)
+    {
+        if(static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i))->status() == GameInstallationStatus::Queued)
+            return false;
+    }
+    return true;
+}
+
+void GameInstallerActivity::sampleProgress()
+{
+    const qint64 now = m_clock.elapsed();
+    quint64 overall_total_bytes = 0;
+    quint64 overall_done_bytes = 0;
+    for(int i = mp_tree_tasks->topLevelItemCount() - 1; i >= 0; --i)
+    {
+        TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i));
+        const quint64 device_size = item->device().size();
+        switch(item->status())
+        {
+        case GameInstallationStatus::Queued:
+            overall_total_bytes += device_size;
+            break;
+        case GameInstallationStatus::Installation:
+            if(item->installer())
+            {
+                const TransferProgress & progress = item->installer()->transferProgress();
+                const quint64 total_bytes = progress.totalBytes();
+                const quint64 done_bytes = progress.doneBytes();
+                if(total_bytes == 0)
+                {
+                    overall_total_bytes += device_size;
+                    break;
+                }
+                item->statistics().sample(total_bytes, done_bytes, now);
+                item->setProgress(done_bytes * g_progressbar_max_value / total_bytes);
+                item->setProgressText(item->statistics().toString());
+                overall_total_bytes += total_bytes;
+                overall_done_bytes += done_bytes;
+            }
+            break;
+        case GameInstallationStatus::Registration:
+        case GameInstallationStatus::Done:
+        // A failed or interrupted task is finished too, dropping it would move the overall progress back
+        case GameInstallationStatus::Error:
+        case GameInstallationStatus::RollingBack:
+        case GameInstallationStatus::Suspended:
+            overall_total_bytes += device_size;
+            overall_done_bytes += device_size;
+            break;
+        }
+    }
+    if(overall_total_bytes == 0)
+        return;
+    m_overall_statistics.sample(overall_total_bytes, overall_done_bytes, now);
+    mp_progressbar_overall->setFormat(QString("%p% (%1)").arg(m_overall_statistics.toString()));
+    if(mp_progressbar_overall->maximum() != 0)
+        mp_progressbar_overall->setValue(overall_done_bytes * g_progressbar_max_value / overall_total_bytes);
+}
+
+// The I/O threads are shared with the other jobs, the task stays queued until its job gets a thread
+void GameInstallerActivity::taskStarted(QTreeWidgetItem * _item)
+{
+    TaskListItem * item = static_cast<TaskListItem *>(_item);
+    if(item->status() == GameInstallationStatus::Queued)
+        item->setStatus(GameInstallationStatus::Installation);
+}
+
+void GameInstallerActivity::rollbackStarted(QTreeWidgetItem * _item)
+{
+    if(isLastActiveTask(_item))
+    {
+        mp_btn_cancel->setDisabled(true);
+        setOverallProgressUnknownStatus(true);
+    }
+    static_cast<TaskListItem *>(_item)->setStatus(GameInstallationStatus::RollingBack);
+}
+
+void GameInstallerActivity::rollbackFinished(QTreeWidgetItem * _item)
+{
+    setTaskError(canceledErrorMessage(), _item);
+    setOverallProgressUnknownStatus(false);
+    sampleProgress();
+}
+
+void GameInstallerActivity::taskSuspended(QTreeWidgetItem * _item, const QString & _journal_filepath)
+{
+    static_cast<TaskListItem *>(_item)->setSuspended(_journal_filepath);
+    if(_item == mp_tree_tasks->currentItem())
+        mp_label_error_message->setText(suspendedMessage());
+    sampleProgress();
+}
+
+QString GameInstallerActivity::suspendedMessage() const
+{
+    static const QString message = tr("Interrupted. The written data is kept, "
+        "installing the image again continues from the last checkpoint.");
+    return message;
 }
 
 QString GameInstallerActivity::canceledErrorMessage() const
@@ -591,19 +972,17 @@ QString GameInstallerActivity::canceledErrorMessage() const
     return message;
 }
 
-void GameInstallerActivity::setTaskError(const QString & _message, int _index /*= -1*/)
+void GameInstallerActivity::setTaskError(const QString & _message, QTreeWidgetItem * _item)
 {
-    if(_index < 0) _index = m_processing_task_index;
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(_index))->setError(_message);
-    if(_index == mp_tree_tasks->currentIndex().row())
+    static_cast<TaskListItem *>(_item)->setError(_message);
+    if(_item == mp_tree_tasks->currentItem())
         mp_label_error_message->setText(_message);
 }
 
-void GameInstallerActivity::registrationStarted()
+void GameInstallerActivity::registrationStarted(QTreeWidgetItem * _item)
 {
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index))->
-        setStatus(GameInstallationStatus::Registration);
-    if(m_processing_task_index + 1 == mp_tree_tasks->topLevelItemCount())
+    static_cast<TaskListItem *>(_item)->setStatus(GameInstallationStatus::Registration);
+    if(isLastActiveTask(_item))
         setOverallProgressUnknownStatus(true);
 }
 
@@ -613,85 +992,60 @@ void GameInstallerActivity::setOverallProgressUnknownStatus(bool _unknown, int _
     mp_progressbar_overall->setValue(_value);
 }
 
-void GameInstallerActivity::registrationFinished()
+void GameInstallerActivity::registrationFinished(QTreeWidgetItem * _item)
 {
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index))->
-        setStatus(GameInstallationStatus::Done);
+    static_cast<TaskListItem *>(_item)->setStatus(GameInstallationStatus::Done);
+    setOverallProgressUnknownStatus(false);
+    sampleProgress();
 }
 
-void GameInstallerActivity::threadFinished()
+void GameInstallerActivity::taskFinished(QTreeWidgetItem * _item)
 {
-    ++m_processing_task_index;
-    mp_working_thread = nullptr;
-    if(startTask())
+    TaskListItem * item = static_cast<TaskListItem *>(_item);
+    m_running_tasks.removeOne(item);
+    // A job canceled while it is pending is finished without running the installer
+    const GameInstallationStatus status = item->status();
+    if(item->job()->state() == Job::State::Canceled ||
+        status == GameInstallationStatus::Queued || status == GameInstallationStatus::Installation)
     {
-        return;
+        setTaskError(canceledErrorMessage(), item);
     }
+    item->installer()->deleteLater();
+    item->setWorker(nullptr, nullptr);
+    startTasks();
+    if(m_running_tasks.isEmpty())
+        installationFinished();
+}
+
+void GameInstallerActivity::installationFinished()
+{
+    m_is_installing = false;
+    mp_progress_timer->stop();
+    mp_progressbar_overall->setFormat("%p%");
     mp_btn_back->setDisabled(false);
     mp_btn_cancel->setDisabled(true);
     setOverallProgressUnknownStatus(false, g_progressbar_max_value);
     Application::instance().showMessage(tr("Done"), tr("Installation complete"));
 }
 
-bool GameInstallerActivity::startTask()
+void GameInstallerActivity::installerError(QTreeWidgetItem * _item, QString _message)
 {
-    delete mp_installer;
-    mp_installer = nullptr;
-    if(m_is_canceled)
-        return false;
-    TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index));
-    if(!item)
-        return false;
-    if(mp_radio_mtcd->isChecked())
-        item->setMediaType(MediaType::CD);
-    else if(mp_radio_mtdvd->isChecked())
-        item->setMediaType(MediaType::DVD);
-    else
-        item->setMediaType(MediaType::Unknown);
-    GameCollection & collection = Application::instance().gameCollection();
-    if(item->isSplittingUpEnabled())
-    {
-        mp_installer = new UlConfigGameInstaller(item->device(), collection, this);
-    }
-    else
-    {
-        DirectoryGameInstaller * dir_installer = new DirectoryGameInstaller(item->device(), collection, this);
-        dir_installer->setOptionMoveFile(item->isMovingEnabled());
-        dir_installer->setOptionRenameFile(item->isRenamingEnabled());
-        mp_installer = dir_installer;
-    }
-    mp_working_thread = new LambdaThread([this]() {
-        mp_installer->install();
-    }, this);
-    connect(mp_working_thread, &QThread::finished, this, &GameInstallerActivity::threadFinished);
-    connect(mp_working_thread, &QThread::finished, mp_working_thread, &QThread::deleteLater);
-    connect(mp_working_thread, &LambdaThread::exception, this, &GameInstallerActivity::installerError);
-    connect(mp_installer, &GameInstaller::progress, this, &GameInstallerActivity::installProgress);
-    connect(mp_installer, &GameInstaller::rollbackStarted, this, &GameInstallerActivity::rollbackStarted);
-    connect(mp_installer, &GameInstaller::rollbackFinished, this, &GameInstallerActivity::rollbackFinished);
-    connect(mp_installer, &GameInstaller::registrationStarted, this, &GameInstallerActivity::registrationStarted);
-    connect(mp_installer, &GameInstaller::registrationFinished, this, &GameInstallerActivity::registrationFinished);
-    static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(m_processing_task_index))->
-            setStatus(GameInstallationStatus::Installation);
-    mp_working_thread->start(QThread::HighestPriority);
-    return true;
-}
-
-void GameInstallerActivity::installerError(QString _message)
-{
-    setTaskError(_message);
+    setTaskError(_message, _item);
 }
 
 void GameInstallerActivity::cancel()
 {
-    if(mp_working_thread && !m_is_canceled)
+    if(m_running_tasks.isEmpty() || m_is_canceled)
+        return;
+    m_is_canceled = true;
+    mp_btn_cancel->setDisabled(true);
+    for(QTreeWidgetItem * task : m_running_tasks)
+        static_cast<TaskListItem *>(task)->job()->cancel();
+    for(int i = mp_tree_tasks->topLevelItemCount() - 1; i >= 0; --i)
     {
-        m_is_canceled = true;
-        mp_btn_cancel->setDisabled(true);
-        mp_working_thread->requestInterruption();
-        for(int i = mp_tree_tasks->topLevelItemCount() - 1; i > m_processing_task_index; --i)
-        {
-            setTaskError(canceledErrorMessage(), i);
-        }
+        TaskListItem * item = static_cast<TaskListItem *>(mp_tree_tasks->topLevelItem(i));
+        // The submitted tasks are reported by their jobs
+        if(item->status() == GameInstallationStatus::Queued && !item->job())
+            setTaskError(canceledErrorMessage(), item);
     }
 }
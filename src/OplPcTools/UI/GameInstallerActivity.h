@@ -21,8 +21,10 @@
 
 #include <QWidget>
 #include <QTreeWidgetItem>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <OplPcTools/GameInstaller.h>
-#include <OplPcTools/UI/LambdaThread.h>
+#include <OplPcTools/TransferStatistics.h>
 #include <OplPcTools/UI/Intent.h>
 #include "ui_GameInstallerActivity.h"
 
@@ -54,25 +56,37 @@ private:
     void mediaTypeChanged(bool _checked);
     void splitUpOptionChanged(bool _checked);
     void renameOptionChanged();
+    void trimOptionChanged();
+    void chooseDummyFiles();
     void moveOptionChanged();
+    void ioPolicyChanged();
     void install();
-    bool startTask();
-    void installProgress(quint64 _total_bytes, quint64 _processed_bytes);
-    void rollbackStarted();
-    void rollbackFinished();
-    void registrationStarted();
-    void registrationFinished();
-    void threadFinished();
-    void installerError(QString _message);
-    void setTaskError(const QString & _message, int _index = -1);
+    void startTasks();
+    void startTask(QTreeWidgetItem * _item);
+    bool isConflictingWithRunningTasks(const QTreeWidgetItem * _item) const;
+    bool isLastActiveTask(const QTreeWidgetItem * _item) const;
+    void sampleProgress();
+    void taskStarted(QTreeWidgetItem * _item);
+    void rollbackStarted(QTreeWidgetItem * _item);
+    void rollbackFinished(QTreeWidgetItem * _item);
+    void taskSuspended(QTreeWidgetItem * _item, const QString & _journal_filepath);
+    void registrationStarted(QTreeWidgetItem * _item);
+    void registrationFinished(QTreeWidgetItem * _item);
+    void taskFinished(QTreeWidgetItem * _item);
+    void installationFinished();
+    void installerError(QTreeWidgetItem * _item, QString _message);
+    void setTaskError(const QString & _message, QTreeWidgetItem * _item);
     QString canceledErrorMessage() const;
+    QString suspendedMessage() const;
     void setOverallProgressUnknownStatus(bool _unknown, int _value = 0);
     void cancel();
 
 private:
-    LambdaThread * mp_working_thread;
-    GameInstaller * mp_installer;
-    quint32 m_processing_task_index;
+    QList<QTreeWidgetItem *> m_running_tasks;
+    QTimer * mp_progress_timer;
+    QElapsedTimer m_clock;
+    TransferStatistics m_overall_statistics;
+    bool m_is_installing;
     bool m_is_canceled;
 };
 
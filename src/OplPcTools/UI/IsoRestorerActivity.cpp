@@ -16,13 +16,14 @@
  *                                                                                             *
  ***********************************************************************************************/
 
-#include <cmath>
 #include <QFileDialog>
 #include <QSettings>
+#include <QMessageBox>
 #include <OplPcTools/IsoRestorer.h>
 #include <OplPcTools/Game.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/TransferJournal.h>
 #include <OplPcTools/UI/Application.h>
-#include <OplPcTools/UI/LambdaThread.h>
 #include <OplPcTools/UI/IsoRestorerActivity.h>
 
 using namespace OplPcTools;
@@ -59,12 +60,16 @@ private:
 IsoRestorerActivity::IsoRestorerActivity(const QString & _game_id, QWidget * _parent /*= nullptr*/) :
     Activity(_parent),
     m_game_id(_game_id),
-    mp_working_thread(nullptr)
+    mp_restorer(nullptr),
+    mp_progress_timer(nullptr)
 {
     setupUi(this);
+    mp_progress_timer = new QTimer(this);
+    mp_progress_timer->setInterval(250);
+    connect(mp_progress_timer, &QTimer::timeout, this, &IsoRestorerActivity::sampleProgress);
     mp_btn_back->setDisabled(true);
     connect(mp_button_box, &QDialogButtonBox::rejected, this, &IsoRestorerActivity::onCancel);
-    connect(mp_btn_back, &QPushButton::clicked, this, &IsoRestorerActivity::deleteLater);
+    connect(mp_btn_back, &QPushButton::clicked, this, &IsoRestorerActivity::onBack);
 }
 
 QSharedPointer<Intent> IsoRestorerActivity::createIntent(const QString & _game_id)
@@ -74,7 +79,7 @@ QSharedPointer<Intent> IsoRestorerActivity::createIntent(const QString & _game_i
 
 bool IsoRestorerActivity::onAttach()
 {
-    const Game * game = Application::instance().gameCollection().findGame(m_game_id);
+    QSharedPointer<const Game> game = Application::instance().gameCollection().game(m_game_id);
     if(!game)
         return false;
     mp_label_title->setText(game->title());
@@ -93,56 +98,72 @@ bool IsoRestorerActivity::onAttach()
 
 void IsoRestorerActivity::restore(const Game & _game, const QString & _destination)
 {
-    if(mp_working_thread) return;
+    if(m_job_ptr) return;
     m_finish_status.clear();
+    m_journal_filepath.clear();
     IsoRestorer * restorer = new IsoRestorer(_game, Application::instance().gameCollection().directory(), _destination, this);
-    LambdaThread * working_thread = new LambdaThread([restorer]() {
+    m_job_ptr = Job::create(JobKind::Io, [restorer]() {
         restorer->restore();
-    }, this);
-    mp_working_thread = working_thread;
+    });
+    m_job_ptr->setPriority(JobPriority::High);
+    m_job_ptr->setIoPolicy(Settings::instance().ioPolicy());
+    mp_restorer = restorer;
     auto cleanup = [this, restorer]() {
-        if(mp_working_thread)
+        if(m_job_ptr)
         {
-            mp_working_thread->deleteLater();
-            mp_working_thread = nullptr;
+            // The final sample must be taken while the restorer is still alive
+            sampleProgress();
+            mp_progress_timer->stop();
+            m_job_ptr.reset();
+            mp_restorer = nullptr;
             restorer->deleteLater();
         }
     };
-    connect(mp_working_thread, &QThread::finished, this, &IsoRestorerActivity::onThreadFinished);
-    connect(mp_working_thread, &QThread::finished, cleanup);
-    connect(working_thread, &LambdaThread::exception, this, &IsoRestorerActivity::onException);
-    connect(working_thread, &LambdaThread::exception, cleanup);
-    connect(restorer, &IsoRestorer::progress, this, &IsoRestorerActivity::onProgress);
-    connect(restorer, &IsoRestorer::rollbackStarted, this, &IsoRestorerActivity::onRollbackStarted);
+    connect(m_job_ptr.data(), &Job::finished, this, cleanup);
+    connect(m_job_ptr.data(), &Job::finished, this, &IsoRestorerActivity::onJobFinished);
+    connect(m_job_ptr.data(), &Job::failed, this, cleanup);
+    connect(m_job_ptr.data(), &Job::failed, this, &IsoRestorerActivity::onException);
+    connect(restorer, &IsoRestorer::suspended, this, &IsoRestorerActivity::onSuspended);
     mp_progress_bar->setMinimum(0);
     mp_progress_bar->setMaximum(s_progress_max);
     mp_label_status->setText(tr("Restoring '%1' to '%2'...").arg(_game.title()).arg(_destination));
-    mp_working_thread->start(QThread::HighestPriority);
+    m_statistics.reset();
+    m_clock.start();
+    mp_progress_timer->start();
+    JobScheduler::instance().submit(m_job_ptr);
 }
 
-void IsoRestorerActivity::onProgress(quint64 _total_bytes, quint64 _processed_bytes)
+void IsoRestorerActivity::sampleProgress()
 {
-    if(_total_bytes == _processed_bytes)
+    if(!mp_restorer || !m_finish_status.isEmpty())
+        return;
+    const TransferProgress & progress = mp_restorer->transferProgress();
+    const quint64 total_bytes = progress.totalBytes();
+    const quint64 processed_bytes = progress.doneBytes();
+    if(total_bytes == 0)
+        return;
+    if(total_bytes == processed_bytes)
     {
         mp_label_status->setText(tr("Synchronization of buffers. Please wait..."));
         m_finish_status = tr("Done");
         mp_button_box->setDisabled(true);
+        mp_progress_bar->setFormat("%p%");
         mp_progress_bar->setMaximum(0);
         mp_progress_bar->setValue(0);
     }
     else
     {
-        double progress = floor((static_cast<double>(_processed_bytes) / _total_bytes) * s_progress_max);
-        mp_progress_bar->setValue(progress);
+        m_statistics.sample(total_bytes, processed_bytes, m_clock.elapsed());
+        mp_progress_bar->setFormat(QString("%p% (%1)").arg(m_statistics.toString()));
+        mp_progress_bar->setValue(processed_bytes * s_progress_max / total_bytes);
     }
 }
 
-void IsoRestorerActivity::onRollbackStarted()
+void IsoRestorerActivity::onSuspended(const QString & _journal_filepath)
 {
-    mp_progress_bar->setMaximum(0);
-    mp_progress_bar->setValue(0);
-    mp_label_status->setText(tr("Rolling back..."));
-    m_finish_status = tr("Canceled");
+    m_journal_filepath = _journal_filepath;
+    mp_label_status->setText(tr("Suspended"));
+    m_finish_status = tr("Suspended. Restoring the game to the same file continues from the last checkpoint.");
 }
 
 void IsoRestorerActivity::onException(QString _message)
@@ -151,8 +172,9 @@ void IsoRestorerActivity::onException(QString _message)
     Application::instance().showErrorMessage(_message);
 }
 
-void IsoRestorerActivity::onThreadFinished()
+void IsoRestorerActivity::onJobFinished()
 {
+    mp_progress_bar->setFormat("%p%");
     if(!m_finish_status.isEmpty())
         mp_label_status->setText(m_finish_status);
     mp_progress_bar->setMaximum(s_progress_max);
@@ -162,12 +184,28 @@ void IsoRestorerActivity::onThreadFinished()
 }
 
 
+// The partially restored image is useless unless the restoration is continued later
+void IsoRestorerActivity::onBack()
+{
+    if(!m_journal_filepath.isEmpty())
+    {
+        QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Suspended Restoration"),
+            tr("Keep the partially restored image to continue the restoration later?"),
+            QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel, QMessageBox::Yes);
+        if(answer == QMessageBox::Cancel)
+            return;
+        if(answer == QMessageBox::No)
+            TransferJournal::discard(m_journal_filepath);
+    }
+    deleteLater();
+}
+
 void IsoRestorerActivity::onCancel()
 {
-    if(mp_working_thread)
+    if(m_job_ptr)
     {
         mp_button_box->setDisabled(true);
-        mp_working_thread->requestInterruption();
+        m_job_ptr->cancel();
     }
 }
 
@@ -19,10 +19,14 @@
 #ifndef __OPLPCTOOLS_ISORESTORERACTIVITY__
 #define __OPLPCTOOLS_ISORESTORERACTIVITY__
 
-#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QWidget>
 #include <QSharedPointer>
 #include <OplPcTools/Game.h>
+#include <OplPcTools/IsoRestorer.h>
+#include <OplPcTools/JobScheduler.h>
+#include <OplPcTools/TransferStatistics.h>
 #include <OplPcTools/UI/Intent.h>
 #include "ui_IsoRestorerActivity.h"
 
@@ -43,17 +47,23 @@ private:
     void restore(const Game & _game, const QString & _destination);
 
 private slots:
-    void onProgress(quint64 _total_bytes, quint64 _processed_bytes);
-    void onRollbackStarted();
+    void sampleProgress();
+    void onSuspended(const QString & _journal_filepath);
     void onException(QString _message);
-    void onThreadFinished();
+    void onJobFinished();
     void onCancel();
+    void onBack();
 
 private:
     static const quint32 s_progress_max = 1000;
     const QString m_game_id;
-    QThread * mp_working_thread;
+    JobPointer m_job_ptr;
+    IsoRestorer * mp_restorer;
+    QTimer * mp_progress_timer;
+    QElapsedTimer m_clock;
+    TransferStatistics m_statistics;
     QString m_finish_status;
+    QString m_journal_filepath;
 };
 
 } // namespace UI
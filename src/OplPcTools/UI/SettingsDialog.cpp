@@ -18,11 +18,19 @@
 
 #include <OplPcTools/Settings.h>
 #include <OplPcTools/Updater.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/UI/Application.h>
 #include <OplPcTools/UI/SettingsDialog.h>
 
 using namespace OplPcTools;
 using namespace OplPcTools::UI;
 
+namespace {
+
+const quint64 g_mebibyte = 1048576;
+
+} // namespace
+
 SettingsDialog::SettingsDialog(QWidget * _parent /*= nullptr*/) :
     QDialog(_parent, Qt::WindowSystemMenuHint | Qt::WindowTitleHint)
 {
@@ -34,11 +42,24 @@ SettingsDialog::SettingsDialog(QWidget * _parent /*= nullptr*/) :
     mp_checkbox_donot_splitup->setChecked(!settings.flag(Settings::Flag::SplitUpIso));
     mp_checkbox_add_id->setChecked(settings.flag(Settings::Flag::RenameIso));
     mp_checkobx_move_iso->setChecked(settings.flag(Settings::Flag::MoveIso));
+    mp_checkbox_trim->setChecked(settings.flag(Settings::Flag::TrimIso));
     mp_checkbox_validate_ulcfg->setChecked(settings.flag(Settings::Flag::ValidateUlCfg));
     if(Updater::isSupported())
         mp_checkbox_check_new_versions->setChecked(settings.flag(Settings::Flag::CheckNewVersion));
     else
         mp_checkbox_check_new_versions->setEnabled(false);
+    // The limit is stored for the drive of the opened library, so each destination keeps its own value.
+    const GameCollection & collection = Application::instance().gameCollection();
+    if(collection.isLoaded())
+    {
+        m_library_storage_device_id = storageDeviceId(collection.directory());
+        mp_label_dirty_limit->setText(tr("Maximum unwritten data for the library drive:"));
+    }
+    const WriteBackPolicy policy = settings.writeBackPolicy(m_library_storage_device_id);
+    mp_spinbox_dirty_limit->setValue(static_cast<int>(policy.dirty_limit / g_mebibyte));
+    const IoPolicy io_policy = settings.ioPolicy();
+    mp_checkbox_idle_io->setChecked(io_policy.io_class == IoClass::Idle);
+    mp_spinbox_bandwidth_limit->setValue(static_cast<int>(io_policy.bandwidth_limit / g_mebibyte));
     mp_tabs->setCurrentIndex(0);
 }
 
@@ -51,8 +72,16 @@ void SettingsDialog::accept()
     settings.setFlag(Settings::Flag::SplitUpIso, !mp_checkbox_donot_splitup->isChecked());
     settings.setFlag(Settings::Flag::RenameIso, mp_checkbox_add_id->isChecked());
     settings.setFlag(Settings::Flag::MoveIso, mp_checkobx_move_iso->isChecked());
+    settings.setFlag(Settings::Flag::TrimIso, mp_checkbox_trim->isChecked());
     settings.setFlag(Settings::Flag::ValidateUlCfg, mp_checkbox_validate_ulcfg->isChecked());
     settings.setFlag(Settings::Flag::CheckNewVersion,
         mp_checkbox_check_new_versions->isEnabled() && mp_checkbox_check_new_versions->isChecked());
+    WriteBackPolicy policy = settings.writeBackPolicy(m_library_storage_device_id);
+    policy.dirty_limit = static_cast<quint64>(mp_spinbox_dirty_limit->value()) * g_mebibyte;
+    settings.setWriteBackPolicy(m_library_storage_device_id, policy);
+    IoPolicy io_policy;
+    io_policy.io_class = mp_checkbox_idle_io->isChecked() ? IoClass::Idle : IoClass::BestEffort;
+    io_policy.bandwidth_limit = static_cast<quint64>(mp_spinbox_bandwidth_limit->value()) * g_mebibyte;
+    settings.setIoPolicy(io_policy);
     QDialog::accept();
 }
@@ -34,6 +34,9 @@ public:
 
 public slots:
     void accept() override;
+
+private:
+    QString m_library_storage_device_id;
 };
 
 } // namespace UI
@@ -18,12 +18,23 @@
 
 #include <QFile>
 #include <QDir>
-#include <QThread>
+#include <QFileInfo>
+#include <OplPcTools/JobScheduler.h>
 #include <OplPcTools/Exception.h>
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/Settings.h>
+#include <OplPcTools/StorageDevice.h>
+#include <OplPcTools/WriteBackFile.h>
 #include <OplPcTools/UlConfigGameInstaller.h>
 
 using namespace OplPcTools;
 
+namespace {
+
+const quint64 g_checkpoint_interval = 268435456;
+
+} // namespace
+
 UlConfigGameInstaller::UlConfigGameInstaller(Device & _device, GameCollection & _collection, QObject * _parent) :
     GameInstaller(_device, _collection, _parent),
     mp_game(nullptr)
@@ -37,6 +48,7 @@ UlConfigGameInstaller::~UlConfigGameInstaller()
 
 bool UlConfigGameInstaller::install()
 {
+    OPT_TRACE_SCOPE("UlConfigGameInstaller::install");
     if(!mr_device.open())
     {
         throw IOException(tr("Unable to open device file to read: \"%1\"").arg(mr_device.filepath()));
@@ -50,63 +62,122 @@ bool UlConfigGameInstaller::install()
     const quint64 iso_size = mr_device.size();
     const ssize_t part_size = 1073741824;
     const ssize_t read_part_size = 4194304;
-    quint64 processed_bytes = 0;
-    unsigned int write_operation = 0;
     QDir dest_dir(mr_collection.directory());
+    const WriteBackPolicy write_back_policy = Settings::instance().writeBackPolicy(storageDeviceId(dest_dir.absolutePath()));
     QByteArray bytes(read_part_size, Qt::Initialization::Uninitialized);
-    mr_device.seek(0);
+    const QString first_part_filepath = dest_dir.absoluteFilePath(
+        UlConfigGameStorage::makePartFilename(mp_game->id(), mp_game->title(), 0));
+    m_journal_filepath = TransferJournal::filepath(first_part_filepath);
+    TransferJournal journal;
+    journal.source_filepath = mr_device.filepath();
+    journal.game_id = mp_game->id();
+    journal.source_size = iso_size;
+    journal.source_mtime = QFileInfo(mr_device.filepath()).lastModified().toMSecsSinceEpoch();
+    quint64 processed_bytes = 0;
+    if(QFile::exists(first_part_filepath))
+    {
+        processed_bytes = journal.resume(m_journal_filepath, [this](quint64 _offset, QByteArray & _buffer) {
+            return mr_device.seek(_offset) && mr_device.read(_buffer) == _buffer.size();
+        });
+        if(processed_bytes == 0)
+            removeStaleParts(dest_dir);
+    }
+    // Parts before the checkpoint are complete, the part with the checkpoint is continued from it.
+    const quint8 resumed_part = static_cast<quint8>(processed_bytes / part_size);
+    quint64 synced_bytes = static_cast<quint64>(resumed_part) * part_size;
+    m_progress.reset(iso_size);
+    m_progress.setDoneBytes(processed_bytes);
+    mr_device.seek(processed_bytes);
     quint8 part_count = 0;
+    for(; part_count < resumed_part; ++part_count)
+    {
+        m_written_parts.append(dest_dir.absoluteFilePath(
+            UlConfigGameStorage::makePartFilename(mp_game->id(), mp_game->title(), part_count)));
+    }
     for(bool unexpected_finish = false; !unexpected_finish && processed_bytes < iso_size; ++part_count)
     {
         QString part_filename = UlConfigGameStorage::makePartFilename(mp_game->id(), mp_game->title(), part_count);
-        QFile part(dest_dir.absoluteFilePath(part_filename));
-        if(part.exists())
+        WriteBackFile part(dest_dir.absoluteFilePath(part_filename), write_back_policy);
+        const bool is_resumed = processed_bytes > 0 && part_count >= resumed_part;
+        if(!is_resumed && part.exists())
         {
             rollback();
             throw IOException(tr("File already exists: \"%1\"").arg(part.fileName()));
         }
-        if(!part.open(QIODevice::WriteOnly))
+        const quint64 part_offset = processed_bytes - synced_bytes;
+        if(!(is_resumed ? part.openAt(part_offset) : part.open(QIODevice::WriteOnly)))
         {
             rollback();
             throw IOException(tr("Unable to open file to write: \"%1\"").arg(part.fileName()));
         }
         m_written_parts.append(part.fileName());
-        for(quint64 total_read_bytes = 0; total_read_bytes < part_size;)
+        quint64 checkpoint_bytes = part_offset;
+        for(quint64 total_read_bytes = part_offset; total_read_bytes < part_size;)
         {
-            qint64 read_bytes = mr_device.read(bytes);
+            qint64 read_bytes = 0;
+            {
+                OPT_TRACE_SCOPE("read");
+                read_bytes = mr_device.read(bytes);
+            }
             if(read_bytes < 0)
             {
+                part.sync();
                 part.close();
-                rollback();
+                suspend(journal, synced_bytes + part.durableBytes());
                 throw IOException(tr("An error occurred during reading the source medium"));
             }
             else if(read_bytes > 0)
             {
-                if(part.write(bytes.constData(), read_bytes) != read_bytes)
+                qint64 written_bytes = 0;
+                {
+                    OPT_TRACE_SCOPE("write");
+                    written_bytes = part.write(bytes.constData(), read_bytes);
+                }
+                if(written_bytes != read_bytes)
                 {
+                    part.sync();
                     part.close();
-                    rollback();
+                    suspend(journal, synced_bytes + part.durableBytes());
                     throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(part.fileName()));
                 }
-                if(++write_operation % 5 == 0)
-                    part.flush();
                 total_read_bytes += read_bytes;
                 processed_bytes += read_bytes;
+                OPT_TRACE_COUNTER("installed bytes", processed_bytes);
+                Job::throttleCurrentJob(read_bytes);
             }
             if(read_bytes < read_part_size)
             {
                 // Yes. It is a real scenario. The "Final Fantasy XII" declares the ISO FS size larger than it is.
                 unexpected_finish = true;
-                emit progress(processed_bytes, processed_bytes);
+                m_progress.setTotalBytes(processed_bytes);
                 break;
             }
-            emit progress(iso_size, processed_bytes);
-            if(QThread::currentThread()->isInterruptionRequested())
+            m_progress.setDoneBytes(synced_bytes + part.flushedBytes());
+            if(total_read_bytes - checkpoint_bytes >= g_checkpoint_interval && processed_bytes < iso_size && part.sync())
             {
-                rollback();
+                checkpoint_bytes = total_read_bytes;
+                saveCheckpoint(journal, processed_bytes);
+            }
+            // The last chunk is not interrupted, a checkpoint at the end of the image could not restore the part count
+            if(processed_bytes < iso_size && Job::isCurrentJobCanceled())
+            {
+                part.sync();
+                part.close();
+                suspend(journal, synced_bytes + part.durableBytes());
                 return false;
             }
         }
+        if(!part.sync())
+        {
+            part.close();
+            suspend(journal, synced_bytes + part.durableBytes());
+            throw IOException(tr("Unable to write a data into the file: \"%1\"").arg(part.fileName()));
+        }
+        synced_bytes += part.writtenBytes();
+        // The checkpoint must leave something to continue, otherwise the part count could not be restored.
+        if(!unexpected_finish && processed_bytes < iso_size)
+            saveCheckpoint(journal, synced_bytes);
+        m_progress.setDoneBytes(synced_bytes);
     }
     mp_game->setPartCount(part_count);
     try
@@ -120,24 +191,68 @@ bool UlConfigGameInstaller::install()
     }
     mr_device.close();
     m_written_parts.clear();
+    QFile::remove(m_journal_filepath);
     return true;
 }
 
+void UlConfigGameInstaller::saveCheckpoint(TransferJournal & _journal, quint64 _durable_bytes)
+{
+    _journal.destination_filepaths = m_written_parts;
+    _journal.durable_bytes = _durable_bytes;
+    _journal.save(m_journal_filepath);
+}
+
 void UlConfigGameInstaller::rollback()
 {
+    OPT_TRACE_SCOPE("UlConfigGameInstaller::rollback");
     if(mr_device.isOpen())
         mr_device.close();
     emit rollbackStarted();
     for(const QString & path : m_written_parts)
         QFile::remove(path);
     m_written_parts.clear();
+    if(!m_journal_filepath.isEmpty())
+        QFile::remove(m_journal_filepath);
     delete mp_game;
     mp_game = nullptr;
     emit rollbackFinished();
 }
 
+// Parts left by an installation that cannot be continued: its journal is lost or does not match the source anymore.
+// The parts of an installed game are kept, the installation fails on them.
+void UlConfigGameInstaller::removeStaleParts(const QDir & _directory)
+{
+    OPT_TRACE_SCOPE("UlConfigGameInstaller::removeStaleParts");
+    const QSharedPointer<const Game> installed_game = mr_collection.findGame(mp_game->id());
+    if(installed_game && installed_game->installationType() == GameInstallationType::UlConfig)
+        return;
+    for(quint8 part = 0;; ++part)
+    {
+        const QString filepath = _directory.absoluteFilePath(
+            UlConfigGameStorage::makePartFilename(mp_game->id(), mp_game->title(), part));
+        if(!QFile::remove(filepath))
+            break;
+    }
+    QFile::remove(m_journal_filepath);
+}
+
+// Stops the installation keeping the written parts and a checkpoint at the last synced offset.
+// A checkpoint without durable data only lists the parts, so the next attempt removes them.
+void UlConfigGameInstaller::suspend(TransferJournal & _journal, quint64 _durable_bytes)
+{
+    OPT_TRACE_SCOPE("UlConfigGameInstaller::suspend");
+    if(mr_device.isOpen())
+        mr_device.close();
+    saveCheckpoint(_journal, _durable_bytes);
+    m_written_parts.clear();
+    delete mp_game;
+    mp_game = nullptr;
+    emit suspended(m_journal_filepath);
+}
+
 void UlConfigGameInstaller::registerGame()
 {
+    OPT_TRACE_SCOPE("UlConfigGameInstaller::registerGame");
     emit registrationStarted();
     mr_collection.addGame(*mp_game);
     emit registrationFinished();
@@ -19,7 +19,9 @@
 #ifndef __OPLPCTOOLS_ULCONFIGGAMEINSTALLER__
 #define __OPLPCTOOLS_ULCONFIGGAMEINSTALLER__
 
+#include <QDir>
 #include <OplPcTools/GameInstaller.h>
+#include <OplPcTools/TransferJournal.h>
 
 namespace OplPcTools {
 
@@ -34,7 +36,10 @@ public:
     inline const Game * installedGame() const override;
 
 private:
+    void saveCheckpoint(TransferJournal & _journal, quint64 _durable_bytes);
     void rollback();
+    void removeStaleParts(const QDir & _directory);
+    void suspend(TransferJournal & _journal, quint64 _durable_bytes);
     void registerGame();
 
 private:
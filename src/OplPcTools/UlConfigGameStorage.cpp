@@ -143,7 +143,7 @@ bool UlConfigGameStorage::performLoading(const QDir & _directory)
     if(settings.flag(Settings::Flag::ValidateUlCfg) && file.size() % record_size != 0)
         throwUlCorrupted();
     char * buffer = new char[record_size];
-    for(;;)
+    while(!isLoadingCanceled())
     {
         size_t read_bytes = file.read(buffer, record_size);
         if(read_bytes < record_size)
@@ -175,6 +175,11 @@ bool UlConfigGameStorage::performLoading(const QDir & _directory)
     return true;
 }
 
+void UlConfigGameStorage::performRestoring(const QDir & _directory)
+{
+    m_config_filepath = _directory.absoluteFilePath(UL_CONFIG_FILENAME);
+}
+
 bool UlConfigGameStorage::performRenaming(const Game & _game, const QString & _title)
 {
     validateTitle(_title);
@@ -39,6 +39,7 @@ public:
 
 protected:
     bool performLoading(const QDir & _directory) override;
+    void performRestoring(const QDir & _directory) override;
     bool performRenaming(const Game & _game, const QString & _title) override;
     bool performRegistration(const Game & _game) override;
     bool performDeletion(const Game & _game) override;
@@ -0,0 +1,138 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifdef _WIN32
+#   include <windows.h>
+#   include <io.h>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+#include <OplPcTools/Trace.h>
+#include <OplPcTools/WriteBackFile.h>
+
+using namespace OplPcTools;
+
+namespace {
+
+bool syncData(int _fd)
+{
+#if defined(_WIN32)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fd))) != 0;
+#elif defined(__linux__)
+    return fdatasync(_fd) == 0;
+#else
+    return fsync(_fd) == 0;
+#endif
+}
+
+} // namespace
+
+WriteBackFile::WriteBackFile(const QString & _filepath, const WriteBackPolicy & _policy) :
+    m_file(_filepath),
+    m_policy(_policy),
+    m_written_bytes(0),
+    m_scheduled_bytes(0),
+    m_flushed_bytes(0),
+    m_durable_bytes(0)
+{
+    if(m_policy.window_size == 0)
+        m_policy.window_size = WriteBackPolicy().window_size;
+}
+
+WriteBackFile::~WriteBackFile()
+{
+    close();
+}
+
+bool WriteBackFile::open(QIODevice::OpenMode _mode)
+{
+    m_written_bytes = m_scheduled_bytes = m_flushed_bytes = m_durable_bytes = 0;
+    return m_file.open(_mode | QIODevice::Unbuffered);
+}
+
+bool WriteBackFile::openAt(quint64 _offset)
+{
+    m_written_bytes = m_scheduled_bytes = m_flushed_bytes = m_durable_bytes = 0;
+    if(!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
+        return false;
+    if(!m_file.resize(_offset) || !m_file.seek(_offset))
+    {
+        m_file.close();
+        return false;
+    }
+    m_written_bytes = m_scheduled_bytes = m_flushed_bytes = m_durable_bytes = _offset;
+    return true;
+}
+
+void WriteBackFile::close()
+{
+    m_file.close();
+}
+
+qint64 WriteBackFile::write(const char * _data, qint64 _size)
+{
+    qint64 written_bytes = m_file.write(_data, _size);
+    if(written_bytes > 0)
+    {
+        m_written_bytes += written_bytes;
+        if(m_policy.dirty_limit > 0)
+            writeBack();
+    }
+    return written_bytes;
+}
+
+void WriteBackFile::writeBack()
+{
+    const int fd = m_file.handle();
+#ifdef __linux__
+    while(m_written_bytes - m_scheduled_bytes >= m_policy.window_size)
+    {
+        sync_file_range(fd, m_scheduled_bytes, m_policy.window_size, SYNC_FILE_RANGE_WRITE);
+        m_scheduled_bytes += m_policy.window_size;
+    }
+    while(m_scheduled_bytes - m_flushed_bytes > m_policy.dirty_limit)
+    {
+        OPT_TRACE_SCOPE("write-back wait");
+        sync_file_range(fd, m_flushed_bytes, m_policy.window_size,
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        // The data will not be read again, keep the page cache for something useful.
+        posix_fadvise(fd, m_flushed_bytes, m_policy.window_size, POSIX_FADV_DONTNEED);
+        m_flushed_bytes += m_policy.window_size;
+    }
+#else
+    if(m_written_bytes - m_flushed_bytes >= m_policy.dirty_limit)
+    {
+        OPT_TRACE_SCOPE("write-back wait");
+        if(syncData(fd))
+            m_durable_bytes = m_written_bytes;
+        m_scheduled_bytes = m_flushed_bytes = m_written_bytes;
+    }
+#endif
+}
+
+bool WriteBackFile::sync()
+{
+    OPT_TRACE_SCOPE("sync");
+    if(!m_file.isOpen())
+        return false;
+    if(!syncData(m_file.handle()))
+        return false;
+    m_scheduled_bytes = m_flushed_bytes = m_durable_bytes = m_written_bytes;
+    return true;
+}
@@ -0,0 +1,105 @@
+/***********************************************************************************************
+ * Copyright © 2017-2019 Sergey Smolyannikov aka brainstream                                   *
+ *                                                                                             *
+ * This file is part of the OPL PC Tools project, the graphical PC tools for Open PS2 Loader.  *
+ *                                                                                             *
+ * OPL PC Tools is free software: you can redistribute it and/or modify it under the terms of  *
+ * the GNU General Public License as published by the Free Software Foundation,                *
+ * either version 3 of the License, or (at your option) any later version.                     *
+ *                                                                                             *
+ * OPL PC Tools is distributed in the hope that it will be useful,  but WITHOUT ANY WARRANTY;  *
+ * without even the implied warranty of  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  *
+ * See the GNU General Public License for more details.                                        *
+ *                                                                                             *
+ * You should have received a copy of the GNU General Public License along with MailUnit.      *
+ * If not, see <http://www.gnu.org/licenses/>.                                                 *
+ *                                                                                             *
+ ***********************************************************************************************/
+
+#ifndef __OPLPCTOOLS_WRITEBACKFILE__
+#define __OPLPCTOOLS_WRITEBACKFILE__
+
+#include <QFile>
+
+namespace OplPcTools {
+
+struct WriteBackPolicy
+{
+    WriteBackPolicy() :
+        window_size(8388608),
+        dirty_limit(67108864)
+    {
+    }
+
+    quint64 window_size; // Written data is handed to the storage in windows of this size
+    quint64 dirty_limit; // Maximum amount of written but not yet durable data. 0 lets the system decide.
+};
+
+/*
+ * An unbuffered output file that keeps the amount of dirty page cache bounded.
+ * On Linux completed windows are written out in the background with sync_file_range and the writer waits
+ * for the oldest window when the limit is exceeded. Other systems fall back to a full data sync at the limit.
+ * Data handed to the storage this way is counted by flushedBytes(), it is neither synced with metadata
+ * nor out of the drive cache. Only sync() makes the written data durable and advances durableBytes(),
+ * it must be called at part and file boundaries and before an offset is recorded as a checkpoint.
+ * openAt() continues an existing file from a durable offset, dropping everything written after it.
+ */
+class WriteBackFile final
+{
+    Q_DISABLE_COPY(WriteBackFile)
+
+public:
+    WriteBackFile(const QString & _filepath, const WriteBackPolicy & _policy);
+    ~WriteBackFile();
+    inline QString fileName() const;
+    inline bool exists() const;
+    bool open(QIODevice::OpenMode _mode);
+    bool openAt(quint64 _offset);
+    void close();
+    qint64 write(const char * _data, qint64 _size);
+    bool sync();
+    inline quint64 writtenBytes() const;
+    inline quint64 flushedBytes() const;
+    inline quint64 durableBytes() const;
+
+private:
+    void writeBack();
+
+private:
+    QFile m_file;
+    WriteBackPolicy m_policy;
+    quint64 m_written_bytes;
+    quint64 m_scheduled_bytes;
+    quint64 m_flushed_bytes;
+    quint64 m_durable_bytes;
+};
+
+QString WriteBackFile::fileName() const
+{
+    return m_file.fileName();
+}
+
+bool WriteBackFile::exists() const
+{
+    return m_file.exists();
+}
+
+quint64 WriteBackFile::writtenBytes() const
+{
+    return m_written_bytes;
+}
+
+quint64 WriteBackFile::flushedBytes() const
+{
+    // Without the limit the system decides when the data is written, so everything written is counted.
+    return m_policy.dirty_limit == 0 ? m_written_bytes : m_flushed_bytes;
+}
+
+quint64 WriteBackFile::durableBytes() const
+{
+    return m_durable_bytes;
+}
+
+} // namespace OplPcTools
+
+#endif // __OPLPCTOOLS_WRITEBACKFILE__